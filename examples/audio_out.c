@@ -26,6 +26,8 @@
 
 #include <math.h>
 
+#include <time.h>
+
 #include <sndfile.h>
 
 #define	BUFFER_LEN		(2048)
@@ -971,6 +973,95 @@ solaris_close (AUDIO_OUT *audio_out)
 
 #endif /* Solaris */
 
+/*------------------------------------------------------------------------------
+**	Null output, which throws the audio away. It takes it at the pace a sound
+**	card would, or as fast as it comes if the sample rate is zero, and lets
+**	the examples run and be timed without a sound card.
+*/
+
+#define	NULL_MAGIC		MAKE_MAGIC ('N', 'u', 'l', 'l', '-', 'O', 'u', 't')
+
+typedef struct
+{	int magic ;
+	int channels ;
+	int samplerate ;
+	long frames ;
+} NULL_AUDIO_OUT ;
+
+AUDIO_OUT *
+audio_open_null (int channels, int samplerate, long frames)
+{	NULL_AUDIO_OUT *null_out ;
+
+	if ((null_out = calloc (1, sizeof (NULL_AUDIO_OUT))) == NULL)
+	{	perror ("audio_open_null : malloc ") ;
+		exit (1) ;
+		} ;
+
+	null_out->magic = NULL_MAGIC ;
+	null_out->channels = channels ;
+	null_out->samplerate = samplerate ;
+	null_out->frames = frames ;
+
+	return (AUDIO_OUT *) null_out ;
+} /* audio_open_null */
+
+/* Every backend starts with its magic number. */
+static int
+is_null_out (AUDIO_OUT *audio_out)
+{	return audio_out != NULL && ((NULL_AUDIO_OUT *) audio_out)->magic == NULL_MAGIC ;
+} /* is_null_out */
+
+static double
+null_clock (void)
+{
+#if (defined (CLOCK_MONOTONIC) && !defined (_WIN32))
+	struct timespec ts ;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts) ;
+	return ts.tv_sec + 1e-9 * ts.tv_nsec ;
+#else
+	return 0.0 ;
+#endif
+} /* null_clock */
+
+static void
+null_play (get_audio_callback_t callback, AUDIO_OUT *audio_out, void *callback_data)
+{	static float buffer [BUFFER_LEN] ;
+	NULL_AUDIO_OUT *null_out = (NULL_AUDIO_OUT *) audio_out ;
+	double	start, ahead ;
+	long	frames ;
+	int		read_frames ;
+
+	start = null_clock () ;
+
+	for (frames = 0 ; frames < null_out->frames ; frames += read_frames)
+	{	if ((read_frames = callback (callback_data, buffer, BUFFER_LEN / null_out->channels)) == 0)
+			break ;
+
+		if (null_out->samplerate <= 0)
+			continue ;
+
+		/* Wait until a sound card would have played what it holds. */
+		ahead = (1.0 * frames) / null_out->samplerate - (null_clock () - start) ;
+		if (ahead > 0.0)
+#if (defined (_WIN32) || defined (WIN32))
+			Sleep ((DWORD) (1e3 * ahead)) ;
+#else
+			usleep ((useconds_t) (1e6 * ahead)) ;
+#endif
+		} ;
+
+	return ;
+} /* null_play */
+
+static void
+null_close (AUDIO_OUT *audio_out)
+{
+	memset (audio_out, 0, sizeof (NULL_AUDIO_OUT)) ;
+
+	free (audio_out) ;
+} /* null_close */
+
 /*==============================================================================
 **	Main function.
 */
@@ -1020,6 +1111,11 @@ audio_play (get_audio_callback_t callback, AUDIO_OUT *audio_out, void *callback_
 		return ;
 		} ;
 
+	if (is_null_out (audio_out))
+	{	null_play (callback, audio_out, callback_data) ;
+		return ;
+		} ;
+
 #if defined (__linux__)
 	#if HAVE_ALSA
 		if (audio_out->magic == ALSA_MAGIC)
@@ -1045,6 +1141,11 @@ audio_play (get_audio_callback_t callback, AUDIO_OUT *audio_out, void *callback_
 void
 audio_close (AUDIO_OUT *audio_out)
 {
+	if (is_null_out (audio_out))
+	{	null_close (audio_out) ;
+		return ;
+		} ;
+
 #if defined (__linux__)
 	#if HAVE_ALSA
 		if (audio_out->magic == ALSA_MAGIC)
@@ -1080,6 +1181,16 @@ audio_open (int channels, int samplerate)
 	return NULL ;
 } /* audio_open */
 
+AUDIO_OUT *
+audio_open_null (int channels, int samplerate, long frames)
+{
+	(void) channels ;
+	(void) samplerate ;
+	(void) frames ;
+
+	return NULL ;
+} /* audio_open_null */
+
 void
 audio_play (get_audio_callback_t callback, AUDIO_OUT *audio_out, void *callback_data)
 {
@@ -20,6 +20,15 @@ typedef int (*get_audio_callback_t) (void *callback_data, float *samples, int fr
 
 AUDIO_OUT *audio_open (int channels, int samplerate) ;
 
+/*
+** audio_open_null - opens an output that discards the audio, taking it at
+**              the pace of a sound card running at samplerate, or as fast as
+**              the callback supplies it if samplerate is zero. Stops after
+**              the given number of frames.
+*/
+
+AUDIO_OUT *audio_open_null (int channels, int samplerate, long frames) ;
+
 void audio_play (get_audio_callback_t callback, AUDIO_OUT *audio_out, void *callback_data) ;
 
 void audio_close (AUDIO_OUT *audio_data) ;
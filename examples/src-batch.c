@@ -0,0 +1,491 @@
+/*
+** Copyright (c) 2002-2016, Erik de Castro Lopo <erikd@mega-nerd.com>
+** All rights reserved.
+**
+** This code is released under 2-clause BSD license. Please see the
+** file at : https://github.com/libsndfile/libsamplerate/blob/master/COPYING
+*/
+
+/*
+** Convert a whole list of WAV files on a fixed pool of threads. Each worker
+** keeps its converter and buffers from one job to the next, resetting the
+** converter rather than creating a new one, and maps the input of its next
+** job before converting the current one so the kernel reads it in meanwhile.
+*/
+
+#include "src_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if (HAVE_MMAP && HAVE_PTHREAD)
+
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <samplerate.h>
+
+#include "wav_io.h"
+
+#define	DEFAULT_CONVERTER	SRC_SINC_MEDIUM_QUALITY
+
+#define	MAX_THREADS			256
+
+/* Manifest values above this are sample rates rather than ratios. */
+#define	MAX_RATIO			256
+
+/* Input frames per call to src_process (). */
+#define	SLICE_FRAMES		(1 << 16)
+
+typedef struct
+{	char		*in_path, *out_path ;
+	double		ratio ;
+	int			new_rate, converter ;
+
+	WAV_MAP		in ;
+	int			mapped, failed ;
+	int64_t		in_frames, out_frames ;
+	double		seconds ;
+} BATCH_JOB ;
+
+typedef struct
+{	BATCH_JOB	*jobs ;
+	int			job_count, format ;
+
+	pthread_mutex_t	lock ;
+	int			next_job ;
+} BATCH ;
+
+typedef struct
+{	BATCH		*batch ;
+	pthread_t	thread ;
+
+	/* Kept from one job to the next. */
+	SRC_STATE	*state ;
+	int			converter, channels ;
+	float		*in_buffer, *out_buffer ;
+	long		in_len, out_len ;
+} WORKER ;
+
+static void usage_exit (const char *progname) ;
+static int read_manifest (const char *path, int converter, BATCH *batch) ;
+static void *worker_thread (void *arg) ;
+static void report (const BATCH *batch, int threads, double seconds) ;
+static double now (void) ;
+
+int
+main (int argc, char *argv [])
+{	static WORKER workers [MAX_THREADS] ;
+
+	BATCH		batch ;
+	const char	*progname, *cptr ;
+	double		seconds ;
+	int			k, threads = 0, converter = DEFAULT_CONVERTER, failed = 0 ;
+
+	progname = argv [0] ;
+	if ((cptr = strrchr (progname, '/')) != NULL)
+		progname = cptr + 1 ;
+
+	memset (&batch, 0, sizeof (batch)) ;
+
+	for (k = 1 ; k < argc - 1 ; k++)
+	{	if (strcmp (argv [k], "-j") == 0 && k + 1 < argc - 1)
+			threads = atoi (argv [++k]) ;
+		else if (strcmp (argv [k], "-c") == 0 && k + 1 < argc - 1)
+			converter = atoi (argv [++k]) ;
+		else if (strcmp (argv [k], "-f") == 0 && k + 1 < argc - 1)
+		{	if ((batch.format = wav_parse_format (argv [++k])) == 0)
+				usage_exit (progname) ;
+			}
+		else
+			usage_exit (progname) ;
+		} ;
+
+	if (argc < 2 || k != argc - 1 || src_get_name (converter) == NULL)
+		usage_exit (progname) ;
+
+	if (threads <= 0)
+		threads = sysconf (_SC_NPROCESSORS_ONLN) ;
+	if (threads <= 0)
+		threads = 1 ;
+	if (threads > MAX_THREADS)
+		threads = MAX_THREADS ;
+
+	if (read_manifest (argv [argc - 1], converter, &batch) != 0)
+		exit (1) ;
+
+	if (threads > batch.job_count)
+		threads = batch.job_count > 0 ? batch.job_count : 1 ;
+
+	pthread_mutex_init (&batch.lock, NULL) ;
+
+	seconds = now () ;
+
+	for (k = 0 ; k < threads ; k++)
+	{	workers [k].batch = &batch ;
+		if (pthread_create (&workers [k].thread, NULL, worker_thread, &workers [k]) != 0)
+		{	fprintf (stderr, "Error : Not able to start thread %d.\n", k) ;
+			exit (1) ;
+			} ;
+		} ;
+
+	for (k = 0 ; k < threads ; k++)
+		pthread_join (workers [k].thread, NULL) ;
+
+	seconds = now () - seconds ;
+
+	pthread_mutex_destroy (&batch.lock) ;
+
+	report (&batch, threads, seconds) ;
+
+	for (k = 0 ; k < batch.job_count ; k++)
+	{	failed += batch.jobs [k].failed ;
+		free (batch.jobs [k].in_path) ;
+		free (batch.jobs [k].out_path) ;
+		} ;
+	free (batch.jobs) ;
+
+	return failed ? 1 : 0 ;
+} /* main */
+
+/*==============================================================================
+*/
+
+static void
+usage_exit (const char *progname)
+{	const char	*cptr ;
+	int			k ;
+
+	printf ("\n"
+		"  Usage :\n\n"
+		"       %s [options] <manifest>\n"
+		"\n"
+		"  Options :\n\n"
+		"       -j <number>       Worker threads. Default is one per CPU.\n"
+		"       -c <number>       Default converter, see below.\n"
+		"       -f <format>       Output format, 16, 24, 32 or float. Default is\n"
+		"                         the format of each input.\n"
+		"\n"
+		"  Each line of the manifest is one job :\n\n"
+		"       <input> <output> <ratio or new sample rate> [<converter>]\n"
+		"\n"
+		"  where values above %d are taken as a sample rate. Blank lines and\n"
+		"  lines starting with '#' are skipped. Files are WAV, 16, 24 or 32 bit\n"
+		"  PCM or 32 bit float.\n"
+		"\n"
+		"  The converter is one of :\n\n", progname, MAX_RATIO) ;
+
+	for (k = 0 ; (cptr = src_get_name (k)) != NULL ; k++)
+		printf ("       %d : %s%s\n", k, cptr, k == DEFAULT_CONVERTER ? " (default)" : "") ;
+
+	puts ("") ;
+
+	exit (1) ;
+} /* usage_exit */
+
+static int
+read_manifest (const char *path, int converter, BATCH *batch)
+{	char		line [4096], in_path [2048], out_path [2048] ;
+	BATCH_JOB	*job, *jobs ;
+	FILE		*file ;
+	double		value ;
+	int			fields, job_converter, line_number = 0, max_jobs = 0 ;
+
+	if ((file = fopen (path, "r")) == NULL)
+	{	fprintf (stderr, "Error : Not able to open manifest '%s'.\n", path) ;
+		return 1 ;
+		} ;
+
+	while (fgets (line, sizeof (line), file) != NULL)
+	{	line_number ++ ;
+
+		job_converter = converter ;
+		fields = sscanf (line, "%2047s %2047s %lf %d", in_path, out_path, &value, &job_converter) ;
+
+		if (fields <= 0 || in_path [0] == '#')
+			continue ;
+
+		if (fields < 3 || value <= 0.0 || src_get_name (job_converter) == NULL)
+		{	fprintf (stderr, "Error : %s line %d is not a valid job.\n", path, line_number) ;
+			fclose (file) ;
+			return 1 ;
+			} ;
+
+		if (batch->job_count >= max_jobs)
+		{	max_jobs = max_jobs ? 2 * max_jobs : 256 ;
+			if ((jobs = realloc (batch->jobs, max_jobs * sizeof (BATCH_JOB))) == NULL)
+			{	fprintf (stderr, "Error : Out of memory.\n") ;
+				fclose (file) ;
+				return 1 ;
+				} ;
+			batch->jobs = jobs ;
+			} ;
+
+		job = batch->jobs + batch->job_count ++ ;
+		memset (job, 0, sizeof (*job)) ;
+
+		job->in_path = strdup (in_path) ;
+		job->out_path = strdup (out_path) ;
+		job->converter = job_converter ;
+		if (value > MAX_RATIO)
+			job->new_rate = lrint (value) ;
+		else
+			job->ratio = value ;
+		} ;
+
+	fclose (file) ;
+
+	return 0 ;
+} /* read_manifest */
+
+static BATCH_JOB *
+claim_job (BATCH *batch)
+{	BATCH_JOB	*job = NULL ;
+
+	pthread_mutex_lock (&batch->lock) ;
+	if (batch->next_job < batch->job_count)
+		job = batch->jobs + batch->next_job ++ ;
+	pthread_mutex_unlock (&batch->lock) ;
+
+	return job ;
+} /* claim_job */
+
+/* Map the input and have the kernel start reading it. */
+static void
+open_job (BATCH_JOB *job)
+{	double start = now () ;
+
+	if (wav_map (job->in_path, &job->in) != 0)
+		job->failed = 1 ;
+	else
+	{	job->mapped = 1 ;
+		wav_prefetch (&job->in) ;
+		} ;
+
+	job->seconds = now () - start ;
+} /* open_job */
+
+/* Returns an error from src_new () or -1 if out of memory. */
+static int
+prepare_worker (WORKER *worker, int converter, int channels, double ratio)
+{	long	out_len ;
+	int		error ;
+
+	if (worker->state != NULL && worker->converter == converter && worker->channels == channels)
+		src_reset (worker->state) ;
+	else
+	{	src_delete (worker->state) ;
+		if ((worker->state = src_new (converter, channels, &error)) == NULL)
+			return error ;
+		worker->converter = converter ;
+		worker->channels = channels ;
+		} ;
+
+	if (worker->in_len < SLICE_FRAMES * channels)
+	{	free (worker->in_buffer) ;
+		worker->in_len = SLICE_FRAMES * channels ;
+		if ((worker->in_buffer = wav_aligned_alloc (worker->in_len * sizeof (float))) == NULL)
+		{	worker->in_len = 0 ;
+			return -1 ;
+			} ;
+		} ;
+
+	/* Room for all the output of a slice and of the flush at the end. */
+	out_len = (lrint (ceil (SLICE_FRAMES * ratio)) + 4096) * channels ;
+	if (worker->out_len < out_len)
+	{	free (worker->out_buffer) ;
+		worker->out_len = out_len ;
+		if ((worker->out_buffer = wav_aligned_alloc (worker->out_len * sizeof (float))) == NULL)
+		{	worker->out_len = 0 ;
+			return -1 ;
+			} ;
+		} ;
+
+	return 0 ;
+} /* prepare_worker */
+
+static void
+run_job (WORKER *worker, BATCH_JOB *job)
+{	const WAV_MAP *in = &job->in ;
+	WAV_WRITER	*out ;
+	SRC_DATA	data ;
+	double		start = now (), ratio = job->ratio ;
+	int64_t		in_pos = 0 ;
+	int			new_rate = job->new_rate, error ;
+
+	if (job->mapped == 0)
+		return ;
+
+	if (new_rate > 0)
+		ratio = (1.0 * new_rate) / in->samplerate ;
+	else
+		new_rate = lrint (in->samplerate * ratio) ;
+
+	if (src_is_valid_ratio (ratio) == 0 || new_rate < 1)
+	{	fprintf (stderr, "Error : %s : Sample rate change out of valid range.\n", job->in_path) ;
+		job->failed = 1 ;
+		goto done ;
+		} ;
+
+	if ((error = prepare_worker (worker, job->converter, in->channels, ratio)) != 0)
+	{	fprintf (stderr, "Error : %s : %s\n", job->in_path, error < 0 ? "Out of memory." : src_strerror (error)) ;
+		job->failed = 1 ;
+		goto done ;
+		} ;
+
+	if ((out = wav_create (job->out_path, in->channels, new_rate, worker->batch->format ? worker->batch->format : in->format)) == NULL)
+	{	job->failed = 1 ;
+		goto done ;
+		} ;
+
+	memset (&data, 0, sizeof (data)) ;
+	data.src_ratio = ratio ;
+	data.data_out = worker->out_buffer ;
+	data.output_frames = worker->out_len / in->channels ;
+
+	for (;;)
+	{	data.input_frames = SLICE_FRAMES ;
+		if (data.input_frames > in->frames - in_pos)
+			data.input_frames = in->frames - in_pos ;
+		data.end_of_input = (in_pos + data.input_frames >= in->frames) ;
+
+		if ((data.data_in = wav_float_frames (in, in_pos)) == NULL)
+		{	wav_read_float (in, in_pos, data.input_frames, worker->in_buffer) ;
+			data.data_in = worker->in_buffer ;
+			} ;
+
+		if ((error = src_process (worker->state, &data)) != 0)
+		{	fprintf (stderr, "Error : %s : %s\n", job->in_path, src_strerror (error)) ;
+			job->failed = 1 ;
+			break ;
+			} ;
+
+		if (wav_write_float (out, worker->out_buffer, data.output_frames_gen) != 0)
+		{	fprintf (stderr, "Error : %s : Write failed.\n", job->out_path) ;
+			job->failed = 1 ;
+			break ;
+			} ;
+
+		in_pos += data.input_frames_used ;
+		job->out_frames += data.output_frames_gen ;
+
+		if (data.end_of_input && data.input_frames_used == data.input_frames && data.output_frames_gen == 0)
+			break ;
+		} ;
+
+	if (wav_close (out) != 0 && job->failed == 0)
+	{	fprintf (stderr, "Error : %s : Write failed.\n", job->out_path) ;
+		job->failed = 1 ;
+		} ;
+
+	job->in_frames = in_pos ;
+
+done :
+	wav_unmap (&job->in) ;
+	job->mapped = 0 ;
+	job->seconds += now () - start ;
+} /* run_job */
+
+static void *
+worker_thread (void *arg)
+{	WORKER		*worker = arg ;
+	BATCH_JOB	*job, *next ;
+
+	if ((job = claim_job (worker->batch)) != NULL)
+		open_job (job) ;
+
+	while (job != NULL)
+	{	/* Start the next input coming in while this one converts. */
+		if ((next = claim_job (worker->batch)) != NULL)
+			open_job (next) ;
+
+		run_job (worker, job) ;
+		job = next ;
+		} ;
+
+	src_delete (worker->state) ;
+	free (worker->in_buffer) ;
+	free (worker->out_buffer) ;
+
+	return NULL ;
+} /* worker_thread */
+
+static int
+compare_double (const void *a, const void *b)
+{	double x = *((const double *) a), y = *((const double *) b) ;
+
+	return (x > y) - (x < y) ;
+} /* compare_double */
+
+/* Nearest rank percentile of sorted values. */
+static double
+percentile (const double *values, int count, double fraction)
+{	int index = (int) ceil (fraction * count) - 1 ;
+
+	return values [index < 0 ? 0 : index] ;
+} /* percentile */
+
+static void
+report (const BATCH *batch, int threads, double seconds)
+{	double		*latency ;
+	int64_t		in_frames = 0, out_frames = 0 ;
+	int			k, done = 0 ;
+
+	if ((latency = calloc (batch->job_count + 1, sizeof (double))) == NULL)
+		return ;
+
+	for (k = 0 ; k < batch->job_count ; k++)
+	{	if (batch->jobs [k].failed)
+			continue ;
+		latency [done ++] = batch->jobs [k].seconds ;
+		in_frames += batch->jobs [k].in_frames ;
+		out_frames += batch->jobs [k].out_frames ;
+		} ;
+
+	qsort (latency, done, sizeof (double), compare_double) ;
+
+	printf ("Jobs          : %d done, %d failed\n", done, batch->job_count - done) ;
+	printf ("Threads       : %d\n", threads) ;
+	printf ("Time          : %.3f seconds\n", seconds) ;
+	printf ("Frames        : %lld in, %lld out\n", (long long) in_frames, (long long) out_frames) ;
+
+	if (seconds > 0.0)
+		printf ("Throughput    : %.2f M input frames/sec, %.1f files/sec\n", 1e-6 * in_frames / seconds, done / seconds) ;
+
+	if (done > 0)
+		printf ("Job latency   : p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+			1e3 * percentile (latency, done, 0.50), 1e3 * percentile (latency, done, 0.90),
+			1e3 * percentile (latency, done, 0.99), 1e3 * latency [done - 1]) ;
+
+	free (latency) ;
+} /* report */
+
+static double
+now (void)
+{	struct timespec ts ;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts) ;
+
+	return ts.tv_sec + 1e-9 * ts.tv_nsec ;
+} /* now */
+
+#else
+
+int
+main (void)
+{
+	puts (
+		"\n"
+		"****************************************************************\n"
+		"  This example program needs mmap () and POSIX threads, which\n"
+		"  this platform does not seem to have.\n"
+		"****************************************************************\n"
+		) ;
+
+	return 0 ;
+} /* main */
+
+#endif
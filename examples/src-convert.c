@@ -0,0 +1,281 @@
+/*
+** Copyright (c) 2002-2016, Erik de Castro Lopo <erikd@mega-nerd.com>
+** All rights reserved.
+**
+** This code is released under 2-clause BSD license. Please see the
+** file at : https://github.com/libsndfile/libsamplerate/blob/master/COPYING
+*/
+
+/*
+** Sample rate convert WAV or raw files without libsndfile. The input is
+** memory mapped and handed to src_process () in large slices, straight out
+** of the mapping when it already holds native floats, so the converter reads
+** the file's pages directly.
+*/
+
+#include "src_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if (HAVE_MMAP)
+
+#include <time.h>
+
+#include <samplerate.h>
+
+#include "wav_io.h"
+
+#define	DEFAULT_CONVERTER	SRC_SINC_MEDIUM_QUALITY
+
+/* Input frames per call to src_process (). */
+#define	SLICE_FRAMES		(1 << 16)
+
+typedef struct
+{	int64_t		in_frames, out_frames ;
+	double		seconds ;
+} CONVERT_STATS ;
+
+static void usage_exit (const char *progname) ;
+static int convert (const WAV_MAP *in, WAV_WRITER *out, int converter, double ratio, CONVERT_STATS *stats) ;
+static double now (void) ;
+
+int
+main (int argc, char *argv [])
+{	WAV_MAP		in ;
+	WAV_WRITER	*out ;
+	CONVERT_STATS stats ;
+	const char	*progname, *cptr ;
+	double		ratio = 0.0 ;
+	int			k, converter = DEFAULT_CONVERTER, new_rate = 0, format = 0, quiet = 0 ;
+	int			raw_channels = 0, raw_rate = 0, raw_format = 0 ;
+
+	progname = argv [0] ;
+	if ((cptr = strrchr (progname, '/')) != NULL)
+		progname = cptr + 1 ;
+
+	if (argc < 5)
+		usage_exit (progname) ;
+
+	for (k = 1 ; k < argc - 2 ; k++)
+	{	if (strcmp (argv [k], "-to") == 0 && k + 1 < argc - 2)
+			new_rate = atoi (argv [++k]) ;
+		else if (strcmp (argv [k], "-by") == 0 && k + 1 < argc - 2)
+			ratio = atof (argv [++k]) ;
+		else if (strcmp (argv [k], "-c") == 0 && k + 1 < argc - 2)
+			converter = atoi (argv [++k]) ;
+		else if (strcmp (argv [k], "-f") == 0 && k + 1 < argc - 2)
+		{	if ((format = wav_parse_format (argv [++k])) == 0)
+				usage_exit (progname) ;
+			}
+		else if (strcmp (argv [k], "-raw") == 0 && k + 3 < argc - 2)
+		{	raw_channels = atoi (argv [++k]) ;
+			raw_rate = atoi (argv [++k]) ;
+			if ((raw_format = wav_parse_format (argv [++k])) == 0)
+				usage_exit (progname) ;
+			}
+		else if (strcmp (argv [k], "-q") == 0)
+			quiet = 1 ;
+		else
+			usage_exit (progname) ;
+		} ;
+
+	if ((new_rate > 0) == (ratio > 0.0) || src_get_name (converter) == NULL)
+		usage_exit (progname) ;
+
+	if (raw_format != 0)
+	{	if (wav_map_raw (argv [argc - 2], raw_channels, raw_rate, raw_format, &in) != 0)
+			exit (1) ;
+		}
+	else if (wav_map (argv [argc - 2], &in) != 0)
+		exit (1) ;
+
+	if (new_rate > 0)
+		ratio = (1.0 * new_rate) / in.samplerate ;
+	else
+		new_rate = lrint (in.samplerate * ratio) ;
+
+	if (src_is_valid_ratio (ratio) == 0 || new_rate < 1)
+	{	fprintf (stderr, "Error : Sample rate change out of valid range.\n") ;
+		exit (1) ;
+		} ;
+
+	if (format == 0)
+		format = in.format ;
+
+	if (quiet == 0)
+	{	printf ("Input File    : %s\n", argv [argc - 2]) ;
+		printf ("Sample Rate   : %d\n", in.samplerate) ;
+		printf ("Channels      : %d\n", in.channels) ;
+		printf ("Input Format  : %s\n", wav_format_name (in.format)) ;
+		printf ("Input Frames  : %lld\n", (long long) in.frames) ;
+		printf ("Output File   : %s\n", argv [argc - 1]) ;
+		printf ("Sample Rate   : %d\n", new_rate) ;
+		printf ("Output Format : %s\n", wav_format_name (format)) ;
+		printf ("Converter     : %s\n", src_get_name (converter)) ;
+		} ;
+
+	if ((out = wav_create (argv [argc - 1], in.channels, new_rate, format)) == NULL)
+	{	wav_unmap (&in) ;
+		exit (1) ;
+		} ;
+
+	if (convert (&in, out, converter, ratio, &stats) != 0 || wav_close (out) != 0)
+	{	fprintf (stderr, "Error : Conversion of '%s' failed.\n", argv [argc - 2]) ;
+		wav_unmap (&in) ;
+		exit (1) ;
+		} ;
+
+	if (quiet == 0)
+	{	printf ("Output Frames : %lld\n", (long long) stats.out_frames) ;
+		printf ("Time          : %.3f seconds\n", stats.seconds) ;
+		if (stats.seconds > 0.0)
+			printf ("Throughput    : %.2f M input frames/sec, %.1f x realtime, %.1f MB/s read\n",
+				1e-6 * stats.in_frames / stats.seconds,
+				stats.in_frames / (1.0 * in.samplerate) / stats.seconds,
+				1e-6 * stats.in_frames * in.channels * wav_sample_bytes (in.format) / stats.seconds) ;
+		} ;
+
+	wav_unmap (&in) ;
+
+	return 0 ;
+} /* main */
+
+/*==============================================================================
+*/
+
+static void
+usage_exit (const char *progname)
+{	const char	*cptr ;
+	int			k ;
+
+	printf ("\n"
+		"  Usage :\n\n"
+		"       %s [options] -to <new sample rate> <input file> <output file>\n"
+		"       %s [options] -by <ratio> <input file> <output file>\n"
+		"\n"
+		"  Options :\n\n"
+		"       -c <number>       Converter, see below.\n"
+		"       -f <format>       Output format, 16, 24, 32 or float. Default is\n"
+		"                         the input format.\n"
+		"       -raw <channels> <rate> <format>\n"
+		"                         Input is headerless little endian samples.\n"
+		"       -q                Quiet, print errors only.\n"
+		"\n"
+		"  Input files are WAV, 16, 24 or 32 bit PCM or 32 bit float. Output\n"
+		"  files are WAV.\n"
+		"\n"
+		"  The converter is one of :\n\n", progname, progname) ;
+
+	for (k = 0 ; (cptr = src_get_name (k)) != NULL ; k++)
+		printf ("       %d : %s%s\n", k, cptr, k == DEFAULT_CONVERTER ? " (default)" : "") ;
+
+	puts ("") ;
+
+	exit (1) ;
+} /* usage_exit */
+
+static int
+convert (const WAV_MAP *in, WAV_WRITER *out, int converter, double ratio, CONVERT_STATS *stats)
+{	SRC_STATE	*state ;
+	SRC_DATA	data ;
+	float		*in_buffer, *out_buffer ;
+	long		out_len ;
+	int64_t		in_pos = 0 ;
+	int			error = 0 ;
+
+	memset (stats, 0, sizeof (*stats)) ;
+
+	if ((state = src_new (converter, in->channels, &error)) == NULL)
+	{	fprintf (stderr, "Error : src_new () failed : %s\n", src_strerror (error)) ;
+		return 1 ;
+		} ;
+
+	/* Room for all the output of a slice and of the flush at the end. */
+	out_len = lrint (ceil (SLICE_FRAMES * ratio)) + 4096 ;
+
+	in_buffer = wav_aligned_alloc (SLICE_FRAMES * in->channels * sizeof (float)) ;
+	out_buffer = wav_aligned_alloc (out_len * in->channels * sizeof (float)) ;
+
+	if (in_buffer == NULL || out_buffer == NULL)
+	{	fprintf (stderr, "Error : Out of memory.\n") ;
+		free (in_buffer) ;
+		free (out_buffer) ;
+		src_delete (state) ;
+		return 1 ;
+		} ;
+
+	memset (&data, 0, sizeof (data)) ;
+	data.src_ratio = ratio ;
+	data.data_out = out_buffer ;
+	data.output_frames = out_len ;
+
+	stats->seconds = now () ;
+
+	for (;;)
+	{	data.input_frames = SLICE_FRAMES ;
+		if (data.input_frames > in->frames - in_pos)
+			data.input_frames = in->frames - in_pos ;
+		data.end_of_input = (in_pos + data.input_frames >= in->frames) ;
+
+		/* Zero copy where the file holds native floats. */
+		if ((data.data_in = wav_float_frames (in, in_pos)) == NULL)
+		{	wav_read_float (in, in_pos, data.input_frames, in_buffer) ;
+			data.data_in = in_buffer ;
+			} ;
+
+		if ((error = src_process (state, &data)) != 0)
+		{	fprintf (stderr, "Error : src_process () failed : %s\n", src_strerror (error)) ;
+			break ;
+			} ;
+
+		if ((error = wav_write_float (out, out_buffer, data.output_frames_gen)) != 0)
+		{	fprintf (stderr, "Error : Write failed.\n") ;
+			break ;
+			} ;
+
+		in_pos += data.input_frames_used ;
+		stats->out_frames += data.output_frames_gen ;
+
+		if (data.end_of_input && data.input_frames_used == data.input_frames && data.output_frames_gen == 0)
+			break ;
+		} ;
+
+	stats->seconds = now () - stats->seconds ;
+	stats->in_frames = in_pos ;
+
+	free (in_buffer) ;
+	free (out_buffer) ;
+	src_delete (state) ;
+
+	return error ;
+} /* convert */
+
+static double
+now (void)
+{	struct timespec ts ;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts) ;
+
+	return ts.tv_sec + 1e-9 * ts.tv_nsec ;
+} /* now */
+
+#else
+
+int
+main (void)
+{
+	puts (
+		"\n"
+		"****************************************************************\n"
+		"  This example program needs mmap (), which this platform does\n"
+		"  not seem to have.\n"
+		"****************************************************************\n"
+		) ;
+
+	return 0 ;
+} /* main */
+
+#endif
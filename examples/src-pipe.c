@@ -0,0 +1,273 @@
+/*
+** Copyright (c) 2002-2016, Erik de Castro Lopo <erikd@mega-nerd.com>
+** All rights reserved.
+**
+** This code is released under 2-clause BSD license. Please see the
+** file at : https://github.com/libsndfile/libsamplerate/blob/master/COPYING
+*/
+
+/*
+** Sample rate convert a raw stream from stdin to stdout, for use in the
+** middle of a shell pipeline, eg :
+**
+**     sox in.flac -t raw -e float - | src-pipe -to 48000 2 44100 float | ...
+**
+** Input is pulled through the callback interface in large reads. Only a fixed
+** window is ever held in memory, so streams can be any length. Buffers are
+** page aligned and whole pages are written wherever possible, which suits
+** pipes and splice ().
+*/
+
+#include "src_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if (HAVE_MMAP)
+
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <samplerate.h>
+
+#include "wav_io.h"
+
+#define	DEFAULT_CONVERTER	SRC_SINC_MEDIUM_QUALITY
+
+/* Frames per read from stdin and per src_callback_read (). */
+#define	READ_FRAMES			(1 << 16)
+#define	WRITE_FRAMES		(1 << 16)
+
+typedef struct
+{	int			fd, channels, format, frame_bytes ;
+	int			eof, error ;
+
+	unsigned char	*raw ;
+	size_t		raw_len, raw_used ;
+	float		*buffer ;
+
+	int64_t		frames ;
+} PIPE_INPUT ;
+
+static void usage_exit (const char *progname) ;
+static long input_callback (void *cb_data, float **data) ;
+static double now (void) ;
+
+int
+main (int argc, char *argv [])
+{	PIPE_INPUT	input ;
+	SRC_STATE	*state ;
+	WAV_WRITER	*out ;
+	float		*out_buffer ;
+	const char	*progname, *cptr ;
+	double		ratio = 0.0, seconds ;
+	int64_t		out_frames = 0 ;
+	long		gen ;
+	int			k, converter = DEFAULT_CONVERTER, new_rate = 0, format = 0, verbose = 0 ;
+	int			channels, samplerate, error ;
+
+	progname = argv [0] ;
+	if ((cptr = strrchr (progname, '/')) != NULL)
+		progname = cptr + 1 ;
+
+	if (argc < 6)
+		usage_exit (progname) ;
+
+	for (k = 1 ; k < argc - 3 ; k++)
+	{	if (strcmp (argv [k], "-to") == 0 && k + 1 < argc - 3)
+			new_rate = atoi (argv [++k]) ;
+		else if (strcmp (argv [k], "-by") == 0 && k + 1 < argc - 3)
+			ratio = atof (argv [++k]) ;
+		else if (strcmp (argv [k], "-c") == 0 && k + 1 < argc - 3)
+			converter = atoi (argv [++k]) ;
+		else if (strcmp (argv [k], "-f") == 0 && k + 1 < argc - 3)
+		{	if ((format = wav_parse_format (argv [++k])) == 0)
+				usage_exit (progname) ;
+			}
+		else if (strcmp (argv [k], "-v") == 0)
+			verbose = 1 ;
+		else
+			usage_exit (progname) ;
+		} ;
+
+	memset (&input, 0, sizeof (input)) ;
+
+	channels = atoi (argv [argc - 3]) ;
+	samplerate = atoi (argv [argc - 2]) ;
+	input.format = wav_parse_format (argv [argc - 1]) ;
+
+	if ((new_rate > 0) == (ratio > 0.0) || src_get_name (converter) == NULL
+			|| channels < 1 || samplerate < 1 || input.format == 0)
+		usage_exit (progname) ;
+
+	if (new_rate > 0)
+		ratio = (1.0 * new_rate) / samplerate ;
+
+	if (src_is_valid_ratio (ratio) == 0)
+	{	fprintf (stderr, "Error : Sample rate change out of valid range.\n") ;
+		exit (1) ;
+		} ;
+
+	if (format == 0)
+		format = input.format ;
+
+	input.fd = 0 ;
+	input.channels = channels ;
+	input.frame_bytes = channels * wav_sample_bytes (input.format) ;
+	input.raw_len = (size_t) READ_FRAMES * input.frame_bytes ;
+	input.raw = wav_aligned_alloc (input.raw_len) ;
+	input.buffer = wav_aligned_alloc ((size_t) READ_FRAMES * channels * sizeof (float)) ;
+	out_buffer = wav_aligned_alloc ((size_t) WRITE_FRAMES * channels * sizeof (float)) ;
+
+	if (input.raw == NULL || input.buffer == NULL || out_buffer == NULL
+			|| (out = wav_create_raw (1, channels, format)) == NULL)
+	{	fprintf (stderr, "Error : Out of memory.\n") ;
+		exit (1) ;
+		} ;
+
+	if ((state = src_callback_new (input_callback, converter, channels, &error, &input)) == NULL)
+	{	fprintf (stderr, "Error : src_callback_new () failed : %s\n", src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	seconds = now () ;
+
+	while ((gen = src_callback_read (state, ratio, WRITE_FRAMES, out_buffer)) > 0)
+	{	if (wav_write_float (out, out_buffer, gen) != 0)
+			break ;
+		out_frames += gen ;
+		} ;
+
+	error = src_error (state) ;
+	state = src_delete (state) ;
+
+	if (error != 0)
+		fprintf (stderr, "Error : %s\n", src_strerror (error)) ;
+
+	if (wav_close (out) != 0)
+	{	fprintf (stderr, "Error : Write to stdout failed : %s\n", strerror (errno)) ;
+		error = 1 ;
+		} ;
+
+	if (input.error)
+		error = 1 ;
+
+	seconds = now () - seconds ;
+
+	if (verbose)
+	{	fprintf (stderr, "%s : %lld frames in, %lld frames out, %.3f seconds", progname,
+					(long long) input.frames, (long long) out_frames, seconds) ;
+		if (seconds > 0.0)
+			fprintf (stderr, ", %.1f x realtime", input.frames / (1.0 * samplerate) / seconds) ;
+		fputs ("\n", stderr) ;
+		} ;
+
+	free (input.raw) ;
+	free (input.buffer) ;
+	free (out_buffer) ;
+
+	return error ? 1 : 0 ;
+} /* main */
+
+/*==============================================================================
+*/
+
+static void
+usage_exit (const char *progname)
+{	const char	*cptr ;
+	int			k ;
+
+	fprintf (stderr, "\n"
+		"  Usage :\n\n"
+		"       %s [options] -to <new sample rate> <channels> <sample rate> <format>\n"
+		"       %s [options] -by <ratio> <channels> <sample rate> <format>\n"
+		"\n"
+		"  Reads headerless little endian samples of the given layout from stdin\n"
+		"  and writes the converted stream to stdout. The format is one of 16,\n"
+		"  24, 32 or float.\n"
+		"\n"
+		"  Options :\n\n"
+		"       -c <number>       Converter, see below.\n"
+		"       -f <format>       Output format. Default is the input format.\n"
+		"       -v                Print a summary to stderr at the end.\n"
+		"\n"
+		"  The converter is one of :\n\n", progname, progname) ;
+
+	for (k = 0 ; (cptr = src_get_name (k)) != NULL ; k++)
+		fprintf (stderr, "       %d : %s%s\n", k, cptr, k == DEFAULT_CONVERTER ? " (default)" : "") ;
+
+	fputs ("\n", stderr) ;
+
+	exit (1) ;
+} /* usage_exit */
+
+static long
+input_callback (void *cb_data, float **data)
+{	PIPE_INPUT	*input = cb_data ;
+	ssize_t		count ;
+	long		frames ;
+
+	/* Fill the whole window, a pipe hands over a page or so per read. */
+	while (input->eof == 0 && input->raw_used < input->raw_len)
+	{	count = read (input->fd, input->raw + input->raw_used, input->raw_len - input->raw_used) ;
+
+		if (count > 0)
+			input->raw_used += count ;
+		else if (count == 0)
+			input->eof = 1 ;
+		else if (errno != EINTR)
+		{	fprintf (stderr, "Error : Read from stdin failed : %s\n", strerror (errno)) ;
+			input->eof = input->error = 1 ;
+			} ;
+		} ;
+
+	frames = input->raw_used / input->frame_bytes ;
+
+	if (frames == 0)
+	{	if (input->raw_used > 0)
+			fprintf (stderr, "Warning : Dropped %ld bytes of a part frame at the end of the input.\n", (long) input->raw_used) ;
+		input->raw_used = 0 ;
+		return 0 ;
+		} ;
+
+	wav_decode_float (input->raw, input->format, frames * input->channels, input->buffer) ;
+
+	/* Keep any part frame for next time. */
+	input->raw_used -= frames * input->frame_bytes ;
+	memmove (input->raw, input->raw + frames * input->frame_bytes, input->raw_used) ;
+
+	input->frames += frames ;
+	*data = input->buffer ;
+
+	return frames ;
+} /* input_callback */
+
+static double
+now (void)
+{	struct timespec ts ;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts) ;
+
+	return ts.tv_sec + 1e-9 * ts.tv_nsec ;
+} /* now */
+
+#else
+
+int
+main (void)
+{
+	puts (
+		"\n"
+		"****************************************************************\n"
+		"  This example program needs POSIX I/O, which this platform does\n"
+		"  not seem to have.\n"
+		"****************************************************************\n"
+		) ;
+
+	return 0 ;
+} /* main */
+
+#endif
@@ -10,6 +10,8 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <signal.h>
+#include <time.h>
 #include <math.h>
 
 #include "src_config.h"
@@ -26,6 +28,9 @@
 #define	BUFFER_LEN			4096
 #define	VARISPEED_BLOCK_LEN	64
 
+/* Callback times are binned in powers of two microseconds. */
+#define	HISTOGRAM_LEN		14
+
 #define	MIN(a,b)		((a) < (b) ? (a) : (b))
 
 #define	SRC_MAGIC		((int) ('S' << 16) + ('R' << 8) + ('C'))
@@ -44,6 +49,14 @@ typedef struct
 	float		buffer	[BUFFER_LEN] ;
 } SNDFILE_CB_DATA ;
 
+typedef struct
+{	long		callbacks, frames ;
+	long		xruns, xrun_frames ;
+	long		late ;
+	double		max_seconds ;
+	long		histogram [HISTOGRAM_LEN + 1] ;
+} PLAY_STATS ;
+
 typedef struct
 {	int			magic ;
 
@@ -53,16 +66,31 @@ typedef struct
 
 	SRC_STATE	*src_state ;
 
+	/* Filled in by the audio callback, printed once playing stops. */
+	PLAY_STATS	stats ;
+
 } SRC_CB_DATA ;
 
 static int varispeed_get_data (SRC_CB_DATA *data, float *samples, int frames) ;
-static void varispeed_play (const char *filename, int converter) ;
+static void varispeed_play (const char *filename, int converter, double null_seconds) ;
+static void print_stats (const SRC_CB_DATA *data, double seconds) ;
 
 static long src_input_callback (void *cb_data, float **data) ;
 
+static double now (void) ;
+
+static volatile sig_atomic_t stop_playing = 0 ;
+
+static void
+stop_handler (int sig)
+{	(void) sig ;
+	stop_playing = 1 ;
+} /* stop_handler */
+
 int
 main (int argc, char *argv [])
-{	const char	*cptr, *progname, *filename ;
+{	const char	*cptr, *progname, *filename = NULL ;
+	double		null_seconds = 0.0 ;
 	int			k, converter ;
 
 	converter = SRC_SINC_FASTEST ;
@@ -85,15 +113,24 @@ main (int argc, char *argv [])
 		"  vari-speeding and libsndfile for file I/O.\n"
 		"\n", progname) ;
 
-	if (argc == 2)
-		filename = argv [1] ;
-	else if (argc == 4 && strcmp (argv [1], "-c") == 0)
-	{	filename = argv [3] ;
-		converter = atoi (argv [2]) ;
-		}
-	else
-	{	printf ("  Usage :\n\n       %s [-c <number>] <input file>\n\n", progname) ;
+	for (k = 1 ; k < argc - 1 ; k++)
+	{	if (strcmp (argv [k], "-c") == 0 && k + 1 < argc - 1)
+			converter = atoi (argv [++k]) ;
+		else if (strcmp (argv [k], "-null") == 0 && k + 1 < argc - 1)
+			null_seconds = atof (argv [++k]) ;
+		else
+			break ;
+		} ;
+
+	if (argc >= 2 && k == argc - 1)
+		filename = argv [argc - 1] ;
+
+	if (filename == NULL || src_get_name (converter) == NULL || null_seconds < 0.0)
+	{	printf ("  Usage :\n\n       %s [-c <number>] [-null <seconds>] <input file>\n\n", progname) ;
 		puts (
+			"  The optional -null argument plays the given number of seconds to a\n"
+			"  null output, paced like a sound card, for timing without one.\n"
+			"\n"
 			"  The optional -c argument allows the converter type to be chosen from\n"
 			"  the following list :"
 			"\n"
@@ -106,7 +143,7 @@ main (int argc, char *argv [])
 		exit (1) ;
 		} ;
 
-	varispeed_play (filename, converter) ;
+	varispeed_play (filename, converter, null_seconds) ;
 
 	return 0 ;
 } /* main */
@@ -115,9 +152,11 @@ main (int argc, char *argv [])
 */
 
 static void
-varispeed_play (const char *filename, int converter)
+varispeed_play (const char *filename, int converter, double null_seconds)
 {	SRC_CB_DATA		data ;
+	SRC_ASYNC_CONFIG async ;
 	AUDIO_OUT		*audio_out ;
+	double			seconds ;
 	int				error ;
 
 	memset (&data, 0, sizeof (data)) ;
@@ -136,6 +175,15 @@ varispeed_play (const char *filename, int converter)
 		exit (1) ;
 		} ;
 
+	/*
+	** Decode on the converter's read-ahead thread into a half second ring,
+	** so the audio callback only ever resamples what is already in memory.
+	*/
+	memset (&async, 0, sizeof (async)) ;
+	async.ring_frames = data.sf.sfinfo.samplerate / 2 ;
+	if ((error = src_callback_set_async (data.src_state, &async)) != 0)
+		printf ("  Warning : No read-ahead (%s), decoding in the audio callback.\n\n", src_strerror (error)) ;
+
 	printf (
 
 		"  Playing   : %s\n"
@@ -145,18 +193,29 @@ varispeed_play (const char *filename, int converter)
 		"\n",
 		filename, src_get_name (converter)) ;
 
-	if ((audio_out = audio_open (data.sf.sfinfo.channels, data.sf.sfinfo.samplerate)) == NULL)
+	if (null_seconds > 0.0)
+		audio_out = audio_open_null (data.sf.sfinfo.channels, data.sf.sfinfo.samplerate, lrint (null_seconds * data.sf.sfinfo.samplerate)) ;
+	else
+		audio_out = audio_open (data.sf.sfinfo.channels, data.sf.sfinfo.samplerate) ;
+
+	if (audio_out == NULL)
 	{	printf ("\n\nError : audio_open () failed.\n") ;
 		exit (1) ;
 		} ;
 
+	signal (SIGINT, stop_handler) ;
+
 	/* Pass the data and the callbacl function to audio_play */
+	seconds = now () ;
 	audio_play ((get_audio_callback_t) varispeed_get_data, audio_out, &data) ;
+	seconds = now () - seconds ;
+
+	print_stats (&data, seconds) ;
 
 	/* Cleanup */
 	audio_close (audio_out) ;
-	sf_close (data.sf.sndfile) ;
 	src_delete (data.src_state) ;
+	sf_close (data.sf.sndfile) ;
 
 } /* varispeed_play */
 
@@ -191,32 +250,114 @@ src_input_callback (void *cb_data, float **audio)
 /*==============================================================================
 */
 
+/*
+** The audio callback. It must not block, so no printing, no allocation and
+** no file reads; input comes from the read-ahead ring and anything the ring
+** can not supply in time is played as silence and counted as an xrun.
+*/
 static int
 varispeed_get_data (SRC_CB_DATA *data, float *samples, int out_frames)
-{	float	*output ;
-	int		rc, out_frame_count ;
+{	PLAY_STATS	*stats = &data->stats ;
+	const int	channels = data->sf.sfinfo.channels ;
+	float	*output ;
+	double	start, seconds ;
+	long	rc, want ;
+	int		out_frame_count, bin ;
 
-	if (data->magic != SRC_MAGIC)
-	{	printf ("\n\n%s:%d Eeeek, something really bad happened!\n", __FILE__, __LINE__) ;
-		exit (1) ;
-		} ;
+	if (stop_playing)
+		return 0 ;
+
+	start = now () ;
 
-	for (out_frame_count = 0 ; out_frame_count < out_frames ; out_frame_count += VARISPEED_BLOCK_LEN)
+	for (out_frame_count = 0 ; out_frame_count < out_frames ; out_frame_count += rc)
 	{	double	src_ratio = 1.0 - 0.5 * sin (data->freq_point * 2 * M_PI / 20000) ;
 
 		data->freq_point ++ ;
 
-		output = samples + out_frame_count * data->sf.sfinfo.channels ;
+		output = samples + out_frame_count * channels ;
+		want = MIN (VARISPEED_BLOCK_LEN, out_frames - out_frame_count) ;
 
-		if ((rc = src_callback_read (data->src_state, src_ratio, VARISPEED_BLOCK_LEN, output)) < VARISPEED_BLOCK_LEN)
-		{	printf ("\nError : src_callback_read short output (%d instead of %d)\n\n", rc, VARISPEED_BLOCK_LEN) ;
-			exit (1) ;
+		/* Short of the read-ahead, or -1 when it had nothing at all, play silence. */
+		if ((rc = src_callback_read (data->src_state, src_ratio, want, output)) < want)
+		{	out_frame_count += rc > 0 ? rc : 0 ;
+			memset (samples + out_frame_count * channels, 0, (out_frames - out_frame_count) * channels * sizeof (float)) ;
+			stats->xruns ++ ;
+			stats->xrun_frames += out_frames - out_frame_count ;
+			break ;
 			} ;
 		} ;
 
+	seconds = now () - start ;
+
+	stats->callbacks ++ ;
+	stats->frames += out_frames ;
+
+	if (seconds > stats->max_seconds)
+		stats->max_seconds = seconds ;
+
+	/* Late if the callback took longer than the audio it produced lasts. */
+	if (seconds * data->sf.sfinfo.samplerate > out_frames)
+		stats->late ++ ;
+
+	for (bin = 0 ; bin < HISTOGRAM_LEN && seconds >= 1e-6 * (1 << bin) ; bin++)
+		;
+	stats->histogram [bin] ++ ;
+
 	return out_frames ;
 } /* varispeed_get_data */
 
+static void
+print_stats (const SRC_CB_DATA *data, double seconds)
+{	const PLAY_STATS *stats = &data->stats ;
+	SRC_ASYNC_STATS	async ;
+	int		bin ;
+
+	if (stats->callbacks == 0)
+		return ;
+
+	printf ("\n"
+		"  Callbacks : %ld, %ld frames each, %.2f ms of audio\n"
+		"  Xruns     : %ld, %ld frames of silence\n"
+		"  Late      : %ld callbacks took longer than their audio lasts\n"
+		"  Slowest   : %.3f ms\n",
+		stats->callbacks, stats->frames / stats->callbacks,
+		1e3 * stats->frames / stats->callbacks / data->sf.sfinfo.samplerate,
+		stats->xruns, stats->xrun_frames, stats->late, 1e3 * stats->max_seconds) ;
+
+	if (src_callback_get_async_stats (data->src_state, &async) == 0)
+		printf ("  Ring      : %ld underruns, lowest fill %ld frames\n", async.underruns, async.min_fill) ;
+
+	if (seconds > 0.0)
+		printf ("  Played    : %.2f seconds of audio in %.2f seconds\n",
+			(1.0 * stats->frames) / data->sf.sfinfo.samplerate, seconds) ;
+
+	puts ("\n  Callback time :\n") ;
+
+	for (bin = 0 ; bin <= HISTOGRAM_LEN ; bin++)
+	{	if (stats->histogram [bin] == 0)
+			continue ;
+		if (bin < HISTOGRAM_LEN)
+			printf ("      < %6d us : %ld\n", 1 << bin, stats->histogram [bin]) ;
+		else
+			printf ("     >= %6d us : %ld\n", 1 << HISTOGRAM_LEN, stats->histogram [bin]) ;
+		} ;
+
+	puts ("") ;
+} /* print_stats */
+
+static double
+now (void)
+{	struct timespec ts ;
+
+#ifdef CLOCK_MONOTONIC
+	clock_gettime (CLOCK_MONOTONIC, &ts) ;
+#else
+	timespec_get (&ts, TIME_UTC) ;
+#endif
+
+	return ts.tv_sec + 1e-9 * ts.tv_nsec ;
+} /* now */
+
 /*==============================================================================
 */
 
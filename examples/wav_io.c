@@ -0,0 +1,521 @@
+/*
+** Copyright (c) 2002-2016, Erik de Castro Lopo <erikd@mega-nerd.com>
+** All rights reserved.
+**
+** This code is released under 2-clause BSD license. Please see the
+** file at : https://github.com/libsndfile/libsamplerate/blob/master/COPYING
+*/
+
+#include "src_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "wav_io.h"
+
+#if (HAVE_MMAP)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define	WAV_FORMAT_PCM			1
+#define	WAV_FORMAT_IEEE_FLOAT	3
+#define	WAV_FORMAT_EXTENSIBLE	0xFFFE
+
+#define	WAV_HEADER_LEN			44
+
+/* Output is gathered into blocks this big before being written. */
+#define	WAV_WRITE_BUFFER_LEN	(4 << 20)
+
+#define	WAV_ALIGN				4096
+
+struct WAV_WRITER
+{	int			fd, channels, samplerate, format ;
+	int			raw, error ;
+	int64_t		data_bytes ;
+
+	size_t		buffer_used ;
+	unsigned char	*buffer ;
+} ;
+
+static unsigned
+read_le16 (const unsigned char *ptr)
+{	return ptr [0] | (ptr [1] << 8) ;
+} /* read_le16 */
+
+static unsigned long
+read_le32 (const unsigned char *ptr)
+{	return ptr [0] | (ptr [1] << 8) | (ptr [2] << 16) | ((unsigned long) ptr [3] << 24) ;
+} /* read_le32 */
+
+static void
+write_le16 (unsigned char *ptr, unsigned value)
+{	ptr [0] = value & 0xFF ;
+	ptr [1] = (value >> 8) & 0xFF ;
+} /* write_le16 */
+
+static void
+write_le32 (unsigned char *ptr, unsigned long value)
+{	write_le16 (ptr, value & 0xFFFF) ;
+	write_le16 (ptr + 2, (value >> 16) & 0xFFFF) ;
+} /* write_le32 */
+
+int
+wav_sample_bytes (int format)
+{	switch (format)
+	{	case WAV_PCM_16 :
+			return 2 ;
+		case WAV_PCM_24 :
+			return 3 ;
+		case WAV_PCM_32 :
+		case WAV_FLOAT_32 :
+			return 4 ;
+		default :
+			break ;
+		} ;
+
+	return 0 ;
+} /* wav_sample_bytes */
+
+int
+wav_parse_format (const char *name)
+{
+	if (strcmp (name, "16") == 0)
+		return WAV_PCM_16 ;
+	if (strcmp (name, "24") == 0)
+		return WAV_PCM_24 ;
+	if (strcmp (name, "32") == 0)
+		return WAV_PCM_32 ;
+	if (strcmp (name, "float") == 0)
+		return WAV_FLOAT_32 ;
+
+	return 0 ;
+} /* wav_parse_format */
+
+const char *
+wav_format_name (int format)
+{	switch (format)
+	{	case WAV_PCM_16 :
+			return "16 bit PCM" ;
+		case WAV_PCM_24 :
+			return "24 bit PCM" ;
+		case WAV_PCM_32 :
+			return "32 bit PCM" ;
+		case WAV_FLOAT_32 :
+			return "32 bit float" ;
+		default :
+			break ;
+		} ;
+
+	return "unknown" ;
+} /* wav_format_name */
+
+/*==============================================================================
+*/
+
+static int
+map_file (const char *path, WAV_MAP *wav)
+{	struct stat	st ;
+	int			fd ;
+
+	memset (wav, 0, sizeof (*wav)) ;
+
+	if ((fd = open (path, O_RDONLY)) < 0)
+	{	fprintf (stderr, "Error : Not able to open '%s' : %s\n", path, strerror (errno)) ;
+		return 1 ;
+		} ;
+
+	if (fstat (fd, &st) != 0 || st.st_size == 0)
+	{	fprintf (stderr, "Error : '%s' is empty or unreadable.\n", path) ;
+		close (fd) ;
+		return 1 ;
+		} ;
+
+	wav->map_len = st.st_size ;
+	wav->map_base = mmap (NULL, wav->map_len, PROT_READ, MAP_SHARED, fd, 0) ;
+	close (fd) ;
+
+	if (wav->map_base == MAP_FAILED)
+	{	fprintf (stderr, "Error : Not able to map '%s' : %s\n", path, strerror (errno)) ;
+		wav->map_base = NULL ;
+		return 1 ;
+		} ;
+
+#ifdef MADV_SEQUENTIAL
+	/* Read through once, front to back. */
+	madvise (wav->map_base, wav->map_len, MADV_SEQUENTIAL) ;
+#endif
+
+	return 0 ;
+} /* map_file */
+
+int
+wav_map (const char *path, WAV_MAP *wav)
+{	const unsigned char *ptr, *end, *fmt = NULL ;
+	unsigned long chunk_len, fmt_len = 0 ;
+	unsigned	tag, bits ;
+
+	if (map_file (path, wav) != 0)
+		return 1 ;
+
+	ptr = wav->map_base ;
+	end = ptr + wav->map_len ;
+
+	if (wav->map_len < 12 || memcmp (ptr, "RIFF", 4) != 0 || memcmp (ptr + 8, "WAVE", 4) != 0)
+	{	fprintf (stderr, "Error : '%s' is not a WAV file.\n", path) ;
+		wav_unmap (wav) ;
+		return 1 ;
+		} ;
+
+	for (ptr += 12 ; end - ptr >= 8 ; ptr += 8 + chunk_len + (chunk_len & 1))
+	{	chunk_len = read_le32 (ptr + 4) ;
+
+		if (memcmp (ptr, "fmt ", 4) == 0)
+		{	fmt = ptr + 8 ;
+			fmt_len = chunk_len ;
+			}
+		else if (memcmp (ptr, "data", 4) == 0)
+		{	wav->data = ptr + 8 ;
+
+			/* Streamed files leave the length unset, take the rest of the file. */
+			if (chunk_len > (unsigned long) (end - wav->data))
+				chunk_len = end - wav->data ;
+			break ;
+			} ;
+
+		if (chunk_len > (unsigned long) (end - ptr))
+			break ;
+		} ;
+
+	if (fmt == NULL || fmt_len < 16 || fmt + fmt_len > end || wav->data == NULL)
+	{	fprintf (stderr, "Error : '%s' has no fmt or data chunk.\n", path) ;
+		wav_unmap (wav) ;
+		return 1 ;
+		} ;
+
+	tag = read_le16 (fmt) ;
+	wav->channels = read_le16 (fmt + 2) ;
+	wav->samplerate = read_le32 (fmt + 4) ;
+	bits = read_le16 (fmt + 14) ;
+
+	/* The sub-format GUID starts with the format tag. */
+	if (tag == WAV_FORMAT_EXTENSIBLE && fmt_len >= 26)
+		tag = read_le16 (fmt + 24) ;
+
+	if (tag == WAV_FORMAT_PCM && bits == 16)
+		wav->format = WAV_PCM_16 ;
+	else if (tag == WAV_FORMAT_PCM && bits == 24)
+		wav->format = WAV_PCM_24 ;
+	else if (tag == WAV_FORMAT_PCM && bits == 32)
+		wav->format = WAV_PCM_32 ;
+	else if (tag == WAV_FORMAT_IEEE_FLOAT && bits == 32)
+		wav->format = WAV_FLOAT_32 ;
+
+	if (wav->format == 0 || wav->channels < 1 || wav->samplerate < 1)
+	{	fprintf (stderr, "Error : '%s' is not 16, 24 or 32 bit PCM or 32 bit float.\n", path) ;
+		wav_unmap (wav) ;
+		return 1 ;
+		} ;
+
+	wav->frames = chunk_len / (wav->channels * wav_sample_bytes (wav->format)) ;
+
+	return 0 ;
+} /* wav_map */
+
+int
+wav_map_raw (const char *path, int channels, int samplerate, int format, WAV_MAP *wav)
+{
+	if (channels < 1 || samplerate < 1 || wav_sample_bytes (format) == 0)
+	{	fprintf (stderr, "Error : Bad layout for raw file '%s'.\n", path) ;
+		return 1 ;
+		} ;
+
+	if (map_file (path, wav) != 0)
+		return 1 ;
+
+	wav->channels = channels ;
+	wav->samplerate = samplerate ;
+	wav->format = format ;
+	wav->data = wav->map_base ;
+	wav->frames = wav->map_len / (channels * wav_sample_bytes (format)) ;
+
+	return 0 ;
+} /* wav_map_raw */
+
+void
+wav_unmap (WAV_MAP *wav)
+{
+	if (wav->map_base != NULL)
+		munmap (wav->map_base, wav->map_len) ;
+
+	memset (wav, 0, sizeof (*wav)) ;
+} /* wav_unmap */
+
+void
+wav_prefetch (const WAV_MAP *wav)
+{
+#ifdef MADV_WILLNEED
+	if (wav->map_base != NULL)
+		madvise (wav->map_base, wav->map_len, MADV_WILLNEED) ;
+#else
+	(void) wav ;
+#endif
+} /* wav_prefetch */
+
+const float *
+wav_float_frames (const WAV_MAP *wav, int64_t start)
+{	const unsigned char *ptr ;
+
+	if (CPU_IS_LITTLE_ENDIAN == 0 || wav->format != WAV_FLOAT_32)
+		return NULL ;
+
+	ptr = wav->data + start * wav->channels * sizeof (float) ;
+	if ((uintptr_t) ptr % sizeof (float) != 0)
+		return NULL ;
+
+	return (const float *) ptr ;
+} /* wav_float_frames */
+
+void
+wav_decode_float (const unsigned char *ptr, int format, long samples, float *buffer)
+{	long		k ;
+	int32_t		value ;
+	union
+	{	uint32_t	i ;
+		float		f ;
+	} bits ;
+
+	switch (format)
+	{	case WAV_PCM_16 :
+			for (k = 0 ; k < samples ; k++, ptr += 2)
+				buffer [k] = (int16_t) read_le16 (ptr) / 32768.0f ;
+			break ;
+
+		case WAV_PCM_24 :
+			for (k = 0 ; k < samples ; k++, ptr += 3)
+			{	value = (int32_t) (((uint32_t) ptr [0] << 8) | ((uint32_t) ptr [1] << 16) | ((uint32_t) ptr [2] << 24)) ;
+				buffer [k] = (float) (value / (8.0 * 0x10000000)) ;
+				} ;
+			break ;
+
+		case WAV_PCM_32 :
+			for (k = 0 ; k < samples ; k++, ptr += 4)
+				buffer [k] = (float) ((int32_t) read_le32 (ptr) / (8.0 * 0x10000000)) ;
+			break ;
+
+		case WAV_FLOAT_32 :
+			for (k = 0 ; k < samples ; k++, ptr += 4)
+			{	bits.i = read_le32 (ptr) ;
+				buffer [k] = bits.f ;
+				} ;
+			break ;
+
+		default :
+			memset (buffer, 0, samples * sizeof (float)) ;
+			break ;
+		} ;
+} /* wav_decode_float */
+
+void
+wav_read_float (const WAV_MAP *wav, int64_t start, long frames, float *buffer)
+{
+	wav_decode_float (wav->data + start * wav->channels * wav_sample_bytes (wav->format),
+						wav->format, frames * wav->channels, buffer) ;
+} /* wav_read_float */
+
+/*==============================================================================
+*/
+
+void *
+wav_aligned_alloc (size_t len)
+{	void *ptr ;
+
+	if (posix_memalign (&ptr, WAV_ALIGN, len) != 0)
+		return NULL ;
+
+	return ptr ;
+} /* wav_aligned_alloc */
+
+static void
+make_header (unsigned char *header, int channels, int samplerate, int format, int64_t data_bytes)
+{	int sample_bytes = wav_sample_bytes (format) ;
+
+	/* Plain WAV stops at 4 gigabytes, beyond that the lengths are only a guide. */
+	if (data_bytes > 0xFFFFFFFFL - WAV_HEADER_LEN)
+		data_bytes = 0xFFFFFFFFL - WAV_HEADER_LEN ;
+
+	memcpy (header, "RIFF", 4) ;
+	write_le32 (header + 4, WAV_HEADER_LEN - 8 + data_bytes) ;
+	memcpy (header + 8, "WAVEfmt ", 8) ;
+	write_le32 (header + 16, 16) ;
+	write_le16 (header + 20, format == WAV_FLOAT_32 ? WAV_FORMAT_IEEE_FLOAT : WAV_FORMAT_PCM) ;
+	write_le16 (header + 22, channels) ;
+	write_le32 (header + 24, samplerate) ;
+	write_le32 (header + 28, (unsigned long) samplerate * channels * sample_bytes) ;
+	write_le16 (header + 32, channels * sample_bytes) ;
+	write_le16 (header + 34, 8 * sample_bytes) ;
+	memcpy (header + 36, "data", 4) ;
+	write_le32 (header + 40, data_bytes) ;
+} /* make_header */
+
+static int
+write_all (int fd, const unsigned char *data, size_t len)
+{	ssize_t count ;
+
+	while (len > 0)
+	{	if ((count = write (fd, data, len)) < 0)
+		{	if (errno == EINTR)
+				continue ;
+			return 1 ;
+			} ;
+		data += count ;
+		len -= count ;
+		} ;
+
+	return 0 ;
+} /* write_all */
+
+WAV_WRITER *
+wav_create (const char *path, int channels, int samplerate, int format)
+{	WAV_WRITER	*writer ;
+	unsigned char header [WAV_HEADER_LEN] ;
+
+	if ((writer = calloc (1, sizeof (*writer))) == NULL)
+		return NULL ;
+
+	writer->channels = channels ;
+	writer->samplerate = samplerate ;
+	writer->format = format ;
+
+	if ((writer->buffer = wav_aligned_alloc (WAV_WRITE_BUFFER_LEN)) == NULL)
+	{	free (writer) ;
+		return NULL ;
+		} ;
+
+	if ((writer->fd = open (path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+	{	fprintf (stderr, "Error : Not able to open '%s' : %s\n", path, strerror (errno)) ;
+		free (writer->buffer) ;
+		free (writer) ;
+		return NULL ;
+		} ;
+
+	/* Lengths are filled in by wav_close. */
+	make_header (header, channels, samplerate, format, 0) ;
+	writer->error = write_all (writer->fd, header, sizeof (header)) ;
+
+	return writer ;
+} /* wav_create */
+
+WAV_WRITER *
+wav_create_raw (int fd, int channels, int format)
+{	WAV_WRITER	*writer ;
+
+	if ((writer = calloc (1, sizeof (*writer))) == NULL)
+		return NULL ;
+
+	writer->fd = fd ;
+	writer->channels = channels ;
+	writer->format = format ;
+	writer->raw = 1 ;
+
+	if ((writer->buffer = wav_aligned_alloc (WAV_WRITE_BUFFER_LEN)) == NULL)
+	{	free (writer) ;
+		return NULL ;
+		} ;
+
+	return writer ;
+} /* wav_create_raw */
+
+static void
+flush_buffer (WAV_WRITER *writer)
+{
+	if (writer->buffer_used > 0 && write_all (writer->fd, writer->buffer, writer->buffer_used) != 0)
+		writer->error = 1 ;
+
+	writer->data_bytes += writer->buffer_used ;
+	writer->buffer_used = 0 ;
+} /* flush_buffer */
+
+int
+wav_write_float (WAV_WRITER *writer, const float *data, long frames)
+{	unsigned char *ptr ;
+	long		k, samples, chunk ;
+	int			sample_bytes, byte ;
+	int64_t		value ;
+	double		full_scale ;
+	union
+	{	uint32_t	i ;
+		float		f ;
+	} bits ;
+
+	sample_bytes = wav_sample_bytes (writer->format) ;
+	full_scale = ldexp (1.0, 8 * sample_bytes - 1) ;
+	samples = frames * writer->channels ;
+
+	while (samples > 0)
+	{	chunk = (WAV_WRITE_BUFFER_LEN - writer->buffer_used) / sample_bytes ;
+		if (chunk == 0)
+		{	flush_buffer (writer) ;
+			continue ;
+			} ;
+		if (chunk > samples)
+			chunk = samples ;
+
+		ptr = writer->buffer + writer->buffer_used ;
+
+		for (k = 0 ; k < chunk ; k++, ptr += sample_bytes)
+		{	if (writer->format == WAV_FLOAT_32)
+			{	bits.f = data [k] ;
+				write_le32 (ptr, bits.i) ;
+				continue ;
+				} ;
+
+			/* Scale, round and clip to the sample size. */
+			value = llrint (data [k] * full_scale) ;
+			if (value > full_scale - 1)
+				value = full_scale - 1 ;
+			else if (value < -full_scale)
+				value = -full_scale ;
+
+			for (byte = 0 ; byte < sample_bytes ; byte++)
+				ptr [byte] = (value >> (8 * byte)) & 0xFF ;
+			} ;
+
+		writer->buffer_used += chunk * sample_bytes ;
+		data += chunk ;
+		samples -= chunk ;
+		} ;
+
+	return writer->error ;
+} /* wav_write_float */
+
+int
+wav_close (WAV_WRITER *writer)
+{	unsigned char header [WAV_HEADER_LEN] ;
+	int error ;
+
+	flush_buffer (writer) ;
+
+	if (writer->raw == 0)
+	{	make_header (header, writer->channels, writer->samplerate, writer->format, writer->data_bytes) ;
+		if (pwrite (writer->fd, header, sizeof (header), 0) != sizeof (header))
+			writer->error = 1 ;
+
+		if (close (writer->fd) != 0)
+			writer->error = 1 ;
+		} ;
+
+	error = writer->error ;
+
+	free (writer->buffer) ;
+	free (writer) ;
+
+	return error ;
+} /* wav_close */
+
+#endif
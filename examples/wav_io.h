@@ -0,0 +1,80 @@
+/*
+** Copyright (c) 2002-2016, Erik de Castro Lopo <erikd@mega-nerd.com>
+** All rights reserved.
+**
+** This code is released under 2-clause BSD license. Please see the
+** file at : https://github.com/libsndfile/libsamplerate/blob/master/COPYING
+*/
+
+/*
+** Minimal WAV and raw file I/O for the example programs that do without
+** libsndfile. Input files are memory mapped, output goes out through large
+** aligned buffers. Sample data is always little endian.
+*/
+
+#include <stdint.h>
+
+enum
+{	WAV_PCM_16 = 1,
+	WAV_PCM_24,
+	WAV_PCM_32,
+	WAV_FLOAT_32
+} ;
+
+typedef struct
+{	int			channels, samplerate, format ;
+	int64_t		frames ;
+
+	/* The whole file is mapped, data points at the first sample. */
+	const unsigned char	*data ;
+	void		*map_base ;
+	size_t		map_len ;
+} WAV_MAP ;
+
+typedef struct WAV_WRITER WAV_WRITER ;
+
+/* Bytes per sample for a format, zero if the format is unknown. */
+int wav_sample_bytes (int format) ;
+
+/* Parse a format name, ie "16", "24", "32" or "float". Returns zero if unknown. */
+int wav_parse_format (const char *name) ;
+const char *wav_format_name (int format) ;
+
+/*
+** Map a WAV file, or a headerless raw file in the given layout. Return zero
+** on success, otherwise print the problem to stderr and return non zero.
+*/
+int wav_map (const char *path, WAV_MAP *wav) ;
+int wav_map_raw (const char *path, int channels, int samplerate, int format, WAV_MAP *wav) ;
+void wav_unmap (WAV_MAP *wav) ;
+
+/* Ask the kernel to start reading the sample data in ahead of use. */
+void wav_prefetch (const WAV_MAP *wav) ;
+
+/*
+** Input frames from start on as floats. wav_float_frames returns a pointer
+** straight into the mapping when the file already holds native floats and
+** NULL otherwise, in which case wav_read_float converts into the buffer.
+*/
+const float *wav_float_frames (const WAV_MAP *wav, int64_t start) ;
+void wav_read_float (const WAV_MAP *wav, int64_t start, long frames, float *buffer) ;
+
+/* Convert samples of the given format in memory to floats. */
+void wav_decode_float (const unsigned char *data, int format, long samples, float *buffer) ;
+
+/*
+** Create a WAV file, pass it float frames and close it to fill in the
+** header. wav_close returns non zero if anything failed to write.
+*/
+WAV_WRITER *wav_create (const char *path, int channels, int samplerate, int format) ;
+
+/*
+** Write headerless samples to an open file descriptor, which wav_close
+** flushes but leaves open.
+*/
+WAV_WRITER *wav_create_raw (int fd, int channels, int format) ;
+int wav_write_float (WAV_WRITER *writer, const float *data, long frames) ;
+int wav_close (WAV_WRITER *writer) ;
+
+/* Page aligned allocation for large buffers. Free with free (). */
+void *wav_aligned_alloc (size_t len) ;
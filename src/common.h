@@ -60,6 +60,22 @@
 
 #include "samplerate.h"
 
+/*
+** The target ratio is written by one thread and read by another. Without C11
+** atomics fall back to a volatile double, which the platforms concerned load
+** and store whole.
+*/
+#if (HAVE_STDATOMIC_H && ! defined (__cplusplus))
+#include <stdatomic.h>
+typedef _Atomic double	SRC_SHARED_RATIO ;
+#define	SHARED_RATIO_LOAD(x)		atomic_load_explicit (&(x), memory_order_relaxed)
+#define	SHARED_RATIO_STORE(x,v)		atomic_store_explicit (&(x), (v), memory_order_relaxed)
+#else
+typedef volatile double	SRC_SHARED_RATIO ;
+#define	SHARED_RATIO_LOAD(x)		(x)
+#define	SHARED_RATIO_STORE(x,v)		((x) = (v))
+#endif
+
 enum
 {	SRC_FALSE	= 0,
 	SRC_TRUE	= 1,
@@ -93,14 +109,52 @@ enum
 	SRC_ERR_NO_VARIABLE_RATIO,
 	SRC_ERR_SINC_PREPARE_DATA_BAD_LEN,
 	SRC_ERR_BAD_INTERNAL_STATE,
+	SRC_ERR_BAD_FFT_RATIO,
+	SRC_ERR_NO_ASYNC,
+	SRC_ERR_BAD_ASYNC_CONFIG,
+	SRC_ERR_ASYNC_THREAD,
+	SRC_ERR_ASYNC_ACTIVE,
+	SRC_ERR_BAD_ENVELOPE,
+	SRC_ERR_NO_PULL,
+	SRC_ERR_ASYNC_UNDERRUN,
 
 	/* This must be the last error number. */
 	SRC_ERR_MAX_ERROR
 } ;
 
+/* Read-ahead state for the callback interface, private to src_async.c. */
+typedef struct SRC_ASYNC_tag SRC_ASYNC ;
+
+/*
+** The ratio for each output frame of a src_process_envelope () or
+** src_process_ratios () call. The process functions step through it with
+** envelope_ratio () in place of ramping from last_ratio to src_ratio.
+*/
+typedef struct
+{	/* One ratio per output frame, or NULL to follow the breakpoints. */
+	const double			*ratios ;
+
+	/* The breakpoints, point being the next one to reach. */
+	const SRC_RATIO_POINT	*points ;
+	int						point_count, point ;
+
+	/* The segment the last frame asked for fell in. */
+	long	start_frame, end_frame ;
+	double	start_ratio, end_ratio ;
+
+	/* Lowest ratio anywhere in the call, which sets the filter length. */
+	double	min_ratio ;
+} SRC_ENVELOPE ;
+
 typedef struct SRC_PRIVATE_tag
 {	double	last_ratio, last_position ;
 
+	/* Set by src_set_target_ratio (), overrides SRC_DATA's src_ratio when non zero. */
+	SRC_SHARED_RATIO	target_ratio ;
+
+	/* Set by src_pull_input_frames (), the ratio of the next process call. */
+	double	pull_ratio ;
+
 	int		error ;
 	int		channels ;
 
@@ -116,25 +170,72 @@ typedef struct SRC_PRIVATE_tag
 	/* Constant speed process function. */
 	int		(*const_process) (struct SRC_PRIVATE_tag *psrc, SRC_DATA *data) ;
 
+	/*
+	** Process function following envelope rather than src_ratio, NULL if the
+	** converter can not. Then src_process_envelope () makes a call per segment.
+	*/
+	int		(*envelope_process) (struct SRC_PRIVATE_tag *psrc, SRC_DATA *data) ;
+
+	/* Non NULL for the length of a src_process_envelope () or src_process_ratios () call. */
+	SRC_ENVELOPE	*envelope ;
+
 	/* State reset. */
 	void	(*reset) (struct SRC_PRIVATE_tag *psrc) ;
 
 	/* State clone. */
 	int		(*copy) (struct SRC_PRIVATE_tag *from, struct SRC_PRIVATE_tag *to) ;
 
+	/* Free private_data and anything it owns. If NULL, private_data is simply freed. */
+	void	(*close) (struct SRC_PRIVATE_tag *psrc) ;
+
+	/* Input frames by which the output trails the input at the given ratio. */
+	double	(*latency) (struct SRC_PRIVATE_tag *psrc, double src_ratio) ;
+
+	/*
+	** Output frames a process call would give, gliding from start_ratio to
+	** end_ratio, without touching the state, or a negative error. NULL if the
+	** converter can not say, a trial run on a clone is done instead.
+	*/
+	long	(*predict) (struct SRC_PRIVATE_tag *psrc, double start_ratio, double end_ratio, long input_frames, long output_frames) ;
+
 	/* Data specific to SRC_MODE_CALLBACK. */
 	src_callback_t	callback_func ;
 	void			*user_callback_data ;
 	long			saved_frames ;
 	const float		*saved_data ;
+
+	/* Non NULL when the callback is read ahead by another thread. */
+	SRC_ASYNC		*async ;
 } SRC_PRIVATE ;
 
+/* In samplerate.c */
+
+/* The ratio for the given output frame. Frames must be asked for in order. */
+double envelope_ratio (SRC_ENVELOPE *envelope, long frame) ;
+
+/* In src_async.c */
+int async_start (SRC_PRIVATE *psrc, const SRC_ASYNC_CONFIG *config) ;
+void async_stop (SRC_ASYNC *async) ;
+
+/* Stands in for the user callback. Returns -1 if no input is ready yet. */
+long async_read (SRC_ASYNC *async, float **data) ;
+void async_get_stats (SRC_ASYNC *async, SRC_ASYNC_STATS *stats) ;
+
 /* In src_sinc.c */
 const char* sinc_get_name (int src_enum) ;
 const char* sinc_get_description (int src_enum) ;
 
 int sinc_set_converter (SRC_PRIVATE *psrc, int src_enum) ;
 
+/* Switch a sinc converter to the exact ratio num / den. */
+int sinc_set_rational (SRC_PRIVATE *psrc, int num, int den) ;
+
+/* Channels filtered together at a constant ratio, or NULL if not yet known. */
+const char* sinc_get_plan (SRC_PRIVATE *psrc) ;
+
+/* Filter table used by the given sinc converter, for other engines sharing it. */
+int sinc_get_coeffs (int src_enum, const float **coeffs, int *coeff_half_len, int *index_inc) ;
+
 /* In src_linear.c */
 const char* linear_get_name (int src_enum) ;
 const char* linear_get_description (int src_enum) ;
@@ -147,6 +248,22 @@ const char* zoh_get_description (int src_enum) ;
 
 int zoh_set_converter (SRC_PRIVATE *psrc, int src_enum) ;
 
+/* In src_poly.c */
+const char* poly_get_name (int src_enum) ;
+const char* poly_get_description (int src_enum) ;
+
+int poly_set_converter (SRC_PRIVATE *psrc, int src_enum) ;
+
+/* In src_fft.c */
+const char* fft_get_name (int src_enum) ;
+const char* fft_get_description (int src_enum) ;
+
+int fft_set_converter (SRC_PRIVATE *psrc, int src_enum) ;
+
+/* In src_multistage.c */
+int multistage_set_converter (SRC_PRIVATE *psrc, int converter_type, double src_ratio) ;
+const char* multistage_get_plan (SRC_PRIVATE *psrc) ;
+
 /*----------------------------------------------------------
 **	Common static inline functions.
 */
@@ -167,6 +284,18 @@ is_bad_src_ratio (double ratio)
 {	return (ratio < (1.0 / SRC_MAX_RATIO) || ratio > (1.0 * SRC_MAX_RATIO)) ;
 } /* is_bad_src_ratio */
 
+/* Lowest ratio a process call will run at, which sets how much input it needs in hand. */
+static inline double
+process_min_ratio (const SRC_PRIVATE *psrc, const SRC_DATA *data)
+{	double ratio ;
+
+	ratio = MIN (psrc->last_ratio, data->src_ratio) ;
+	if (psrc->envelope != NULL)
+		ratio = MIN (ratio, psrc->envelope->min_ratio) ;
+
+	return ratio ;
+} /* process_min_ratio */
+
 
 #endif	/* COMMON_H_INCLUDED */
 
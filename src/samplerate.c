@@ -10,13 +10,21 @@
 #include	<stdlib.h>
 #include	<string.h>
 #include	<math.h>
+#include	<limits.h>
 
 #include	"src_config.h"
 
 #include	"samplerate.h"
 #include	"common.h"
 
+/* Output frames thrown away per call while priming. */
+#define	SRC_PRIME_FRAMES	256
+
 static int psrc_set_converter (SRC_PRIVATE	*psrc, int converter_type) ;
+static long psrc_predict (SRC_PRIVATE *psrc, double start_ratio, double end_ratio, long input_frames, long output_frames) ;
+static long psrc_input_needed (SRC_PRIVATE *psrc, double start_ratio, double end_ratio, long output_frames) ;
+static int psrc_predict_check (SRC_PRIVATE *psrc, double src_ratio, long frames) ;
+static int psrc_process (SRC_PRIVATE *psrc, SRC_DATA *data) ;
 
 
 SRC_STATE *
@@ -53,6 +61,74 @@ src_new (int converter_type, int channels, int *error)
 	return (SRC_STATE*) psrc ;
 } /* src_new */
 
+SRC_STATE *
+src_new_multistage (int converter_type, int channels, double src_ratio, int *error)
+{	SRC_PRIVATE	*psrc ;
+	int			ms_error ;
+
+	if (error)
+		*error = SRC_ERR_NO_ERROR ;
+
+	if (channels < 1)
+	{	if (error)
+			*error = SRC_ERR_BAD_CHANNEL_COUNT ;
+		return NULL ;
+		} ;
+
+	if ((psrc = ZERO_ALLOC (SRC_PRIVATE, sizeof (*psrc))) == NULL)
+	{	if (error)
+			*error = SRC_ERR_MALLOC_FAILED ;
+		return NULL ;
+		} ;
+
+	psrc->channels = channels ;
+	psrc->mode = SRC_MODE_PROCESS ;
+
+	if ((ms_error = multistage_set_converter (psrc, converter_type, src_ratio)) != SRC_ERR_NO_ERROR)
+	{	if (error)
+			*error = ms_error ;
+		free (psrc) ;
+		return NULL ;
+		} ;
+
+	src_reset ((SRC_STATE*) psrc) ;
+
+	return (SRC_STATE*) psrc ;
+} /* src_new_multistage */
+
+SRC_STATE *
+src_new_rational (int converter_type, int channels, int num, int den, int *error)
+{	SRC_STATE	*state ;
+	int			a, b, rem, rat_error ;
+
+	if (error)
+		*error = SRC_ERR_NO_ERROR ;
+
+	if (num < 1 || den < 1 || num > INT_MAX - den || is_bad_src_ratio ((1.0 * num) / den))
+	{	if (error)
+			*error = SRC_ERR_BAD_SRC_RATIO ;
+		return NULL ;
+		} ;
+
+	if ((state = src_new (converter_type, channels, error)) == NULL)
+		return NULL ;
+
+	/* Reduce to lowest terms to keep the phase arithmetic small. */
+	for (a = num, b = den ; b != 0 ; )
+	{	rem = a % b ;
+		a = b ;
+		b = rem ;
+		} ;
+
+	if ((rat_error = sinc_set_rational ((SRC_PRIVATE*) state, num / a, den / a)) != SRC_ERR_NO_ERROR)
+	{	if (error)
+			*error = rat_error ;
+		return src_delete (state) ;
+		} ;
+
+	return state ;
+} /* src_new_rational */
+
 SRC_STATE*
 src_clone (SRC_STATE* orig, int *error)
 {
@@ -62,6 +138,13 @@ src_clone (SRC_STATE* orig, int *error)
 	if (error)
 		*error = SRC_ERR_NO_ERROR ;
 
+	/* The clone would share the read-ahead ring. */
+	if (((SRC_PRIVATE*) orig)->async != NULL)
+	{	if (error)
+			*error = SRC_ERR_ASYNC_ACTIVE ;
+		return NULL ;
+		} ;
+
 	if ((psrc = ZERO_ALLOC (SRC_PRIVATE, sizeof (*psrc))) == NULL)
 	{	if (error)
 			*error = SRC_ERR_MALLOC_FAILED ;
@@ -112,7 +195,10 @@ src_delete (SRC_STATE *state)
 
 	psrc = (SRC_PRIVATE*) state ;
 	if (psrc)
-	{	if (psrc->private_data)
+	{	async_stop (psrc->async) ;
+		if (psrc->close)
+			psrc->close (psrc) ;
+		else if (psrc->private_data)
 			free (psrc->private_data) ;
 		memset (psrc, 0, sizeof (SRC_PRIVATE)) ;
 		free (psrc) ;
@@ -124,23 +210,54 @@ src_delete (SRC_STATE *state)
 int
 src_process (SRC_STATE *state, SRC_DATA *data)
 {	SRC_PRIVATE *psrc ;
-	int error ;
+	SRC_DATA	held ;
+	double		src_ratio ;
+	int			error ;
 
 	psrc = (SRC_PRIVATE*) state ;
 
 	if (psrc == NULL)
 		return SRC_ERR_BAD_STATE ;
+	if (data == NULL)
+		return SRC_ERR_BAD_DATA ;
+
+	/* A ratio posted from another thread takes over at the block boundary. */
+	if ((src_ratio = psrc->pull_ratio) > 0.0)
+	{	/* Unless src_pull_input_frames () already worked this call out for another. */
+		psrc->pull_ratio = 0.0 ;
+		}
+	else
+		src_ratio = SHARED_RATIO_LOAD (psrc->target_ratio) ;
+
+	if (src_ratio <= 0.0 || src_ratio == data->src_ratio)
+		return psrc_process (psrc, data) ;
+
+	/* Run at that ratio, leaving the caller's src_ratio as it was. */
+	held = *data ;
+	held.src_ratio = src_ratio ;
+
+	error = psrc_process (psrc, &held) ;
+
+	data->input_frames = held.input_frames ;
+	data->output_frames = held.output_frames ;
+	data->input_frames_used = held.input_frames_used ;
+	data->output_frames_gen = held.output_frames_gen ;
+
+	return error ;
+} /* src_process */
+
+/* src_process () at data's own src_ratio. */
+static int
+psrc_process (SRC_PRIVATE *psrc, SRC_DATA *data)
+{	int error ;
+
 	if (psrc->vari_process == NULL || psrc->const_process == NULL)
 		return SRC_ERR_BAD_PROC_PTR ;
 
 	if (psrc->mode != SRC_MODE_PROCESS)
 		return SRC_ERR_BAD_MODE ;
 
-	/* Check for valid SRC_DATA first. */
-	if (data == NULL)
-		return SRC_ERR_BAD_DATA ;
-
-	/* And that data_in and data_out are valid. */
+	/* Check that data_in and data_out are valid. */
 	if ((data->data_in == NULL && data->input_frames > 0)
 			|| (data->data_out == NULL && data->output_frames > 0))
 		return SRC_ERR_BAD_DATA_PTR ;
@@ -178,13 +295,248 @@ src_process (SRC_STATE *state, SRC_DATA *data)
 		psrc->last_ratio = data->src_ratio ;
 
 	/* Now process. */
-	if (fabs (psrc->last_ratio - data->src_ratio) < 1e-15)
+	if (psrc->envelope != NULL)
+		error = psrc->envelope_process (psrc, data) ;
+	else if (fabs (psrc->last_ratio - data->src_ratio) < 1e-15)
 		error = psrc->const_process (psrc, data) ;
 	else
 		error = psrc->vari_process (psrc, data) ;
 
 	return error ;
-} /* src_process */
+} /* psrc_process */
+
+/*
+** Run a process call with the converter's process function following
+** envelope in place of data->src_ratio.
+*/
+static int
+psrc_envelope_process (SRC_PRIVATE *psrc, SRC_DATA *data, SRC_ENVELOPE *envelope)
+{	SRC_DATA	held ;
+	int			error ;
+
+	/* Only checked and used to size the filter, the lowest ratio will do. */
+	held = *data ;
+	held.src_ratio = envelope->min_ratio ;
+
+	psrc->envelope = envelope ;
+	error = psrc_process (psrc, &held) ;
+	psrc->envelope = NULL ;
+
+	data->input_frames = held.input_frames ;
+	data->output_frames = held.output_frames ;
+	data->input_frames_used = held.input_frames_used ;
+	data->output_frames_gen = held.output_frames_gen ;
+
+	return error ;
+} /* psrc_envelope_process */
+
+/*
+** For converters without an envelope_process, run one call per envelope
+** segment with the segment's end ratio as the target, since each call ramps
+** the ratio in a straight line.
+*/
+static int
+envelope_segments (SRC_PRIVATE *psrc, SRC_DATA *data, const SRC_RATIO_POINT *points, int point_count)
+{	SRC_DATA	segment ;
+	double		end_ratio ;
+	long		start_frame, end_frame ;
+	int			k, error ;
+
+	data->input_frames_used = 0 ;
+	data->output_frames_gen = 0 ;
+
+	segment = *data ;
+	start_frame = 0 ;
+
+	for (k = 0 ; k <= point_count && start_frame < data->output_frames ; k++)
+	{	if (k == point_count)
+		{	end_frame = data->output_frames ;
+			end_ratio = points [point_count - 1].ratio ;
+			}
+		else if ((end_frame = points [k].frame) == start_frame)
+		{	/* A step, just like src_set_ratio (). */
+			psrc->last_ratio = points [k].ratio ;
+			continue ;
+			}
+		else if (end_frame > data->output_frames)
+		{	/* Stop part way along this segment. */
+			end_ratio = psrc->last_ratio + (points [k].ratio - psrc->last_ratio)
+							* (data->output_frames - start_frame) / (end_frame - start_frame) ;
+			end_frame = data->output_frames ;
+			}
+		else
+			end_ratio = points [k].ratio ;
+
+		segment.data_in = data->data_in + data->input_frames_used * psrc->channels ;
+		segment.input_frames = data->input_frames - data->input_frames_used ;
+		segment.data_out = data->data_out + data->output_frames_gen * psrc->channels ;
+		segment.output_frames = end_frame - start_frame ;
+		segment.src_ratio = end_ratio ;
+
+		/* The envelope sets the ratio, not src_set_target_ratio (). */
+		if ((error = psrc_process (psrc, &segment)) != 0)
+			return error ;
+
+		data->input_frames_used += segment.input_frames_used ;
+		data->output_frames_gen += segment.output_frames_gen ;
+
+		/* Out of input. */
+		if (segment.output_frames_gen < segment.output_frames)
+			break ;
+
+		start_frame = end_frame ;
+		} ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* envelope_segments */
+
+int
+src_process_envelope (SRC_STATE *state, SRC_DATA *data, const SRC_RATIO_POINT *points, int point_count)
+{	SRC_PRIVATE *psrc ;
+	SRC_ENVELOPE envelope ;
+	int			k, error ;
+
+	psrc = (SRC_PRIVATE*) state ;
+
+	if (psrc == NULL)
+		return SRC_ERR_BAD_STATE ;
+	if (data == NULL)
+		return SRC_ERR_BAD_DATA ;
+	if (point_count < 0 || (points == NULL && point_count > 0))
+		return SRC_ERR_BAD_ENVELOPE ;
+
+	for (k = 0 ; k < point_count ; k++)
+	{	if (points [k].frame < 0 || (k > 0 && points [k].frame < points [k - 1].frame))
+			return SRC_ERR_BAD_ENVELOPE ;
+		if (is_bad_src_ratio (points [k].ratio))
+			return SRC_ERR_BAD_SRC_RATIO ;
+		} ;
+
+	if (point_count == 0 || data->output_frames <= 0)
+		return src_process (state, data) ;
+
+	/* The envelope sets the ratio, so a count from src_pull_input_frames () is void. */
+	psrc->pull_ratio = 0.0 ;
+
+	/* A fresh converter starts on the envelope rather than ramping to it. */
+	if (psrc->last_ratio < (1.0 / SRC_MAX_RATIO))
+		psrc->last_ratio = points [0].ratio ;
+
+	if (psrc->envelope_process == NULL)
+		return envelope_segments (psrc, data, points, point_count) ;
+
+	/* The current ratio is the first point, at frame 0. */
+	memset (&envelope, 0, sizeof (envelope)) ;
+	envelope.points = points ;
+	envelope.point_count = point_count ;
+	envelope.start_ratio = envelope.end_ratio = psrc->last_ratio ;
+
+	envelope.min_ratio = psrc->last_ratio ;
+	for (k = 0 ; k < point_count ; k++)
+		envelope.min_ratio = MIN (envelope.min_ratio, points [k].ratio) ;
+
+	if ((error = psrc_envelope_process (psrc, data, &envelope)) != 0)
+		return error ;
+
+	/* Carry on along the envelope from where this call stopped. */
+	psrc->last_ratio = envelope_ratio (&envelope, data->output_frames_gen) ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* src_process_envelope */
+
+int
+src_process_ratios (SRC_STATE *state, SRC_DATA *data, const double *ratios)
+{	SRC_PRIVATE *psrc ;
+	SRC_ENVELOPE envelope ;
+	SRC_DATA	run ;
+	long		k, end ;
+	int			error ;
+
+	psrc = (SRC_PRIVATE*) state ;
+
+	if (psrc == NULL)
+		return SRC_ERR_BAD_STATE ;
+	if (data == NULL)
+		return SRC_ERR_BAD_DATA ;
+	if (data->output_frames <= 0)
+		return src_process (state, data) ;
+	if (ratios == NULL)
+		return SRC_ERR_BAD_DATA_PTR ;
+
+	memset (&envelope, 0, sizeof (envelope)) ;
+	envelope.ratios = ratios ;
+	envelope.min_ratio = ratios [0] ;
+
+	for (k = 0 ; k < data->output_frames ; k++)
+	{	if (is_bad_src_ratio (ratios [k]))
+			return SRC_ERR_BAD_SRC_RATIO ;
+		envelope.min_ratio = MIN (envelope.min_ratio, ratios [k]) ;
+		} ;
+
+	/* The ratios are set here, so a count from src_pull_input_frames () is void. */
+	psrc->pull_ratio = 0.0 ;
+
+	if (psrc->envelope_process != NULL)
+		return psrc_envelope_process (psrc, data, &envelope) ;
+
+	/* Otherwise one call for each run of frames at the same ratio. */
+	data->input_frames_used = 0 ;
+	data->output_frames_gen = 0 ;
+
+	run = *data ;
+
+	for (k = 0 ; k < data->output_frames ; k = end)
+	{	for (end = k + 1 ; end < data->output_frames && ratios [end] == ratios [k] ; end++)
+			;
+
+		run.data_in = data->data_in + data->input_frames_used * psrc->channels ;
+		run.input_frames = data->input_frames - data->input_frames_used ;
+		run.data_out = data->data_out + data->output_frames_gen * psrc->channels ;
+		run.output_frames = end - k ;
+		run.src_ratio = psrc->last_ratio = ratios [k] ;
+
+		if ((error = psrc_process (psrc, &run)) != 0)
+			return error ;
+
+		data->input_frames_used += run.input_frames_used ;
+		data->output_frames_gen += run.output_frames_gen ;
+
+		/* Out of input. */
+		if (run.output_frames_gen < run.output_frames)
+			break ;
+		} ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* src_process_ratios */
+
+double
+envelope_ratio (SRC_ENVELOPE *envelope, long frame)
+{
+	if (envelope->ratios != NULL)
+		return envelope->ratios [frame] ;
+
+	/* Move on to the segment holding frame, stepping over any steps on the way. */
+	while (frame >= envelope->end_frame)
+	{	envelope->start_frame = envelope->end_frame ;
+		envelope->start_ratio = envelope->end_ratio ;
+
+		if (envelope->point >= envelope->point_count)
+		{	/* Hold at the last point. */
+			envelope->end_frame = LONG_MAX ;
+			break ;
+			} ;
+
+		envelope->end_frame = envelope->points [envelope->point].frame ;
+		envelope->end_ratio = envelope->points [envelope->point].ratio ;
+		envelope->point ++ ;
+		} ;
+
+	if (envelope->end_frame == LONG_MAX)
+		return envelope->start_ratio ;
+
+	return envelope->start_ratio + (frame - envelope->start_frame)
+				* (envelope->end_ratio - envelope->start_ratio) / (envelope->end_frame - envelope->start_frame) ;
+} /* envelope_ratio */
 
 long
 src_callback_read (SRC_STATE *state, double src_ratio, long frames, float *data)
@@ -192,7 +544,7 @@ src_callback_read (SRC_STATE *state, double src_ratio, long frames, float *data)
 	SRC_DATA	src_data ;
 
 	long	output_frames_gen ;
-	int		error = 0 ;
+	int		error = 0, underrun = 0 ;
 
 	if (state == NULL)
 		return 0 ;
@@ -202,6 +554,10 @@ src_callback_read (SRC_STATE *state, double src_ratio, long frames, float *data)
 
 	psrc = (SRC_PRIVATE*) state ;
 
+	/* An underrun only holds for the read that hit it. */
+	if (psrc->error == SRC_ERR_ASYNC_UNDERRUN)
+		psrc->error = SRC_ERR_NO_ERROR ;
+
 	if (psrc->mode != SRC_MODE_CALLBACK)
 	{	psrc->error = SRC_ERR_BAD_MODE ;
 		return 0 ;
@@ -238,7 +594,15 @@ src_callback_read (SRC_STATE *state, double src_ratio, long frames, float *data)
 		if (src_data.input_frames == 0)
 		{	float *ptr = dummy ;
 
-			src_data.input_frames = psrc->callback_func (psrc->user_callback_data, &ptr) ;
+			if (psrc->async == NULL)
+				src_data.input_frames = psrc->callback_func (psrc->user_callback_data, &ptr) ;
+			else if ((src_data.input_frames = async_read (psrc->async, &ptr)) < 0)
+			{	/* Read-ahead has fallen behind, return what there is. */
+				src_data.input_frames = 0 ;
+				underrun = 1 ;
+				break ;
+				} ;
+
 			src_data.data_in = ptr ;
 
 			if (src_data.input_frames == 0)
@@ -277,9 +641,52 @@ src_callback_read (SRC_STATE *state, double src_ratio, long frames, float *data)
 		return 0 ;
 		} ;
 
+	/* Zero is kept for the end of the stream. */
+	if (underrun && output_frames_gen == 0)
+	{	psrc->error = SRC_ERR_ASYNC_UNDERRUN ;
+		return -1 ;
+		} ;
+
 	return output_frames_gen ;
 } /* src_callback_read */
 
+int
+src_callback_set_async (SRC_STATE *state, const SRC_ASYNC_CONFIG *config)
+{	SRC_PRIVATE	*psrc ;
+
+	if ((psrc = (SRC_PRIVATE*) state) == NULL)
+		return SRC_ERR_BAD_STATE ;
+
+	if (psrc->mode != SRC_MODE_CALLBACK)
+		return SRC_ERR_BAD_MODE ;
+
+	if (psrc->callback_func == NULL)
+		return SRC_ERR_NULL_CALLBACK ;
+
+	if (psrc->async != NULL)
+		return SRC_ERR_ASYNC_ACTIVE ;
+
+	return async_start (psrc, config) ;
+} /* src_callback_set_async */
+
+int
+src_callback_get_async_stats (SRC_STATE *state, SRC_ASYNC_STATS *stats)
+{	SRC_PRIVATE	*psrc ;
+
+	if ((psrc = (SRC_PRIVATE*) state) == NULL)
+		return SRC_ERR_BAD_STATE ;
+
+	if (stats == NULL)
+		return SRC_ERR_BAD_DATA_PTR ;
+
+	if (psrc->async == NULL)
+		return SRC_ERR_BAD_MODE ;
+
+	async_get_stats (psrc->async, stats) ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* src_callback_get_async_stats */
+
 /*==========================================================================
 */
 
@@ -298,10 +705,29 @@ src_set_ratio (SRC_STATE *state, double new_ratio)
 		return SRC_ERR_BAD_SRC_RATIO ;
 
 	psrc->last_ratio = new_ratio ;
+	/* A step cancels the ratio src_pull_input_frames () worked the count out for. */
+	psrc->pull_ratio = 0.0 ;
 
 	return SRC_ERR_NO_ERROR ;
 } /* src_set_ratio */
 
+int
+src_set_target_ratio (SRC_STATE *state, double target_ratio)
+{	SRC_PRIVATE *psrc ;
+
+	psrc = (SRC_PRIVATE*) state ;
+
+	if (psrc == NULL)
+		return SRC_ERR_BAD_STATE ;
+
+	if (target_ratio != 0.0 && is_bad_src_ratio (target_ratio))
+		return SRC_ERR_BAD_SRC_RATIO ;
+
+	SHARED_RATIO_STORE (psrc->target_ratio, target_ratio) ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* src_set_target_ratio */
+
 int
 src_get_channels (SRC_STATE *state)
 {	SRC_PRIVATE *psrc ;
@@ -328,6 +754,7 @@ src_reset (SRC_STATE *state)
 
 	psrc->last_position = 0.0 ;
 	psrc->last_ratio = 0.0 ;
+	psrc->pull_ratio = 0.0 ;
 
 	psrc->saved_data = NULL ;
 	psrc->saved_frames = 0 ;
@@ -337,6 +764,150 @@ src_reset (SRC_STATE *state)
 	return SRC_ERR_NO_ERROR ;
 } /* src_reset */
 
+int
+src_get_latency (SRC_STATE *state, double src_ratio, double *input_frames, double *output_frames)
+{	SRC_PRIVATE *psrc ;
+	double latency ;
+
+	psrc = (SRC_PRIVATE*) state ;
+
+	if (psrc == NULL)
+		return SRC_ERR_BAD_STATE ;
+	if (psrc->latency == NULL)
+		return SRC_ERR_BAD_PROC_PTR ;
+
+	if (is_bad_src_ratio (src_ratio))
+		return SRC_ERR_BAD_SRC_RATIO ;
+
+	latency = psrc->latency (psrc, src_ratio) ;
+
+	if (input_frames)
+		*input_frames = latency ;
+	if (output_frames)
+		*output_frames = latency * src_ratio ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* src_get_latency */
+
+int
+src_prime (SRC_STATE *state, double src_ratio, const float *data, long frames)
+{	SRC_PRIVATE	*psrc ;
+	SRC_DATA	src_data ;
+	float		*discard ;
+	int			mode, error ;
+
+	psrc = (SRC_PRIVATE*) state ;
+
+	if (psrc == NULL)
+		return SRC_ERR_BAD_STATE ;
+	if (data == NULL && frames > 0)
+		return SRC_ERR_BAD_DATA_PTR ;
+	if (frames <= 0)
+		return SRC_ERR_NO_ERROR ;
+
+	if ((discard = ZERO_ALLOC (float, SRC_PRIME_FRAMES * psrc->channels * sizeof (float))) == NULL)
+		return SRC_ERR_MALLOC_FAILED ;
+
+	memset (&src_data, 0, sizeof (src_data)) ;
+	src_data.data_in = data ;
+	src_data.input_frames = frames ;
+	src_data.data_out = discard ;
+	src_data.output_frames = SRC_PRIME_FRAMES ;
+	src_data.src_ratio = src_ratio ;
+
+	/*
+	** Run the audio through as usual and throw the output away, which leaves
+	** the converter just where it would be mid stream. Callback mode states
+	** can be primed too, so switch modes the same way src_callback_read does.
+	*/
+	mode = psrc->mode ;
+	psrc->mode = SRC_MODE_PROCESS ;
+
+	do
+	{	if ((error = src_process (state, &src_data)) != 0)
+			break ;
+
+		src_data.data_in += src_data.input_frames_used * psrc->channels ;
+		src_data.input_frames -= src_data.input_frames_used ;
+		}
+	while (src_data.input_frames_used > 0 || src_data.output_frames_gen > 0) ;
+
+	psrc->mode = mode ;
+
+	free (discard) ;
+
+	return error ;
+} /* src_prime */
+
+long
+src_get_output_frames (SRC_STATE *state, double src_ratio, long input_frames)
+{	SRC_PRIVATE	*psrc ;
+	long		limit, gen ;
+	int			error ;
+
+	psrc = (SRC_PRIVATE*) state ;
+
+	if ((error = psrc_predict_check (psrc, src_ratio, input_frames)) != SRC_ERR_NO_ERROR)
+		return -error ;
+
+	if (psrc->predict != NULL)
+		return psrc->predict (psrc, src_ratio, src_ratio, input_frames, LONG_MAX / psrc->channels) ;
+
+	/* A trial run needs real room, so grow it until it is not all used. */
+	limit = lrint (ceil (input_frames * src_ratio)) + 4096 ;
+	while ((gen = psrc_predict (psrc, src_ratio, src_ratio, input_frames, limit)) == limit)
+	{	if (limit > LONG_MAX / 4 / psrc->channels)
+			return -SRC_ERR_BAD_INTERNAL_STATE ;
+		limit *= 2 ;
+		} ;
+
+	return gen ;
+} /* src_get_output_frames */
+
+long
+src_get_input_frames_needed (SRC_STATE *state, double src_ratio, long output_frames)
+{	SRC_PRIVATE	*psrc ;
+	int			error ;
+
+	psrc = (SRC_PRIVATE*) state ;
+
+	if ((error = psrc_predict_check (psrc, src_ratio, output_frames)) != SRC_ERR_NO_ERROR)
+		return -error ;
+
+	return psrc_input_needed (psrc, src_ratio, src_ratio, output_frames) ;
+} /* src_get_input_frames_needed */
+
+long
+src_pull_input_frames (SRC_STATE *state, double src_ratio, long output_frames)
+{	SRC_PRIVATE	*psrc ;
+	double		target_ratio, start_ratio ;
+	long		frames ;
+	int			error ;
+
+	psrc = (SRC_PRIVATE*) state ;
+
+	if (psrc != NULL && (target_ratio = SHARED_RATIO_LOAD (psrc->target_ratio)) > 0.0)
+		src_ratio = target_ratio ;
+
+	if ((error = psrc_predict_check (psrc, src_ratio, output_frames)) != SRC_ERR_NO_ERROR)
+		return -error ;
+
+	/* Device callbacks can not afford a trial run in a clone. */
+	if (psrc->predict == NULL)
+		return -SRC_ERR_NO_PULL ;
+
+	/* The next call glides from where the last one left off, just as src_process () does. */
+	start_ratio = is_bad_src_ratio (psrc->last_ratio) ? src_ratio : psrc->last_ratio ;
+
+	if ((frames = psrc_input_needed (psrc, start_ratio, src_ratio, output_frames)) < 0)
+		return frames ;
+
+	/* Hold the next call to this ratio, whatever src_set_target_ratio () posts meanwhile. */
+	psrc->pull_ratio = src_ratio ;
+
+	return frames ;
+} /* src_pull_input_frames */
+
 /*==============================================================================
 **	Control functions.
 */
@@ -354,6 +925,12 @@ src_get_name (int converter_type)
 	if ((desc = linear_get_name (converter_type)) != NULL)
 		return desc ;
 
+	if ((desc = poly_get_name (converter_type)) != NULL)
+		return desc ;
+
+	if ((desc = fft_get_name (converter_type)) != NULL)
+		return desc ;
+
 	return NULL ;
 } /* src_get_name */
 
@@ -370,9 +947,28 @@ src_get_description (int converter_type)
 	if ((desc = linear_get_description (converter_type)) != NULL)
 		return desc ;
 
+	if ((desc = poly_get_description (converter_type)) != NULL)
+		return desc ;
+
+	if ((desc = fft_get_description (converter_type)) != NULL)
+		return desc ;
+
 	return NULL ;
 } /* src_get_description */
 
+const char *
+src_get_plan (SRC_STATE *state)
+{	const char *plan ;
+
+	if (state == NULL)
+		return NULL ;
+
+	if ((plan = multistage_get_plan ((SRC_PRIVATE*) state)) != NULL)
+		return plan ;
+
+	return sinc_get_plan ((SRC_PRIVATE*) state) ;
+} /* src_get_plan */
+
 const char *
 src_get_version (void)
 {	return PACKAGE "-" VERSION " (c) 2002-2008 Erik de Castro Lopo" ;
@@ -450,6 +1046,22 @@ src_strerror (int error)
 				return "Internal error : Bad length in prepare_data ()." ;
 		case SRC_ERR_BAD_INTERNAL_STATE :
 				return "Error : Someone is trampling on my internal state." ;
+		case SRC_ERR_BAD_FFT_RATIO :
+				return "FFT converter needs a ratio of the form L/M with L <= 16." ;
+		case SRC_ERR_NO_ASYNC :
+				return "Asynchronous read-ahead is not available in this build." ;
+		case SRC_ERR_BAD_ASYNC_CONFIG :
+				return "Bad ring size or watermarks for asynchronous read-ahead." ;
+		case SRC_ERR_ASYNC_THREAD :
+				return "Could not start the asynchronous read-ahead thread." ;
+		case SRC_ERR_ASYNC_ACTIVE :
+				return "Not possible while asynchronous read-ahead is enabled." ;
+		case SRC_ERR_BAD_ENVELOPE :
+				return "Ratio envelope frames must be non negative and in order." ;
+		case SRC_ERR_NO_PULL :
+				return "This converter can not predict its input without a trial run, so has no pull mode." ;
+		case SRC_ERR_ASYNC_UNDERRUN :
+				return "The asynchronous read-ahead ring ran dry. Try again later." ;
 
 		case SRC_ERR_MAX_ERROR :
 				return "Placeholder. No error defined for this error number." ;
@@ -558,6 +1170,117 @@ psrc_set_converter (SRC_PRIVATE	*psrc, int converter_type)
 	if (linear_set_converter (psrc, converter_type) == SRC_ERR_NO_ERROR)
 		return SRC_ERR_NO_ERROR ;
 
+	if (poly_set_converter (psrc, converter_type) == SRC_ERR_NO_ERROR)
+		return SRC_ERR_NO_ERROR ;
+
+	if (fft_set_converter (psrc, converter_type) == SRC_ERR_NO_ERROR)
+		return SRC_ERR_NO_ERROR ;
+
 	return SRC_ERR_BAD_CONVERTER ;
 } /* psrc_set_converter */
 
+/*
+** The least input for which a src_process () call gliding from start_ratio to
+** end_ratio fills output_frames frames, or a negative error.
+*/
+static long
+psrc_input_needed (SRC_PRIVATE *psrc, double start_ratio, double end_ratio, long output_frames)
+{	long	low, high, mid, gen ;
+
+	/* Frames already held may be enough. */
+	if ((gen = psrc_predict (psrc, start_ratio, end_ratio, 0, output_frames)) < 0)
+		return gen ;
+	if (gen >= output_frames)
+		return 0 ;
+
+	/*
+	** More input never gives less output, so double from the plain ratio
+	** estimate until there is enough and then bisect down to the least.
+	*/
+	low = 0 ;
+	high = MAX (1, lrint (ceil (output_frames / MIN (start_ratio, end_ratio)))) ;
+
+	while ((gen = psrc_predict (psrc, start_ratio, end_ratio, high, output_frames)) < output_frames)
+	{	if (gen < 0)
+			return gen ;
+		if (high > LONG_MAX / 4 / psrc->channels)
+			return -SRC_ERR_BAD_INTERNAL_STATE ;
+		low = high ;
+		high *= 2 ;
+		} ;
+
+	while (high - low > 1)
+	{	mid = low + (high - low) / 2 ;
+		if ((gen = psrc_predict (psrc, start_ratio, end_ratio, mid, output_frames)) < 0)
+			return gen ;
+		if (gen >= output_frames)
+			high = mid ;
+		else
+			low = mid ;
+		} ;
+
+	return high ;
+} /* psrc_input_needed */
+
+static int
+psrc_predict_check (SRC_PRIVATE *psrc, double src_ratio, long frames)
+{
+	if (psrc == NULL)
+		return SRC_ERR_BAD_STATE ;
+	if (psrc->vari_process == NULL || psrc->const_process == NULL)
+		return SRC_ERR_BAD_PROC_PTR ;
+	if (psrc->mode != SRC_MODE_PROCESS)
+		return SRC_ERR_BAD_MODE ;
+	if (is_bad_src_ratio (src_ratio))
+		return SRC_ERR_BAD_SRC_RATIO ;
+	if (frames < 0)
+		return SRC_ERR_BAD_DATA ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* psrc_predict_check */
+
+/*
+** Output frames of a src_process () call on input_frames frames with room for
+** output_frames frames, gliding from start_ratio to end_ratio, or a negative
+** error. Converters that can not say are run on silence in a throw away clone.
+*/
+static long
+psrc_predict (SRC_PRIVATE *psrc, double start_ratio, double end_ratio, long input_frames, long output_frames)
+{	SRC_PRIVATE	*clone ;
+	SRC_DATA	src_data ;
+	float		*input, *output ;
+	int			error ;
+
+	if (psrc->predict != NULL)
+		return psrc->predict (psrc, start_ratio, end_ratio, input_frames, output_frames) ;
+
+	if ((clone = (SRC_PRIVATE*) src_clone ((SRC_STATE*) psrc, &error)) == NULL)
+		return -error ;
+
+	input = ZERO_ALLOC (float, MAX (input_frames, 1) * psrc->channels * sizeof (float)) ;
+	output = ZERO_ALLOC (float, MAX (output_frames, 1) * psrc->channels * sizeof (float)) ;
+
+	memset (&src_data, 0, sizeof (src_data)) ;
+	src_data.data_in = input ;
+	src_data.input_frames = input_frames ;
+	src_data.data_out = output ;
+	src_data.output_frames = output_frames ;
+	src_data.src_ratio = end_ratio ;
+
+	/* At the ratios asked for, whatever src_set_target_ratio () has posted. */
+	SHARED_RATIO_STORE (clone->target_ratio, 0.0) ;
+	clone->pull_ratio = 0.0 ;
+	clone->last_ratio = start_ratio ;
+
+	if (input == NULL || output == NULL)
+		error = SRC_ERR_MALLOC_FAILED ;
+	else
+		error = src_process ((SRC_STATE*) clone, &src_data) ;
+
+	free (input) ;
+	free (output) ;
+	src_delete ((SRC_STATE*) clone) ;
+
+	return error ? -error : src_data.output_frames_gen ;
+} /* psrc_predict */
+
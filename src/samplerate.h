@@ -71,6 +71,27 @@ SRC_STATE* src_clone (SRC_STATE* orig, int *error) ;
 SRC_STATE* src_callback_new (src_callback_t func, int converter_type, int channels,
 				int *error, void* cb_data) ;
 
+/*
+**	Initialisation for large downsampling ratios : factor src_ratio into a
+**	chain of half-band decimators followed by a single converter_type stage.
+**	The result is used exactly like a state from src_new(). The plan is made
+**	for src_ratio, which should stay close to the ratios later passed in.
+**	Error returned in *error.
+*/
+
+SRC_STATE* src_new_multistage (int converter_type, int channels, double src_ratio, int *error) ;
+
+/*
+**	Initialisation for an exact, constant conversion ratio of num / den (ie
+**	48000 / 44100). The position in the input is kept as an integer phase so
+**	no rounding accumulates and a stream of N input frames always gives
+**	exactly floor (N * num / den) output frames. Only the sinc converters
+**	are supported. The src_ratio passed to src_process() must still equal
+**	num / den. Error returned in *error.
+*/
+
+SRC_STATE* src_new_rational (int converter_type, int channels, int num, int den, int *error) ;
+
 /*
 **	Cleanup all internal allocations.
 **	Always returns NULL.
@@ -85,12 +106,76 @@ SRC_STATE* src_delete (SRC_STATE *state) ;
 
 int src_process (SRC_STATE *state, SRC_DATA *data) ;
 
+/*
+**	Processing with the ratio following an envelope across the call, in place
+**	of data->src_ratio. The envelope is a list of breakpoints in order of
+**	output frame, counted from data->data_out. The ratio moves in a straight
+**	line from the converter's current ratio to the first point and from each
+**	point to the next, and holds at the last. Two points on the same frame
+**	give a step. Points past data->output_frames shape the ramp up to the end
+**	of the call and should be passed again, less output_frames_gen, next time.
+**	The sinc (other than from src_new_rational ()), linear, ZOH and polynomial
+**	converters work out the ratio for each output frame in a single process
+**	call. Others make one call per segment.
+**	Returns non zero on error.
+*/
+
+typedef struct
+{	long	frame ;
+	double	ratio ;
+} SRC_RATIO_POINT ;
+
+int src_process_envelope (SRC_STATE *state, SRC_DATA *data, const SRC_RATIO_POINT *points, int point_count) ;
+
+/*
+**	As above, but with a ratio given for every output frame, so ratios must
+**	hold data->output_frames values. The converters that follow an envelope
+**	in a single call do the same here. Others make one call per run of equal
+**	ratios, and those that can not vary the ratio fail as for src_process ().
+**	Returns non zero on error.
+*/
+
+int src_process_ratios (SRC_STATE *state, SRC_DATA *data, const double *ratios) ;
+
 /*
 **	Callback based processing function. Read up to frames worth of data from
 **	the converter int *data and return frames read or -1 on error.
 */
 long src_callback_read (SRC_STATE *state, double src_ratio, long frames, float *data) ;
 
+/*
+**	Asynchronous read-ahead for the callback interface. Once enabled, a
+**	background thread calls the user supplied callback ahead of demand and
+**	queues its audio in a ring, and src_callback_read() takes its input from
+**	the ring without ever waiting on the callback. When the ring runs dry,
+**	src_callback_read() returns fewer frames than asked for and counts an
+**	underrun; the missing frames follow in later calls. If it has no frames
+**	at all it returns -1, with src_error() reporting the underrun until the
+**	next read, so a return of zero still only ever means the end.
+**
+**	All sizes are in frames. Zero fields in SRC_ASYNC_CONFIG, or a NULL
+**	config, select the defaults. The thread refills the ring when it drops
+**	below low_water and stops once it holds high_water.
+**
+**	src_callback_set_async () must be called before the first
+**	src_callback_read (). Returns non zero on error.
+*/
+
+typedef struct
+{	long	ring_frames ;
+	long	low_water, high_water ;
+} SRC_ASYNC_CONFIG ;
+
+typedef struct
+{	long	underruns ;
+	long	min_fill ;
+	long	fill ;
+	int		end_of_input ;
+} SRC_ASYNC_STATS ;
+
+int src_callback_set_async (SRC_STATE *state, const SRC_ASYNC_CONFIG *config) ;
+int src_callback_get_async_stats (SRC_STATE *state, SRC_ASYNC_STATS *stats) ;
+
 /*
 **	Simple interface for performing a single conversion from input buffer to
 **	output buffer at a fixed conversion ratio.
@@ -113,6 +198,77 @@ const char *src_get_name (int converter_type) ;
 const char *src_get_description (int converter_type) ;
 const char *src_get_version (void) ;
 
+/*
+** Return a string describing the chain of stages chosen by
+** src_new_multistage(). For a sinc converter, once it has run at a constant
+** ratio, it says how many channels are filtered together to keep the input
+** in cache. NULL for any other SRC_STATE.
+*/
+
+const char *src_get_plan (SRC_STATE *state) ;
+
+/*
+**	Get the latency of the converter at the given ratio, that is how many
+**	frames the output trails the input by once the converter is running :
+**	the output for an input frame has come out by the time this many later
+**	input frames have been passed in. It counts both the look ahead a filter
+**	needs and any delay in the signal itself, and is rounded up, so the real
+**	delay is up to a frame less. The FFT converter works in blocks, so its
+**	delay varies with where a frame falls in a block, and the longest is
+**	given. This is also how much of the audio passed to src_prime () has not
+**	yet come out. output_frames is the same in output frames.
+**	Either pointer may be NULL.
+**	Returns non zero on error.
+*/
+
+int src_get_latency (SRC_STATE *state, double src_ratio, double *input_frames, double *output_frames) ;
+
+/*
+**	Prime a new or freshly reset converter with the audio leading up to the
+**	stream, in place of the silence it would otherwise start from. The output
+**	of the next src_process () call then starts at that audio's last
+**	src_get_latency () input frames.
+**	Returns non zero on error.
+*/
+
+int src_prime (SRC_STATE *state, double src_ratio, const float *data, long frames) ;
+
+/*
+**	Predict, for a src_process () call at a steady src_ratio, how many output
+**	frames the given number of input frames gives with unlimited room, and
+**	how many input frames are needed to fill the given number of output
+**	frames. Both count what the converter already holds, so the answers are
+**	exact for the next call, except that a call which changes the ratio glides
+**	to it and can differ by a frame or two. Process mode only.
+**	The sinc, zero order hold, linear and polynomial converters work the
+**	answer out directly. For SRC_SINC_BEST_QUALITY_FFT and converters from
+**	src_new_multistage () it comes from converting silence in a clone of the
+**	state, which allocates memory and costs at least as much as the real
+**	call, so do not call these from a real time thread for those converters.
+**	Return the frame count, or a negative error number on error.
+*/
+
+long src_get_output_frames (SRC_STATE *state, double src_ratio, long input_frames) ;
+long src_get_input_frames_needed (SRC_STATE *state, double src_ratio, long output_frames) ;
+
+/*
+**	Pull mode, for audio device callbacks that need exactly output_frames
+**	frames each period. Returns exactly how many input frames the next
+**	src_process () call must be given to fill output_frames frames, gliding
+**	from the current ratio to src_ratio (or to the ratio posted by
+**	src_set_target_ratio ()). That call then runs at the same ratio whatever
+**	it is passed or is posted in between. Input frames it does not use, which
+**	only the polynomial converters leave, must be passed again next time.
+**	The held ratio is used up by that src_process () call, and dropped by
+**	src_set_ratio (), src_reset (), src_process_envelope () and
+**	src_process_ratios ().
+**	Not available for SRC_SINC_BEST_QUALITY_FFT or converters from
+**	src_new_multistage (), whose input can only be found by a trial run.
+**	Returns the frame count, or a negative error number on error.
+*/
+
+long src_pull_input_frames (SRC_STATE *state, double src_ratio, long output_frames) ;
+
 /*
 **	Set a new SRC ratio. This allows step responses
 **	in the conversion ratio.
@@ -121,6 +277,22 @@ const char *src_get_version (void) ;
 
 int src_set_ratio (SRC_STATE *state, double new_ratio) ;
 
+/*
+**	Set the ratio from another thread, such as a user interface, while the
+**	audio thread is inside src_process () or src_callback_read (). Does not
+**	lock. From the next block on, the converter uses this ratio in place of
+**	the one passed in, ramping to it smoothly across that block. A ratio of
+**	zero hands control back to the ratio passed in. The src_ratio field of
+**	the caller's SRC_DATA is never changed.
+**	For each src_process () call the ratio used is, first, the one held by
+**	src_pull_input_frames () for that call, then this target ratio, then
+**	SRC_DATA's src_ratio. src_process_envelope () and src_process_ratios ()
+**	follow their own ratios and ignore the target ratio.
+**	Returns non zero on error.
+*/
+
+int src_set_target_ratio (SRC_STATE *state, double target_ratio) ;
+
 /*
 **	Get the current channel count.
 **	Returns negative on error, positive channel count otherwise
@@ -167,8 +339,22 @@ enum
 	SRC_SINC_FASTEST			= 2,
 	SRC_ZERO_ORDER_HOLD			= 3,
 	SRC_LINEAR					= 4,
+	SRC_SINC_BEST_QUALITY_FFT	= 5,
+	SRC_CUBIC_HERMITE			= 6,
+	SRC_LAGRANGE_6POINT			= 7,
+	SRC_OPTIMAL_4POINT			= 8,
+	SRC_OPTIMAL_6POINT			= 9,
 } ;
 
+/*
+** SRC_SINC_BEST_QUALITY_FFT only handles a fixed ratio L / M, in lowest terms,
+** with L no more than 16, such as 1 / 2, 2 / 3 or 3. That leaves out 44100 to
+** 48000 and back (160 / 147 and 147 / 160), for which src_process () fails.
+** The ratio is fixed by the first src_process () call after src_new () or
+** src_reset (), and src_process () also fails on a different ratio after that.
+** Use SRC_SINC_BEST_QUALITY for anything else.
+*/
+
 /*
 ** Extra helper functions for converting from short to float and
 ** back again.
@@ -0,0 +1,313 @@
+/*
+** Copyright (c) 2002-2016, Erik de Castro Lopo <erikd@mega-nerd.com>
+** All rights reserved.
+**
+** This code is released under 2-clause BSD license. Please see the
+** file at : https://github.com/libsndfile/libsamplerate/blob/master/COPYING
+*/
+
+/*
+** Asynchronous read-ahead for the callback interface.
+**
+** A producer thread calls the user callback and copies its audio into a
+** single producer, single consumer ring. The consumer is src_callback_read,
+** which takes blocks straight out of the ring and never waits: the ring
+** counters are atomics, and the only lock it touches is tried, not taken.
+** The producer sleeps on a condition variable between refills, with a short
+** timeout covering any wake up the consumer could not deliver.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "src_config.h"
+#include "common.h"
+
+/* Defaults for a zero or NULL SRC_ASYNC_CONFIG, in frames. */
+#define	ASYNC_DEFAULT_RING_FRAMES	16384
+
+/* Longest the producer sleeps without being woken, in nanoseconds. */
+#define	ASYNC_WAIT_NSEC				5000000
+
+#if (HAVE_PTHREAD && HAVE_STDATOMIC_H)
+
+#include <pthread.h>
+#include <time.h>
+#include <stdatomic.h>
+
+struct SRC_ASYNC_tag
+{	src_callback_t	callback_func ;
+	void		*user_callback_data ;
+	int			channels ;
+
+	/* The ring holds ring_frames frames, a power of two. */
+	unsigned long	ring_frames, ring_mask ;
+	unsigned long	low_water, high_water ;
+
+	/* Frames ever written by the producer and released by the consumer. */
+	atomic_ulong	write_count, read_count ;
+	atomic_int		end_of_input, quit ;
+
+	/* Producer side, the part of the last callback block not yet in the ring. */
+	float		*pending_data ;
+	long		pending_frames ;
+
+	/*
+	** Consumer side, frames handed to the converter and not yet released.
+	** The converter is given at most hand_frames at a time, so the producer
+	** sees the ring drain long before it is empty.
+	*/
+	unsigned long	held_frames, hand_frames ;
+	long		underruns, min_fill ;
+
+	int			thread_running ;
+	pthread_t	thread ;
+	pthread_mutex_t	mutex ;
+	pthread_cond_t	cond ;
+
+	float		ring [] ;
+} ;
+
+static void * async_thread (void *arg) ;
+static int async_fill (SRC_ASYNC *async) ;
+
+int
+async_start (SRC_PRIVATE *psrc, const SRC_ASYNC_CONFIG *config)
+{	SRC_ASYNC	*async ;
+	unsigned long ring_frames, low_water, high_water ;
+
+	ring_frames = (config && config->ring_frames > 0) ? config->ring_frames : ASYNC_DEFAULT_RING_FRAMES ;
+	high_water = (config && config->high_water > 0) ? (unsigned long) config->high_water : ring_frames ;
+	low_water = (config && config->low_water > 0) ? (unsigned long) config->low_water : high_water / 2 ;
+
+	if ((config && (config->ring_frames < 0 || config->low_water < 0 || config->high_water < 0))
+			|| high_water > ring_frames || low_water >= high_water
+			|| ring_frames > (unsigned long) (LONG_MAX / 2) / psrc->channels / sizeof (float))
+		return SRC_ERR_BAD_ASYNC_CONFIG ;
+
+	/* Round the ring up to a power of two so the counters can wrap freely. */
+	while (ring_frames & (ring_frames - 1))
+		ring_frames += ring_frames & ~(ring_frames - 1) ;
+
+	if ((async = ZERO_ALLOC (SRC_ASYNC, sizeof (SRC_ASYNC) + ring_frames * psrc->channels * sizeof (float))) == NULL)
+		return SRC_ERR_MALLOC_FAILED ;
+
+	async->callback_func = psrc->callback_func ;
+	async->user_callback_data = psrc->user_callback_data ;
+	async->channels = psrc->channels ;
+
+	async->ring_frames = ring_frames ;
+	async->ring_mask = ring_frames - 1 ;
+	async->low_water = low_water ;
+	async->high_water = high_water ;
+	async->hand_frames = MAX (low_water / 2, 1) ;
+
+	atomic_init (&async->write_count, 0) ;
+	atomic_init (&async->read_count, 0) ;
+	atomic_init (&async->end_of_input, 0) ;
+	atomic_init (&async->quit, 0) ;
+
+	if (pthread_mutex_init (&async->mutex, NULL) != 0)
+	{	free (async) ;
+		return SRC_ERR_ASYNC_THREAD ;
+		} ;
+
+	if (pthread_cond_init (&async->cond, NULL) != 0)
+	{	pthread_mutex_destroy (&async->mutex) ;
+		free (async) ;
+		return SRC_ERR_ASYNC_THREAD ;
+		} ;
+
+	/* Fill the ring here so the first reads do not run dry. */
+	if (async_fill (async))
+	{	if (pthread_create (&async->thread, NULL, async_thread, async) != 0)
+		{	async_stop (async) ;
+			return SRC_ERR_ASYNC_THREAD ;
+			} ;
+		async->thread_running = SRC_TRUE ;
+		} ;
+
+	async->min_fill = atomic_load (&async->write_count) ;
+
+	psrc->async = async ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* async_start */
+
+void
+async_stop (SRC_ASYNC *async)
+{
+	if (async == NULL)
+		return ;
+
+	if (async->thread_running)
+	{	pthread_mutex_lock (&async->mutex) ;
+		atomic_store (&async->quit, 1) ;
+		pthread_cond_signal (&async->cond) ;
+		pthread_mutex_unlock (&async->mutex) ;
+
+		pthread_join (async->thread, NULL) ;
+		} ;
+
+	pthread_cond_destroy (&async->cond) ;
+	pthread_mutex_destroy (&async->mutex) ;
+
+	free (async) ;
+} /* async_stop */
+
+/*
+** The callback replacement for src_callback_read. Releases the frames handed
+** out last time and returns the next contiguous run in the ring. Returns 0 at
+** the end of input and -1 if the ring is empty.
+*/
+long
+async_read (SRC_ASYNC *async, float **data)
+{	unsigned long read_count, fill ;
+
+	read_count = atomic_load_explicit (&async->read_count, memory_order_relaxed) + async->held_frames ;
+	atomic_store_explicit (&async->read_count, read_count, memory_order_release) ;
+	async->held_frames = 0 ;
+
+	fill = atomic_load_explicit (&async->write_count, memory_order_acquire) - read_count ;
+
+	/* Wake the producer if it is idle, but never wait for it. */
+	if (fill <= async->low_water && async->thread_running && pthread_mutex_trylock (&async->mutex) == 0)
+	{	pthread_cond_signal (&async->cond) ;
+		pthread_mutex_unlock (&async->mutex) ;
+		} ;
+
+	if ((long) fill < async->min_fill)
+		async->min_fill = fill ;
+
+	if (fill == 0)
+	{	/* The producer flags the end after its last write, so look again. */
+		if (atomic_load_explicit (&async->end_of_input, memory_order_acquire)
+				&& atomic_load_explicit (&async->write_count, memory_order_acquire) == read_count)
+			return 0 ;
+
+		async->underruns ++ ;
+		return -1 ;
+		} ;
+
+	async->held_frames = MIN (fill, async->ring_frames - (read_count & async->ring_mask)) ;
+	async->held_frames = MIN (async->held_frames, async->hand_frames) ;
+	*data = async->ring + (read_count & async->ring_mask) * async->channels ;
+
+	return async->held_frames ;
+} /* async_read */
+
+void
+async_get_stats (SRC_ASYNC *async, SRC_ASYNC_STATS *stats)
+{	unsigned long read_count ;
+
+	read_count = atomic_load_explicit (&async->read_count, memory_order_relaxed) + async->held_frames ;
+
+	stats->underruns = async->underruns ;
+	stats->min_fill = async->min_fill ;
+	stats->fill = atomic_load_explicit (&async->write_count, memory_order_acquire) - read_count ;
+	stats->end_of_input = atomic_load (&async->end_of_input) ;
+} /* async_get_stats */
+
+/*----------------------------------------------------------------------------------------
+*/
+
+/*
+** Copy callback audio into the ring until it holds high_water frames.
+** Returns SRC_FALSE once the callback has reported the end of its audio.
+*/
+static int
+async_fill (SRC_ASYNC *async)
+{	unsigned long write_count, fill, frames, start ;
+	float		*dummy = NULL ;
+
+	write_count = atomic_load_explicit (&async->write_count, memory_order_relaxed) ;
+
+	for (;;)
+	{	fill = write_count - atomic_load_explicit (&async->read_count, memory_order_acquire) ;
+		if (fill >= async->high_water || atomic_load (&async->quit))
+			return SRC_TRUE ;
+
+		if (async->pending_frames <= 0)
+		{	async->pending_data = dummy ;
+			async->pending_frames = async->callback_func (async->user_callback_data, &async->pending_data) ;
+
+			if (async->pending_frames <= 0)
+			{	atomic_store_explicit (&async->end_of_input, 1, memory_order_release) ;
+				return SRC_FALSE ;
+				} ;
+			} ;
+
+		start = write_count & async->ring_mask ;
+		frames = MIN ((unsigned long) async->pending_frames, async->ring_frames - fill) ;
+		frames = MIN (frames, async->ring_frames - start) ;
+
+		memcpy (async->ring + start * async->channels, async->pending_data, frames * async->channels * sizeof (float)) ;
+
+		write_count += frames ;
+		atomic_store_explicit (&async->write_count, write_count, memory_order_release) ;
+
+		async->pending_data += frames * async->channels ;
+		async->pending_frames -= frames ;
+		} ;
+} /* async_fill */
+
+static void *
+async_thread (void *arg)
+{	SRC_ASYNC	*async = (SRC_ASYNC*) arg ;
+	struct timespec	timeout ;
+	unsigned long fill ;
+
+	while (async_fill (async))
+	{	pthread_mutex_lock (&async->mutex) ;
+
+		for (;;)
+		{	fill = atomic_load (&async->write_count) - atomic_load (&async->read_count) ;
+			if (atomic_load (&async->quit) || fill <= async->low_water)
+				break ;
+
+			clock_gettime (CLOCK_REALTIME, &timeout) ;
+			timeout.tv_nsec += ASYNC_WAIT_NSEC ;
+			if (timeout.tv_nsec >= 1000000000)
+			{	timeout.tv_sec ++ ;
+				timeout.tv_nsec -= 1000000000 ;
+				} ;
+
+			pthread_cond_timedwait (&async->cond, &async->mutex, &timeout) ;
+			} ;
+
+		pthread_mutex_unlock (&async->mutex) ;
+
+		if (atomic_load (&async->quit))
+			break ;
+		} ;
+
+	return NULL ;
+} /* async_thread */
+
+#else
+
+/* No threads or atomics, so no read-ahead. */
+
+int
+async_start (SRC_PRIVATE *UNUSED (psrc), const SRC_ASYNC_CONFIG *UNUSED (config))
+{	return SRC_ERR_NO_ASYNC ;
+} /* async_start */
+
+void
+async_stop (SRC_ASYNC *UNUSED (async))
+{
+} /* async_stop */
+
+long
+async_read (SRC_ASYNC *UNUSED (async), float **UNUSED (data))
+{	return 0 ;
+} /* async_read */
+
+void
+async_get_stats (SRC_ASYNC *UNUSED (async), SRC_ASYNC_STATS *stats)
+{	memset (stats, 0, sizeof (*stats)) ;
+} /* async_get_stats */
+
+#endif
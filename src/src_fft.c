@@ -0,0 +1,535 @@
+/*
+** Copyright (c) 2002-2016, Erik de Castro Lopo <erikd@mega-nerd.com>
+** All rights reserved.
+**
+** This code is released under 2-clause BSD license. Please see the
+** file at : https://github.com/libsndfile/libsamplerate/blob/master/COPYING
+*/
+
+/*
+** FFT overlap-save engine for the best quality sinc filter.
+**
+** For a fixed rational ratio L / M the sinc converter only ever evaluates
+** the filter at L distinct phases. Each phase is an ordinary FIR filter, so
+** instead of running the (very long, when downsampling) filter once per
+** output frame, every phase is applied to a whole block of input with a
+** single FFT convolution and the outputs are then picked out of the result.
+** The filter is the same table the direct form converter uses, evaluated
+** without the fixed point rounding of the filter index.
+**
+** The ratio is fixed by the first call to src_process () after creation or
+** src_reset (). Changing it later returns SRC_ERR_NO_VARIABLE_RATIO.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "src_config.h"
+#include "common.h"
+
+#define	FFT_MAGIC_MARKER	MAKE_MAGIC (' ', 'f', 'f', 't', 's', ' ')
+
+/* Largest L in a ratio of L / M. Every phase costs an inverse FFT per block. */
+#define	FFT_MAX_PHASES		16
+
+#define	FFT_MIN_LEN			1024
+#define	FFT_MAX_LEN			(1 << 20)
+
+#ifndef	M_PI
+#define	M_PI			3.14159265358979323846264338
+#endif
+
+typedef struct
+{	int		fft_magic_marker ;
+
+	int		channels ;
+
+	const float	*coeffs ;
+	int		coeff_half_len, index_inc ;
+
+	/* The planned ratio is phases / decim, zero if not planned yet. */
+	double	src_ratio ;
+	int		phases, decim ;
+
+	/* Output m uses phase (m * decim) % phases, or m == phase * inv_decim mod phases. */
+	int		inv_decim ;
+
+	/* Filter taps either side of the centre, in input frames. */
+	int		half_len ;
+
+	/* Transform length and number of new input frames per transform. */
+	int		fft_len, block_len ;
+
+	/* Next output frame and first input frame whose outputs the next block computes. */
+	int64_t	out_index, block_start ;
+
+	/* Input frames taken so far and, after end of input, the total output length. */
+	int64_t	in_total, out_total ;
+	int		end_seen ;
+
+	/* Frames in window. window [0] is input frame block_start - half_len. */
+	int		window_frames ;
+
+	/* Outputs of the last block not yet handed to the caller. */
+	int		out_len, out_start, out_frames ;
+
+	double	*twiddle, *spectra, *work, *temp ;
+	float	*window, *out_fifo ;
+
+	size_t	storage_len ;
+
+	/* C99 struct flexible array, holds the doubles followed by the floats. */
+	double	storage [] ;
+} FFT_FILTER ;
+
+static int fft_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data) ;
+static int fft_const_process (SRC_PRIVATE *psrc, SRC_DATA *data) ;
+static void fft_reset (SRC_PRIVATE *psrc) ;
+static int fft_copy (SRC_PRIVATE *from, SRC_PRIVATE *to) ;
+static double fft_latency (SRC_PRIVATE *psrc, double src_ratio) ;
+
+static int fft_lengths (const FFT_FILTER *filter, double src_ratio, int *half_len, int *fft_len) ;
+static int fft_plan (SRC_PRIVATE *psrc, double src_ratio) ;
+static void fft_set_pointers (FFT_FILTER *filter) ;
+static void fft_run_block (FFT_FILTER *filter) ;
+static void fft_transform (double *data, int len, const double *twiddle, int sign) ;
+
+/*----------------------------------------------------------------------------------------
+*/
+
+const char*
+fft_get_name (int src_enum)
+{
+	if (src_enum == SRC_SINC_BEST_QUALITY_FFT)
+		return "Best Sinc Interpolator (FFT)" ;
+
+	return NULL ;
+} /* fft_get_name */
+
+const char*
+fft_get_description (int src_enum)
+{
+	if (src_enum == SRC_SINC_BEST_QUALITY_FFT)
+		return "Band limited sinc interpolation by FFT convolution, best quality. Fixed ratios L/M with L <= 16 only (not 44.1k <-> 48k), set by the first src_process () call." ;
+
+	return NULL ;
+} /* fft_get_description */
+
+int
+fft_set_converter (SRC_PRIVATE *psrc, int src_enum)
+{	FFT_FILTER *filter ;
+	int error ;
+
+	if (src_enum != SRC_SINC_BEST_QUALITY_FFT)
+		return SRC_ERR_BAD_CONVERTER ;
+
+	if (psrc->private_data != NULL)
+	{	free (psrc->private_data) ;
+		psrc->private_data = NULL ;
+		} ;
+
+	if ((filter = ZERO_ALLOC (FFT_FILTER, sizeof (*filter))) == NULL)
+		return SRC_ERR_MALLOC_FAILED ;
+
+	filter->fft_magic_marker = FFT_MAGIC_MARKER ;
+	filter->channels = psrc->channels ;
+
+	if ((error = sinc_get_coeffs (SRC_SINC_BEST_QUALITY, &filter->coeffs, &filter->coeff_half_len, &filter->index_inc)) != SRC_ERR_NO_ERROR)
+	{	free (filter) ;
+		return error ;
+		} ;
+
+	psrc->private_data = filter ;
+
+	psrc->const_process = fft_const_process ;
+	psrc->vari_process = fft_vari_process ;
+	psrc->reset = fft_reset ;
+	psrc->copy = fft_copy ;
+	psrc->latency = fft_latency ;
+
+	fft_reset (psrc) ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* fft_set_converter */
+
+static void
+fft_reset (SRC_PRIVATE *psrc)
+{	FFT_FILTER *filter ;
+
+	filter = (FFT_FILTER*) psrc->private_data ;
+	if (filter == NULL)
+		return ;
+
+	filter->out_index = filter->block_start = 0 ;
+	filter->in_total = filter->out_total = 0 ;
+	filter->end_seen = SRC_FALSE ;
+	filter->out_start = filter->out_frames = 0 ;
+
+	/* The first half_len frames of the first window are the silence before the input. */
+	filter->window_frames = filter->half_len ;
+	if (filter->window != NULL)
+		memset (filter->window, 0, filter->fft_len * filter->channels * sizeof (filter->window [0])) ;
+} /* fft_reset */
+
+static int
+fft_copy (SRC_PRIVATE *from, SRC_PRIVATE *to)
+{	FFT_FILTER *from_filter, *to_filter ;
+	size_t		private_length ;
+
+	if (from->private_data == NULL)
+		return SRC_ERR_NO_PRIVATE ;
+
+	from_filter = (FFT_FILTER*) from->private_data ;
+	private_length = sizeof (FFT_FILTER) + from_filter->storage_len ;
+
+	if ((to_filter = ZERO_ALLOC (FFT_FILTER, private_length)) == NULL)
+		return SRC_ERR_MALLOC_FAILED ;
+
+	memcpy (to_filter, from_filter, private_length) ;
+	fft_set_pointers (to_filter) ;
+
+	to->private_data = to_filter ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* fft_copy */
+
+static double
+fft_latency (SRC_PRIVATE *psrc, double src_ratio)
+{	FFT_FILTER *filter ;
+	int half_len, fft_len ;
+
+	if ((filter = (FFT_FILTER*) psrc->private_data) == NULL)
+		return 0.0 ;
+
+	if (fft_lengths (filter, src_ratio, &half_len, &fft_len) != SRC_ERR_NO_ERROR)
+		return 0.0 ;
+
+	/* Worst case, just before a block completes. */
+	return fft_len - half_len ;
+} /* fft_latency */
+
+/*----------------------------------------------------------------------------------------
+*/
+
+static int
+fft_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
+{	FFT_FILTER *filter ;
+
+	if ((filter = (FFT_FILTER*) psrc->private_data) == NULL)
+		return SRC_ERR_NO_PRIVATE ;
+
+	/* A new ratio is only accepted before any input has gone in. */
+	if (filter->in_total > 0 || filter->end_seen)
+		return SRC_ERR_NO_VARIABLE_RATIO ;
+
+	psrc->last_ratio = data->src_ratio ;
+
+	return fft_const_process (psrc, data) ;
+} /* fft_vari_process */
+
+static int
+fft_const_process (SRC_PRIVATE *psrc, SRC_DATA *data)
+{	FFT_FILTER *filter ;
+	long	in_used, out_gen, count ;
+	int		channels, error ;
+
+	if ((filter = (FFT_FILTER*) psrc->private_data) == NULL)
+		return SRC_ERR_NO_PRIVATE ;
+
+	if (filter->src_ratio != data->src_ratio)
+	{	if (filter->in_total > 0 || filter->end_seen)
+			return SRC_ERR_NO_VARIABLE_RATIO ;
+
+		if ((error = fft_plan (psrc, data->src_ratio)) != SRC_ERR_NO_ERROR)
+			return (psrc->error = error) ;
+
+		filter = (FFT_FILTER*) psrc->private_data ;
+		} ;
+
+	channels = filter->channels ;
+	in_used = out_gen = 0 ;
+
+	while (1)
+	{	/* Hand over what is left of the last block first. */
+		if (filter->out_frames > 0)
+		{	count = MIN (filter->out_frames, data->output_frames - out_gen) ;
+			memcpy (data->data_out + out_gen * channels, filter->out_fifo + filter->out_start * channels,
+						count * channels * sizeof (data->data_out [0])) ;
+			out_gen += count ;
+			filter->out_start += count ;
+			filter->out_frames -= count ;
+			} ;
+
+		if (filter->out_frames > 0 || out_gen >= data->output_frames)
+			break ;
+
+		if (filter->end_seen && filter->out_index >= filter->out_total)
+			break ;
+
+		if (filter->end_seen == SRC_FALSE)
+		{	count = MIN (filter->fft_len - filter->window_frames, data->input_frames - in_used) ;
+			memcpy (filter->window + filter->window_frames * channels, data->data_in + in_used * channels,
+						count * channels * sizeof (data->data_in [0])) ;
+			in_used += count ;
+			filter->window_frames += count ;
+			filter->in_total += count ;
+			} ;
+
+		if (filter->window_frames < filter->fft_len)
+		{	if (filter->end_seen == SRC_FALSE)
+			{	if (data->end_of_input == SRC_FALSE)
+					break ;
+
+				filter->end_seen = SRC_TRUE ;
+				filter->out_total = filter->in_total * filter->phases / filter->decim ;
+				} ;
+
+			/* Everything after the end of the input is silence. */
+			memset (filter->window + filter->window_frames * channels, 0,
+						(filter->fft_len - filter->window_frames) * channels * sizeof (filter->window [0])) ;
+			filter->window_frames = filter->fft_len ;
+			} ;
+
+		fft_run_block (filter) ;
+		} ;
+
+	data->input_frames_used = in_used ;
+	data->output_frames_gen = out_gen ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* fft_const_process */
+
+/*----------------------------------------------------------------------------------------
+*/
+
+static int
+fft_lengths (const FFT_FILTER *filter, double src_ratio, int *half_len, int *fft_len)
+{
+	*half_len = (int) ceil (filter->coeff_half_len / (filter->index_inc * MIN (src_ratio, 1.0))) + 1 ;
+
+	/* At least four times the filter length keeps the overlap below a quarter. */
+	for (*fft_len = FFT_MIN_LEN ; *fft_len < 4 * (2 * *half_len + 1) ; *fft_len *= 2)
+		if (*fft_len >= FFT_MAX_LEN)
+			return SRC_ERR_FILTER_LEN ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* fft_lengths */
+
+static int
+fft_plan (SRC_PRIVATE *psrc, double src_ratio)
+{	FFT_FILTER	*filter, *new_filter ;
+	double		scale, pos, fraction, coeff ;
+	size_t		storage_len ;
+	int			phases, decim = 0, half_len, fft_len, block_len, out_len, indx, k, p, error ;
+
+	filter = (FFT_FILTER*) psrc->private_data ;
+
+	/* The smallest L with src_ratio == L / M. Being the smallest, L and M are coprime. */
+	for (phases = 1 ; phases <= FFT_MAX_PHASES ; phases++)
+	{	decim = (int) lrint (phases / src_ratio) ;
+		if (decim > 0 && fabs ((1.0 * phases) / decim - src_ratio) <= 1e-12 * src_ratio)
+			break ;
+		} ;
+
+	if (phases > FFT_MAX_PHASES)
+		return SRC_ERR_BAD_FFT_RATIO ;
+
+	if ((error = fft_lengths (filter, src_ratio, &half_len, &fft_len)) != SRC_ERR_NO_ERROR)
+		return error ;
+
+	scale = MIN (src_ratio, 1.0) ;
+
+	block_len = fft_len - 2 * half_len ;
+	out_len = (int) (((int64_t) block_len * phases) / decim) + 2 ;
+
+	storage_len = sizeof (double) * ((size_t) fft_len * (1 + 2 * phases + 4))
+					+ sizeof (float) * ((size_t) fft_len + out_len) * filter->channels ;
+
+	if ((new_filter = ZERO_ALLOC (FFT_FILTER, sizeof (FFT_FILTER) + storage_len)) == NULL)
+		return SRC_ERR_MALLOC_FAILED ;
+
+	*new_filter = *filter ;
+	free (filter) ;
+	psrc->private_data = filter = new_filter ;
+
+	filter->src_ratio = src_ratio ;
+	filter->phases = phases ;
+	filter->decim = decim ;
+	filter->half_len = half_len ;
+	filter->fft_len = fft_len ;
+	filter->block_len = block_len ;
+	filter->out_len = out_len ;
+	filter->storage_len = storage_len ;
+
+	fft_set_pointers (filter) ;
+
+	for (filter->inv_decim = 0 ; (filter->inv_decim * decim) % phases != 1 % phases ; filter->inv_decim ++)
+		;
+
+	for (k = 0 ; k < fft_len / 2 ; k++)
+	{	filter->twiddle [2 * k] = cos (2.0 * M_PI * k / fft_len) ;
+		filter->twiddle [2 * k + 1] = -sin (2.0 * M_PI * k / fft_len) ;
+		} ;
+
+	/*
+	** Phase p filters the input for outputs that fall p / L of an input frame
+	** after an input frame. Tap k sits half_len frames before that frame's
+	** own tap, which makes the filter causal. The 1 / fft_len of the inverse
+	** transform is folded in here too.
+	*/
+	for (p = 0 ; p < phases ; p++)
+	{	double *spectrum = filter->spectra + 2 * (size_t) p * fft_len ;
+
+		for (k = 0 ; k <= 2 * half_len ; k++)
+		{	pos = fabs (k - half_len + (1.0 * p) / phases) * filter->index_inc * scale ;
+			if (pos >= filter->coeff_half_len)
+				continue ;
+
+			indx = (int) pos ;
+			fraction = pos - indx ;
+			coeff = filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
+
+			spectrum [2 * k] = scale * coeff / fft_len ;
+			} ;
+
+		fft_transform (spectrum, fft_len, filter->twiddle, 1) ;
+		} ;
+
+	fft_reset (psrc) ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* fft_plan */
+
+static void
+fft_set_pointers (FFT_FILTER *filter)
+{	size_t fft_len = filter->fft_len ;
+
+	if (filter->storage_len == 0)
+		return ;
+
+	filter->twiddle = filter->storage ;
+	filter->spectra = filter->twiddle + fft_len ;
+	filter->work = filter->spectra + 2 * fft_len * filter->phases ;
+	filter->temp = filter->work + 2 * fft_len ;
+
+	filter->window = (float *) (filter->temp + 2 * fft_len) ;
+	filter->out_fifo = filter->window + fft_len * filter->channels ;
+} /* fft_set_pointers */
+
+static void
+fft_run_block (FFT_FILTER *filter)
+{	const double *spectrum ;
+	double	*work, *temp ;
+	float	*out ;
+	int64_t	m, m_first, m_end, i ;
+	int		channels, ch, fft_len, phases, p, k, n ;
+
+	channels = filter->channels ;
+	fft_len = filter->fft_len ;
+	phases = filter->phases ;
+	work = filter->work ;
+	temp = filter->temp ;
+
+	/* Outputs whose centre input frame is in [block_start, block_start + block_len). */
+	m_first = filter->out_index ;
+	m_end = ((filter->block_start + filter->block_len) * phases + filter->decim - 1) / filter->decim ;
+	if (filter->end_seen)
+		m_end = MIN (m_end, filter->out_total) ;
+	m_end = MAX (m_end, m_first) ;
+
+	for (ch = 0 ; ch < channels && m_end > m_first ; ch += 2)
+	{	/*
+		** The filters are real, so two channels can share a transform as
+		** the real and imaginary parts of one complex signal.
+		*/
+		for (k = 0 ; k < fft_len ; k++)
+		{	work [2 * k] = filter->window [k * channels + ch] ;
+			work [2 * k + 1] = (ch + 1 < channels) ? filter->window [k * channels + ch + 1] : 0.0 ;
+			} ;
+
+		fft_transform (work, fft_len, filter->twiddle, 1) ;
+
+		for (p = 0 ; p < phases ; p++)
+		{	m = m_first + ((p * filter->inv_decim) % phases - m_first % phases + phases) % phases ;
+			if (m >= m_end)
+				continue ;
+
+			spectrum = filter->spectra + 2 * (size_t) p * fft_len ;
+			for (k = 0 ; k < fft_len ; k++)
+			{	temp [2 * k] = work [2 * k] * spectrum [2 * k] - work [2 * k + 1] * spectrum [2 * k + 1] ;
+				temp [2 * k + 1] = work [2 * k] * spectrum [2 * k + 1] + work [2 * k + 1] * spectrum [2 * k] ;
+				} ;
+
+			fft_transform (temp, fft_len, filter->twiddle, -1) ;
+
+			for ( ; m < m_end ; m += phases)
+			{	i = m * filter->decim / phases ;
+				n = (int) (i - filter->block_start) + 2 * filter->half_len ;
+
+				out = filter->out_fifo + (m - m_first) * channels + ch ;
+				out [0] = (float) temp [2 * n] ;
+				if (ch + 1 < channels)
+					out [1] = (float) temp [2 * n + 1] ;
+				} ;
+			} ;
+		} ;
+
+	filter->out_index = m_end ;
+	filter->out_start = 0 ;
+	filter->out_frames = (int) (m_end - m_first) ;
+
+	/* The last 2 * half_len frames are the history for the next block. */
+	memmove (filter->window, filter->window + filter->block_len * channels,
+				2 * filter->half_len * channels * sizeof (filter->window [0])) ;
+	filter->window_frames = 2 * filter->half_len ;
+	filter->block_start += filter->block_len ;
+} /* fft_run_block */
+
+/*
+** In place iterative radix-2 complex FFT of interleaved (re, im) pairs.
+** The inverse (sign < 0) is unscaled.
+*/
+static void
+fft_transform (double *data, int len, const double *twiddle, int sign)
+{	double	wr, wi, tr, ti ;
+	int		i, j, bit, size, half, step, start, k, a, b ;
+
+	for (i = 0, j = 0 ; i < len ; i++)
+	{	if (i < j)
+		{	tr = data [2 * i] ;
+			ti = data [2 * i + 1] ;
+			data [2 * i] = data [2 * j] ;
+			data [2 * i + 1] = data [2 * j + 1] ;
+			data [2 * j] = tr ;
+			data [2 * j + 1] = ti ;
+			} ;
+
+		for (bit = len >> 1 ; j & bit ; bit >>= 1)
+			j ^= bit ;
+		j |= bit ;
+		} ;
+
+	for (size = 2 ; size <= len ; size *= 2)
+	{	half = size / 2 ;
+		step = len / size ;
+
+		for (start = 0 ; start < len ; start += size)
+			for (k = 0 ; k < half ; k++)
+			{	wr = twiddle [2 * k * step] ;
+				wi = sign * twiddle [2 * k * step + 1] ;
+
+				a = start + k ;
+				b = a + half ;
+
+				tr = wr * data [2 * b] - wi * data [2 * b + 1] ;
+				ti = wr * data [2 * b + 1] + wi * data [2 * b] ;
+
+				data [2 * b] = data [2 * a] - tr ;
+				data [2 * b + 1] = data [2 * a + 1] - ti ;
+				data [2 * a] += tr ;
+				data [2 * a + 1] += ti ;
+				} ;
+		} ;
+} /* fft_transform */
@@ -17,6 +17,8 @@
 static int linear_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data) ;
 static void linear_reset (SRC_PRIVATE *psrc) ;
 static int linear_copy (SRC_PRIVATE *from, SRC_PRIVATE *to) ;
+static double linear_latency (SRC_PRIVATE *psrc, double src_ratio) ;
+static long linear_predict (SRC_PRIVATE *psrc, double start_ratio, double end_ratio, long input_frames, long output_frames) ;
 
 /*========================================================================================
 */
@@ -41,6 +43,7 @@ static int
 linear_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 {	LINEAR_DATA *priv ;
 	double		src_ratio, input_index, rem ;
+	float		prev ;
 	int			ch ;
 
 	if (data->input_frames <= 0)
@@ -75,7 +78,9 @@ linear_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 		if (priv->in_used + priv->channels * (1.0 + input_index) >= priv->in_count)
 			break ;
 
-		if (priv->out_count > 0 && fabs (psrc->last_ratio - data->src_ratio) > SRC_MIN_RATIO_DIFF)
+		if (psrc->envelope != NULL)
+			src_ratio = envelope_ratio (psrc->envelope, priv->out_gen / priv->channels) ;
+		else if (priv->out_count > 0 && fabs (psrc->last_ratio - data->src_ratio) > SRC_MIN_RATIO_DIFF)
 			src_ratio = psrc->last_ratio + priv->out_gen * (data->src_ratio - psrc->last_ratio) / priv->out_count ;
 
 		for (ch = 0 ; ch < priv->channels ; ch++)
@@ -95,17 +100,15 @@ linear_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 	/* Main processing loop. */
 	while (priv->out_gen < priv->out_count && priv->in_used + priv->channels * input_index < priv->in_count)
 	{
-		if (priv->out_count > 0 && fabs (psrc->last_ratio - data->src_ratio) > SRC_MIN_RATIO_DIFF)
+		if (psrc->envelope != NULL)
+			src_ratio = envelope_ratio (psrc->envelope, priv->out_gen / priv->channels) ;
+		else if (priv->out_count > 0 && fabs (psrc->last_ratio - data->src_ratio) > SRC_MIN_RATIO_DIFF)
 			src_ratio = psrc->last_ratio + priv->out_gen * (data->src_ratio - psrc->last_ratio) / priv->out_count ;
 
-		if (SRC_DEBUG && priv->in_used < priv->channels && input_index < 1.0)
-		{	printf ("Whoops!!!!   in_used : %ld     channels : %d     input_index : %f\n", priv->in_used, priv->channels, input_index) ;
-			exit (1) ;
-			} ;
-
 		for (ch = 0 ; ch < priv->channels ; ch++)
-		{	data->data_out [priv->out_gen] = (float) (data->data_in [priv->in_used - priv->channels + ch] + input_index *
-						(data->data_in [priv->in_used + ch] - data->data_in [priv->in_used - priv->channels + ch])) ;
+		{	/* Before the first frame of this call, the last frame of the one before. */
+			prev = priv->in_used < priv->channels ? priv->last_value [ch] : data->data_in [priv->in_used - priv->channels + ch] ;
+			data->data_out [priv->out_gen] = (float) (prev + input_index * (data->data_in [priv->in_used + ch] - prev)) ;
 			priv->out_gen ++ ;
 			} ;
 
@@ -183,8 +186,11 @@ linear_set_converter (SRC_PRIVATE *psrc, int src_enum)
 
 	psrc->const_process = linear_vari_process ;
 	psrc->vari_process = linear_vari_process ;
+	psrc->envelope_process = linear_vari_process ;
 	psrc->reset = linear_reset ;
 	psrc->copy = linear_copy ;
+	psrc->latency = linear_latency ;
+	psrc->predict = linear_predict ;
 
 	linear_reset (psrc) ;
 
@@ -227,3 +233,52 @@ linear_copy (SRC_PRIVATE *from, SRC_PRIVATE *to)
 
 	return SRC_ERR_NO_ERROR ;
 } /* linear_copy */
+
+static double
+linear_latency (SRC_PRIVATE * UNUSED (psrc), double UNUSED (src_ratio))
+{	/* Output lands one frame behind, on the frame pair it interpolates. */
+	return 1.0 ;
+} /* linear_latency */
+
+static long
+linear_predict (SRC_PRIVATE *psrc, double start_ratio, double end_ratio, long input_frames, long output_frames)
+{	double	src_ratio, input_index, rem ;
+	long	in_count, in_used, out_count, out_gen ;
+	int		channels = psrc->channels ;
+
+	/* Step through the index exactly as linear_vari_process () does. */
+	if (input_frames <= 0)
+		return 0 ;
+
+	in_count = input_frames * channels ;
+	out_count = output_frames * channels ;
+	in_used = out_gen = 0 ;
+
+	src_ratio = start_ratio ;
+	input_index = psrc->last_position ;
+
+	while (input_index < 1.0 && out_gen < out_count)
+	{	if (in_used + channels * (1.0 + input_index) >= in_count)
+			break ;
+		if (out_count > 0 && fabs (start_ratio - end_ratio) > SRC_MIN_RATIO_DIFF)
+			src_ratio = start_ratio + out_gen * (end_ratio - start_ratio) / out_count ;
+		out_gen += channels ;
+		input_index += 1.0 / src_ratio ;
+		} ;
+
+	rem = fmod_one (input_index) ;
+	in_used += channels * lrint (input_index - rem) ;
+	input_index = rem ;
+
+	while (out_gen < out_count && in_used + channels * input_index < in_count)
+	{	if (out_count > 0 && fabs (start_ratio - end_ratio) > SRC_MIN_RATIO_DIFF)
+			src_ratio = start_ratio + out_gen * (end_ratio - start_ratio) / out_count ;
+		out_gen += channels ;
+		input_index += 1.0 / src_ratio ;
+		rem = fmod_one (input_index) ;
+		in_used += channels * lrint (input_index - rem) ;
+		input_index = rem ;
+		} ;
+
+	return out_gen / channels ;
+} /* linear_predict */
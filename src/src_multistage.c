@@ -0,0 +1,517 @@
+/*
+** Copyright (c) 2002-2016, Erik de Castro Lopo <erikd@mega-nerd.com>
+** All rights reserved.
+**
+** This code is released under 2-clause BSD license. Please see the
+** file at : https://github.com/libsndfile/libsamplerate/blob/master/COPYING
+*/
+
+/*
+** Multi-stage conversion for large downsampling ratios.
+**
+** The sinc converters do a constant amount of work per input frame, but the
+** filter they run is as long as the *output* rate demands. Decimating by a
+** large factor therefore runs a very long filter over every input frame.
+** Here the ratio is factored into a chain of zero phase half-band decimators
+** (cheap, short filters with a wide transition band) followed by a single
+** fractional stage using the requested converter at a ratio in (0.25, 0.5].
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "src_config.h"
+#include "common.h"
+
+#define	MULTISTAGE_MAGIC_MARKER	MAKE_MAGIC ('m', 'u', 'l', 't', 'i', 's')
+
+/* Maximum number of frames fed into the first decimator in one go. */
+#define	MULTISTAGE_BLOCK_LEN	4096
+
+/* Maximum number of half-band decimators, a ratio of 1/256 needs seven. */
+#define	MULTISTAGE_MAX_STAGES	8
+
+/* Half-band filters longer than this are never needed for ratios planned here. */
+#define	HALFBAND_MAX_HALF_LEN	63
+
+#define	MULTISTAGE_LINE_LEN		(MULTISTAGE_BLOCK_LEN + 3 * HALFBAND_MAX_HALF_LEN + 4)
+
+/*
+** Frames the decimators may still hold or flush on top of the block fed
+** in. Keeping this much room free in the fifo means it can never overflow.
+*/
+#define	MULTISTAGE_FIFO_MARGIN	(4 * HALFBAND_MAX_HALF_LEN + 8)
+#define	MULTISTAGE_FIFO_LEN		(MULTISTAGE_BLOCK_LEN + MULTISTAGE_FIFO_MARGIN)
+
+#ifndef	M_PI
+#define	M_PI			3.14159265358979323846264338
+#endif
+
+typedef struct
+{	/* Number of taps either side of the centre tap. Always odd. */
+	int		half_len ;
+	int		flushed ;
+
+	/* Frames held in line and index of the next output's centre frame. */
+	long	line_frames, centre ;
+
+	/* coeffs [j] is the weight of the taps at offsets +/- (2 * j + 1). */
+	double	coeffs [(HALFBAND_MAX_HALF_LEN + 1) / 2] ;
+
+	float	*line ;
+} HALFBAND_STAGE ;
+
+typedef struct
+{	int		multistage_magic_marker ;
+
+	int		channels ;
+	int		stage_count ;
+
+	/* Conversion ratio of the final stage is the user ratio times this. */
+	double	ratio_scale ;
+
+	/* The final, fractional stage. */
+	SRC_STATE	*final_state ;
+
+	/* Output of the last decimator, waiting to be consumed by the final stage. */
+	long	fifo_start, fifo_frames ;
+	float	*fifo ;
+
+	float	*scratch ;
+	double	*accum ;
+
+	HALFBAND_STAGE	stages [MULTISTAGE_MAX_STAGES] ;
+
+	char	plan [512] ;
+
+	/* C99 struct flexible array, holds accum followed by the float buffers. */
+	double	storage [] ;
+} MULTISTAGE_DATA ;
+
+static int multistage_process (SRC_PRIVATE *psrc, SRC_DATA *data) ;
+static void multistage_reset (SRC_PRIVATE *psrc) ;
+static int multistage_copy (SRC_PRIVATE *from, SRC_PRIVATE *to) ;
+static void multistage_close (SRC_PRIVATE *psrc) ;
+static double multistage_latency (SRC_PRIVATE *psrc, double src_ratio) ;
+
+static size_t multistage_storage_len (int channels, int stage_count) ;
+static void multistage_set_pointers (MULTISTAGE_DATA *priv) ;
+static void halfband_design (HALFBAND_STAGE *stage, double pass_edge, double atten) ;
+static long halfband_process (HALFBAND_STAGE *stage, int channels, double *accum, const float *in, long in_frames, int flush, float *out) ;
+
+/*----------------------------------------------------------------------------------------
+*/
+
+int
+multistage_set_converter (SRC_PRIVATE *psrc, int converter_type, double src_ratio)
+{	MULTISTAGE_DATA *priv ;
+	SRC_STATE	*final_state ;
+	double		atten, final_ratio ;
+	int			error, k, stage_count ;
+	size_t		plan_len ;
+
+	if (is_bad_src_ratio (src_ratio))
+		return SRC_ERR_BAD_SRC_RATIO ;
+
+	/*
+	** Keep halving while the final stage still downsamples by at least 2.
+	** That leaves a transition band of at least a quarter of the sample
+	** rate for every half-band filter in the chain.
+	*/
+	stage_count = 0 ;
+	final_ratio = src_ratio ;
+	while (final_ratio * 2.0 <= 0.5 && stage_count < MULTISTAGE_MAX_STAGES)
+	{	final_ratio *= 2.0 ;
+		stage_count ++ ;
+		} ;
+
+	if ((final_state = src_new (converter_type, psrc->channels, &error)) == NULL)
+		return error ;
+
+	if (psrc->private_data != NULL)
+	{	free (psrc->private_data) ;
+		psrc->private_data = NULL ;
+		} ;
+
+	if ((priv = ZERO_ALLOC (MULTISTAGE_DATA, sizeof (*priv) + multistage_storage_len (psrc->channels, stage_count))) == NULL)
+	{	src_delete (final_state) ;
+		return SRC_ERR_MALLOC_FAILED ;
+		} ;
+
+	priv->multistage_magic_marker = MULTISTAGE_MAGIC_MARKER ;
+	priv->channels = psrc->channels ;
+	priv->stage_count = stage_count ;
+	priv->ratio_scale = final_ratio / src_ratio ;
+	priv->final_state = final_state ;
+
+	multistage_set_pointers (priv) ;
+
+	/* Stop band attenuation matched to the quality of the final stage. */
+	switch (converter_type)
+	{	case SRC_SINC_BEST_QUALITY :
+			atten = 150.0 ;
+			break ;
+		case SRC_SINC_MEDIUM_QUALITY :
+			atten = 125.0 ;
+			break ;
+		default :
+			atten = 105.0 ;
+			break ;
+		} ;
+
+	/*
+	** Each half-band stage only has to keep aliases out of the band that
+	** survives the final stage, ie out of [0, src_ratio / 2] of the original
+	** input rate. Relative to the input rate of stage k that is 2^k times wider.
+	*/
+	for (k = 0 ; k < stage_count ; k++)
+		halfband_design (&priv->stages [k], 0.5 * src_ratio * (1 << k), atten) ;
+
+	priv->plan [0] = 0 ;
+	for (k = 0 ; k < stage_count ; k++)
+	{	plan_len = strlen (priv->plan) ;
+		snprintf (priv->plan + plan_len, sizeof (priv->plan) - plan_len, "Half-band decimator (%d taps) -> ",
+					2 * priv->stages [k].half_len + 1) ;
+		} ;
+
+	plan_len = strlen (priv->plan) ;
+	snprintf (priv->plan + plan_len, sizeof (priv->plan) - plan_len, "%s (ratio %g)",
+				src_get_name (converter_type), final_ratio) ;
+
+	psrc->private_data = priv ;
+
+	psrc->const_process = multistage_process ;
+	psrc->vari_process = multistage_process ;
+	psrc->reset = multistage_reset ;
+	psrc->copy = multistage_copy ;
+	psrc->close = multistage_close ;
+	psrc->latency = multistage_latency ;
+
+	multistage_reset (psrc) ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* multistage_set_converter */
+
+const char*
+multistage_get_plan (SRC_PRIVATE *psrc)
+{	MULTISTAGE_DATA *priv ;
+
+	if (psrc->vari_process != multistage_process || psrc->private_data == NULL)
+		return NULL ;
+
+	priv = (MULTISTAGE_DATA*) psrc->private_data ;
+
+	return priv->plan ;
+} /* multistage_get_plan */
+
+/*----------------------------------------------------------------------------------------
+*/
+
+static int
+multistage_process (SRC_PRIVATE *psrc, SRC_DATA *data)
+{	MULTISTAGE_DATA *priv ;
+	SRC_PRIVATE	*final ;
+	SRC_DATA	final_data ;
+	const float	*in ;
+	long		in_frames, frames, fifo_space, out_gen, in_used ;
+	int			error, k, flush ;
+
+	if (psrc->private_data == NULL)
+		return SRC_ERR_NO_PRIVATE ;
+
+	priv = (MULTISTAGE_DATA*) psrc->private_data ;
+	final = (SRC_PRIVATE*) priv->final_state ;
+
+	/* The final stage ramps between the same ratios as the facade, only scaled. */
+	final->last_ratio = psrc->last_ratio * priv->ratio_scale ;
+
+	memset (&final_data, 0, sizeof (final_data)) ;
+	final_data.src_ratio = data->src_ratio * priv->ratio_scale ;
+
+	if (priv->stage_count == 0)
+	{	final_data.data_in = data->data_in ;
+		final_data.input_frames = data->input_frames ;
+		final_data.data_out = data->data_out ;
+		final_data.output_frames = data->output_frames ;
+		final_data.end_of_input = data->end_of_input ;
+
+		error = src_process (priv->final_state, &final_data) ;
+
+		data->input_frames_used = final_data.input_frames_used ;
+		data->output_frames_gen = final_data.output_frames_gen ;
+		psrc->last_ratio = final->last_ratio / priv->ratio_scale ;
+
+		return error ;
+		} ;
+
+	in_used = out_gen = 0 ;
+
+	while (out_gen < data->output_frames)
+	{	/* Drain whatever the decimators have already produced. */
+		final_data.data_in = priv->fifo + priv->fifo_start * priv->channels ;
+		final_data.input_frames = priv->fifo_frames ;
+		final_data.data_out = data->data_out + out_gen * priv->channels ;
+		final_data.output_frames = data->output_frames - out_gen ;
+		final_data.end_of_input = priv->stages [priv->stage_count - 1].flushed ;
+
+		if ((error = src_process (priv->final_state, &final_data)) != 0)
+			return error ;
+
+		priv->fifo_start += final_data.input_frames_used ;
+		priv->fifo_frames -= final_data.input_frames_used ;
+		out_gen += final_data.output_frames_gen ;
+
+		if (out_gen >= data->output_frames || final_data.end_of_input)
+			break ;
+
+		/* Move unconsumed decimated audio back to the start of the fifo. */
+		if (priv->fifo_start > 0)
+		{	memmove (priv->fifo, priv->fifo + priv->fifo_start * priv->channels,
+						priv->fifo_frames * priv->channels * sizeof (priv->fifo [0])) ;
+			priv->fifo_start = 0 ;
+			} ;
+
+		fifo_space = MULTISTAGE_FIFO_LEN - priv->fifo_frames - MULTISTAGE_FIFO_MARGIN ;
+		if (fifo_space <= 0)
+		{	if (final_data.input_frames_used == 0 && final_data.output_frames_gen == 0)
+				return SRC_ERR_BAD_INTERNAL_STATE ;
+			continue ;
+			} ;
+
+		in_frames = MIN (data->input_frames - in_used, MULTISTAGE_BLOCK_LEN) ;
+		in_frames = MIN (in_frames, fifo_space << priv->stage_count) ;
+
+		flush = (data->end_of_input && in_used + in_frames == data->input_frames) ;
+
+		if (in_frames == 0 && flush == 0)
+			break ;
+
+		in = data->data_in + in_used * priv->channels ;
+		in_used += in_frames ;
+
+		/* Run the chain, each stage writing over the scratch buffer it read from. */
+		for (k = 0 ; k < priv->stage_count ; k++)
+		{	float *out = (k == priv->stage_count - 1) ? priv->fifo + priv->fifo_frames * priv->channels : priv->scratch ;
+
+			frames = halfband_process (&priv->stages [k], priv->channels, priv->accum, in, in_frames, flush, out) ;
+
+			in = out ;
+			in_frames = frames ;
+			} ;
+
+		priv->fifo_frames += in_frames ;
+		} ;
+
+	psrc->last_ratio = final->last_ratio / priv->ratio_scale ;
+
+	data->input_frames_used = in_used ;
+	data->output_frames_gen = out_gen ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* multistage_process */
+
+static double
+multistage_latency (SRC_PRIVATE *psrc, double src_ratio)
+{	MULTISTAGE_DATA *priv ;
+	SRC_PRIVATE	*final ;
+	double		latency = 0.0 ;
+	int			k ;
+
+	if ((priv = (MULTISTAGE_DATA*) psrc->private_data) == NULL)
+		return 0.0 ;
+
+	/* A decimator needs half_len frames past the centre, plus one for the odd frame. */
+	for (k = 0 ; k < priv->stage_count ; k++)
+		latency += (priv->stages [k].half_len + 1.0) * (1 << k) ;
+
+	final = (SRC_PRIVATE*) priv->final_state ;
+	latency += final->latency (final, src_ratio * priv->ratio_scale) * (1 << priv->stage_count) ;
+
+	return latency ;
+} /* multistage_latency */
+
+static void
+multistage_reset (SRC_PRIVATE *psrc)
+{	MULTISTAGE_DATA *priv ;
+	HALFBAND_STAGE *stage ;
+	int k ;
+
+	priv = (MULTISTAGE_DATA*) psrc->private_data ;
+	if (priv == NULL)
+		return ;
+
+	/* Zero history in front of the first input frame of each stage. */
+	for (k = 0 ; k < priv->stage_count ; k++)
+	{	stage = &priv->stages [k] ;
+		memset (stage->line, 0, stage->half_len * priv->channels * sizeof (stage->line [0])) ;
+		stage->line_frames = stage->centre = stage->half_len ;
+		stage->flushed = SRC_FALSE ;
+		} ;
+
+	priv->fifo_start = priv->fifo_frames = 0 ;
+
+	src_reset (priv->final_state) ;
+} /* multistage_reset */
+
+static int
+multistage_copy (SRC_PRIVATE *from, SRC_PRIVATE *to)
+{	MULTISTAGE_DATA *to_priv, *from_priv ;
+	size_t private_length ;
+	int error ;
+
+	if (from->private_data == NULL)
+		return SRC_ERR_NO_PRIVATE ;
+
+	from_priv = (MULTISTAGE_DATA*) from->private_data ;
+	private_length = sizeof (*from_priv) + multistage_storage_len (from_priv->channels, from_priv->stage_count) ;
+
+	if ((to_priv = ZERO_ALLOC (MULTISTAGE_DATA, private_length)) == NULL)
+		return SRC_ERR_MALLOC_FAILED ;
+
+	memcpy (to_priv, from_priv, private_length) ;
+	multistage_set_pointers (to_priv) ;
+
+	if ((to_priv->final_state = src_clone (from_priv->final_state, &error)) == NULL)
+	{	free (to_priv) ;
+		return error ;
+		} ;
+
+	to->private_data = to_priv ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* multistage_copy */
+
+static void
+multistage_close (SRC_PRIVATE *psrc)
+{	MULTISTAGE_DATA *priv ;
+
+	priv = (MULTISTAGE_DATA*) psrc->private_data ;
+	if (priv == NULL)
+		return ;
+
+	src_delete (priv->final_state) ;
+	free (priv) ;
+	psrc->private_data = NULL ;
+} /* multistage_close */
+
+/*----------------------------------------------------------------------------------------
+*/
+
+static size_t
+multistage_storage_len (int channels, int stage_count)
+{
+	return channels * sizeof (double)
+			+ (stage_count * MULTISTAGE_LINE_LEN + MULTISTAGE_FIFO_LEN + MULTISTAGE_LINE_LEN) * channels * sizeof (float) ;
+} /* multistage_storage_len */
+
+static void
+multistage_set_pointers (MULTISTAGE_DATA *priv)
+{	float *ptr ;
+	int k ;
+
+	priv->accum = priv->storage ;
+
+	ptr = (float*) (priv->storage + priv->channels) ;
+	for (k = 0 ; k < priv->stage_count ; k++)
+	{	priv->stages [k].line = ptr ;
+		ptr += MULTISTAGE_LINE_LEN * priv->channels ;
+		} ;
+
+	priv->fifo = ptr ;
+	ptr += MULTISTAGE_FIFO_LEN * priv->channels ;
+
+	priv->scratch = ptr ;
+} /* multistage_set_pointers */
+
+static double
+bessel_i0 (double x)
+{	double sum = 1.0, term = 1.0 ;
+	int k ;
+
+	for (k = 1 ; k < 200 ; k++)
+	{	term *= (0.5 * x / k) * (0.5 * x / k) ;
+		sum += term ;
+		if (term < 1e-21 * sum)
+			break ;
+		} ;
+
+	return sum ;
+} /* bessel_i0 */
+
+static void
+halfband_design (HALFBAND_STAGE *stage, double pass_edge, double atten)
+{	double beta, width, sum, x ;
+	int half_win, j ;
+
+	/* Kaiser window design, transition band is symmetric about a quarter of the sample rate. */
+	width = 0.5 - 2.0 * pass_edge ;
+	beta = 0.1102 * (atten - 8.7) ;
+
+	/* Window half width, even so the outermost (zero) tap of a half-band filter lands on it. */
+	half_win = (int) ceil ((atten - 7.95) / (14.36 * width) / 2.0) ;
+	half_win += half_win & 1 ;
+	half_win = MIN (half_win, HALFBAND_MAX_HALF_LEN + 1) ;
+
+	stage->half_len = half_win - 1 ;
+
+	sum = 0.0 ;
+	for (j = 0 ; 2 * j + 1 <= stage->half_len ; j++)
+	{	x = (2 * j + 1) / (double) half_win ;
+		stage->coeffs [j] = sin (M_PI * (2 * j + 1) / 2.0) / (M_PI * (2 * j + 1))
+								* bessel_i0 (beta * sqrt (1.0 - x * x)) / bessel_i0 (beta) ;
+		sum += 2.0 * stage->coeffs [j] ;
+		} ;
+
+	/* Unity gain at DC. The centre tap is 0.5 so the odd taps must sum to 0.5. */
+	for (j = 0 ; 2 * j + 1 <= stage->half_len ; j++)
+		stage->coeffs [j] *= 0.5 / sum ;
+} /* halfband_design */
+
+static long
+halfband_process (HALFBAND_STAGE *stage, int channels, double *accum, const float *in, long in_frames, int flush, float *out)
+{	const float *left, *right ;
+	long		out_frames, shift ;
+	int			ch, j ;
+
+	memcpy (stage->line + stage->line_frames * channels, in, in_frames * channels * sizeof (stage->line [0])) ;
+	stage->line_frames += in_frames ;
+
+	if (flush && stage->flushed == SRC_FALSE)
+	{	/* Zeros after the last input frame so the last outputs can be centred on it. */
+		memset (stage->line + stage->line_frames * channels, 0, stage->half_len * channels * sizeof (stage->line [0])) ;
+		stage->line_frames += stage->half_len ;
+		stage->flushed = SRC_TRUE ;
+		} ;
+
+	out_frames = 0 ;
+	while (stage->centre + stage->half_len < stage->line_frames)
+	{	for (ch = 0 ; ch < channels ; ch++)
+			accum [ch] = 0.5 * stage->line [stage->centre * channels + ch] ;
+
+		for (j = 0 ; 2 * j + 1 <= stage->half_len ; j++)
+		{	left = stage->line + (stage->centre - 2 * j - 1) * channels ;
+			right = stage->line + (stage->centre + 2 * j + 1) * channels ;
+
+			for (ch = 0 ; ch < channels ; ch++)
+				accum [ch] += stage->coeffs [j] * (left [ch] + right [ch]) ;
+			} ;
+
+		for (ch = 0 ; ch < channels ; ch++)
+			out [out_frames * channels + ch] = (float) accum [ch] ;
+
+		out_frames ++ ;
+		stage->centre += 2 ;
+		} ;
+
+	/* Keep only the history needed for the next output. */
+	shift = MIN (stage->centre - stage->half_len, stage->line_frames) ;
+	if (shift > 0)
+	{	memmove (stage->line, stage->line + shift * channels, (stage->line_frames - shift) * channels * sizeof (stage->line [0])) ;
+		stage->line_frames -= shift ;
+		stage->centre -= shift ;
+		} ;
+
+	return out_frames ;
+} /* halfband_process */
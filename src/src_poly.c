@@ -0,0 +1,447 @@
+/*
+** Copyright (c) 2002-2016, Erik de Castro Lopo <erikd@mega-nerd.com>
+** All rights reserved.
+**
+** This code is released under 2-clause BSD license. Please see the
+** file at : https://github.com/libsndfile/libsamplerate/blob/master/COPYING
+*/
+
+/*
+** Polynomial interpolators, sitting between SRC_LINEAR and SRC_SINC_FASTEST.
+**
+** Every output frame is a weighted sum of the 4 or 6 input frames around it.
+** The weights only depend on the fractional position, so they are computed
+** once per output frame and then applied to all channels.
+**
+** The optimal interpolators use the 2x oversampling designs from Olli
+** Niemitalo's "Polynomial Interpolators for High-Quality Resampling of
+** Oversampled Audio". They trade exact interpolation at the input frames
+** for much lower aliasing of content below a quarter of the sample rate.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "src_config.h"
+#include "common.h"
+
+#define	POLY_MAGIC_MARKER	MAKE_MAGIC ('p', 'o', 'l', 'y', 'n', 'o')
+
+#define	POLY_MAX_POINTS		6
+
+typedef struct
+{	int		poly_magic_marker ;
+	int		channels ;
+	int		converter ;
+	int		points ;
+	int		reset ;
+
+	/* The points - 1 input frames before the next input, oldest first. */
+	float	history [] ;
+} POLY_DATA ;
+
+static int poly_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data) ;
+static void poly_reset (SRC_PRIVATE *psrc) ;
+static int poly_copy (SRC_PRIVATE *from, SRC_PRIVATE *to) ;
+static double poly_latency (SRC_PRIVATE *psrc, double src_ratio) ;
+static long poly_predict (SRC_PRIVATE *psrc, double start_ratio, double end_ratio, long input_frames, long output_frames) ;
+
+/* Niemitalo optimal 2x z-form coefficients, c [power][pair]. */
+static const double optimal4_coeffs [4][2] =
+{	{	0.45868970870461956,	0.04131401926395584 },
+	{	0.48068024766578432,	0.17577925564495955 },
+	{	-0.246185007019907091,	0.24614027139700284 },
+	{	-0.36030925263849456,	0.10174985775982505 }
+} ;
+
+static const double optimal6_coeffs [6][3] =
+{	{	0.40513396007145713,	0.09251794438424393,	0.00234806603570670 },
+	{	0.28342806338906690,	0.21703277024054901,	0.01309294748731515 },
+	{	-0.191337682540351941,	0.16187844487943592,	0.02946017143111912 },
+	{	-0.16471626190554542,	-0.00154547203542499,	0.03399271444851909 },
+	{	0.03845798729588149,	-0.05712936104242644,	0.01866750929921070 },
+	{	0.04317950185225609,	-0.01802814255926417,	0.00152170021558204 }
+} ;
+
+/*----------------------------------------------------------------------------------------
+*/
+
+const char*
+poly_get_name (int src_enum)
+{
+	switch (src_enum)
+	{	case SRC_CUBIC_HERMITE :
+			return "Cubic Hermite Interpolator" ;
+
+		case SRC_LAGRANGE_6POINT :
+			return "6-point Lagrange Interpolator" ;
+
+		case SRC_OPTIMAL_4POINT :
+			return "Optimal 4-point Interpolator" ;
+
+		case SRC_OPTIMAL_6POINT :
+			return "Optimal 6-point Interpolator" ;
+
+		default : break ;
+		} ;
+
+	return NULL ;
+} /* poly_get_name */
+
+const char*
+poly_get_description (int src_enum)
+{
+	switch (src_enum)
+	{	case SRC_CUBIC_HERMITE :
+			return "4-point cubic Hermite (Catmull-Rom) interpolator, very fast, better than linear." ;
+
+		case SRC_LAGRANGE_6POINT :
+			return "6-point 5th order Lagrange interpolator, fast, medium quality." ;
+
+		case SRC_OPTIMAL_4POINT :
+			return "4-point 3rd order interpolator optimal for 2x oversampled input, very fast." ;
+
+		case SRC_OPTIMAL_6POINT :
+			return "6-point 5th order interpolator optimal for 2x oversampled input, fast." ;
+
+		default : break ;
+		} ;
+
+	return NULL ;
+} /* poly_get_description */
+
+int
+poly_set_converter (SRC_PRIVATE *psrc, int src_enum)
+{	POLY_DATA *priv ;
+	int points ;
+
+	switch (src_enum)
+	{	case SRC_CUBIC_HERMITE :
+		case SRC_OPTIMAL_4POINT :
+			points = 4 ;
+			break ;
+
+		case SRC_LAGRANGE_6POINT :
+		case SRC_OPTIMAL_6POINT :
+			points = 6 ;
+			break ;
+
+		default :
+			return SRC_ERR_BAD_CONVERTER ;
+		} ;
+
+	if (psrc->private_data != NULL)
+	{	free (psrc->private_data) ;
+		psrc->private_data = NULL ;
+		} ;
+
+	if ((priv = ZERO_ALLOC (POLY_DATA, sizeof (*priv) + (points - 1) * psrc->channels * sizeof (float))) == NULL)
+		return SRC_ERR_MALLOC_FAILED ;
+
+	priv->poly_magic_marker = POLY_MAGIC_MARKER ;
+	priv->channels = psrc->channels ;
+	priv->converter = src_enum ;
+	priv->points = points ;
+
+	psrc->private_data = priv ;
+
+	psrc->const_process = poly_vari_process ;
+	psrc->vari_process = poly_vari_process ;
+	psrc->envelope_process = poly_vari_process ;
+	psrc->reset = poly_reset ;
+	psrc->copy = poly_copy ;
+	psrc->latency = poly_latency ;
+	psrc->predict = poly_predict ;
+
+	poly_reset (psrc) ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* poly_set_converter */
+
+static void
+poly_reset (SRC_PRIVATE *psrc)
+{	POLY_DATA *priv ;
+
+	priv = (POLY_DATA*) psrc->private_data ;
+	if (priv == NULL)
+		return ;
+
+	priv->reset = 1 ;
+	memset (priv->history, 0, (priv->points - 1) * priv->channels * sizeof (priv->history [0])) ;
+} /* poly_reset */
+
+static int
+poly_copy (SRC_PRIVATE *from, SRC_PRIVATE *to)
+{	POLY_DATA	*to_priv, *from_priv ;
+	size_t		private_size ;
+
+	if (from->private_data == NULL)
+		return SRC_ERR_NO_PRIVATE ;
+
+	from_priv = (POLY_DATA*) from->private_data ;
+	private_size = sizeof (*from_priv) + (from_priv->points - 1) * from_priv->channels * sizeof (float) ;
+
+	if ((to_priv = ZERO_ALLOC (POLY_DATA, private_size)) == NULL)
+		return SRC_ERR_MALLOC_FAILED ;
+
+	memcpy (to_priv, from_priv, private_size) ;
+	to->private_data = to_priv ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* poly_copy */
+
+static double
+poly_latency (SRC_PRIVATE *psrc, double UNUSED (src_ratio))
+{	POLY_DATA *priv ;
+
+	if ((priv = (POLY_DATA*) psrc->private_data) == NULL)
+		return 0.0 ;
+
+	/* One frame behind like linear, plus the taps needed after that frame. */
+	return priv->points / 2 ;
+} /* poly_latency */
+
+static long
+poly_predict (SRC_PRIVATE *psrc, double start_ratio, double end_ratio, long input_frames, long output_frames)
+{	POLY_DATA	*priv ;
+	double		src_ratio, position ;
+	long		out_gen ;
+	int			half ;
+
+	if ((priv = (POLY_DATA*) psrc->private_data) == NULL)
+		return -SRC_ERR_NO_PRIVATE ;
+
+	if (input_frames <= 0)
+		return 0 ;
+
+	/* Step through the position exactly as poly_vari_process () does. */
+	half = priv->points / 2 ;
+	src_ratio = start_ratio ;
+	position = psrc->last_position - 1.0 ;
+
+	for (out_gen = 0 ; out_gen < output_frames ; out_gen++)
+	{	if (lrint (floor (position)) + half >= input_frames)
+			break ;
+		if (output_frames > 0 && fabs (start_ratio - end_ratio) > SRC_MIN_RATIO_DIFF)
+			src_ratio = start_ratio + out_gen * (end_ratio - start_ratio) / output_frames ;
+		position += 1.0 / src_ratio ;
+		} ;
+
+	return out_gen ;
+} /* poly_predict */
+
+/*========================================================================================
+*/
+
+/*
+** Weights for the input frames at offsets 1 - points / 2 ... points / 2 from
+** the frame at or before the output position, t being the fractional part.
+*/
+static inline void
+poly_weights (int converter, double t, double *w)
+{	double a, b, c, d, e, f, z, z2, even [3], odd [3] ;
+	int k ;
+
+	switch (converter)
+	{	case SRC_CUBIC_HERMITE :
+			w [0] = t * (-0.5 + t * (1.0 - 0.5 * t)) ;
+			w [1] = 1.0 + t * t * (-2.5 + 1.5 * t) ;
+			w [2] = t * (0.5 + t * (2.0 - 1.5 * t)) ;
+			w [3] = t * t * (-0.5 + 0.5 * t) ;
+			return ;
+
+		case SRC_LAGRANGE_6POINT :
+			a = t + 2.0 ;
+			b = t + 1.0 ;
+			c = t ;
+			d = t - 1.0 ;
+			e = t - 2.0 ;
+			f = t - 3.0 ;
+			w [0] = -b * c * d * e * f * (1.0 / 120.0) ;
+			w [1] = a * c * d * e * f * (1.0 / 24.0) ;
+			w [2] = -a * b * d * e * f * (1.0 / 12.0) ;
+			w [3] = a * b * c * e * f * (1.0 / 12.0) ;
+			w [4] = -a * b * c * d * f * (1.0 / 24.0) ;
+			w [5] = a * b * c * d * e * (1.0 / 120.0) ;
+			return ;
+
+		case SRC_OPTIMAL_4POINT :
+			z = t - 0.5 ;
+			z2 = z * z ;
+			for (k = 0 ; k < 2 ; k++)
+			{	even [k] = optimal4_coeffs [0][k] + z2 * optimal4_coeffs [2][k] ;
+				odd [k] = z * (optimal4_coeffs [1][k] + z2 * optimal4_coeffs [3][k]) ;
+				} ;
+			w [0] = even [1] - odd [1] ;
+			w [1] = even [0] - odd [0] ;
+			w [2] = even [0] + odd [0] ;
+			w [3] = even [1] + odd [1] ;
+			return ;
+
+		case SRC_OPTIMAL_6POINT :
+			z = t - 0.5 ;
+			z2 = z * z ;
+			for (k = 0 ; k < 3 ; k++)
+			{	even [k] = optimal6_coeffs [0][k] + z2 * (optimal6_coeffs [2][k] + z2 * optimal6_coeffs [4][k]) ;
+				odd [k] = z * (optimal6_coeffs [1][k] + z2 * (optimal6_coeffs [3][k] + z2 * optimal6_coeffs [5][k])) ;
+				} ;
+			w [0] = even [2] - odd [2] ;
+			w [1] = even [1] - odd [1] ;
+			w [2] = even [0] - odd [0] ;
+			w [3] = even [0] + odd [0] ;
+			w [4] = even [1] + odd [1] ;
+			w [5] = even [2] + odd [2] ;
+			return ;
+
+		default :
+			break ;
+		} ;
+} /* poly_weights */
+
+static inline void
+poly_apply (const double *w, int points, const float *in, int channels, float *out)
+{	double	sum ;
+	int		ch, j ;
+
+	for (ch = 0 ; ch < channels ; ch++)
+	{	sum = 0.0 ;
+		for (j = 0 ; j < points ; j++)
+			sum += w [j] * in [j * channels + ch] ;
+		out [ch] = (float) sum ;
+		} ;
+} /* poly_apply */
+
+/*
+** The common cases get their own copy of poly_apply () with the loop counts
+** known at compile time, so they are fully unrolled or vectorised.
+*/
+static inline void
+poly_output (const double *w, int points, const float *in, int channels, float *out)
+{
+	if (points == 4)
+	{	switch (channels)
+		{	case 1 : poly_apply (w, 4, in, 1, out) ; return ;
+			case 2 : poly_apply (w, 4, in, 2, out) ; return ;
+			case 4 : poly_apply (w, 4, in, 4, out) ; return ;
+			case 6 : poly_apply (w, 4, in, 6, out) ; return ;
+			default : poly_apply (w, 4, in, channels, out) ; return ;
+			} ;
+		} ;
+
+	switch (channels)
+	{	case 1 : poly_apply (w, 6, in, 1, out) ; return ;
+		case 2 : poly_apply (w, 6, in, 2, out) ; return ;
+		case 4 : poly_apply (w, 6, in, 4, out) ; return ;
+		case 6 : poly_apply (w, 6, in, 6, out) ; return ;
+		default : poly_apply (w, points, in, channels, out) ; return ;
+		} ;
+} /* poly_output */
+
+/*
+** Input frame index relative to data_in, with negative indices in the
+** history and indices past the end holding the last frame.
+*/
+static inline float
+poly_fetch (const POLY_DATA *priv, const SRC_DATA *data, long index, int ch)
+{
+	if (index >= data->input_frames)
+		index = data->input_frames - 1 ;
+
+	if (index < 0)
+		return priv->history [(priv->points - 1 + index) * priv->channels + ch] ;
+
+	return data->data_in [index * priv->channels + ch] ;
+} /* poly_fetch */
+
+static int
+poly_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
+{	POLY_DATA	*priv ;
+	double		src_ratio, position, weights [POLY_MAX_POINTS], sum ;
+	float		*out ;
+	long		in_frames, out_gen, k, first, used ;
+	int			channels, half, ch, j ;
+
+	if (psrc->private_data == NULL)
+		return SRC_ERR_NO_PRIVATE ;
+
+	priv = (POLY_DATA*) psrc->private_data ;
+	channels = priv->channels ;
+	half = priv->points / 2 ;
+	in_frames = data->input_frames ;
+
+	/* At the end of input the frames still in the history may have output pending. */
+	if (in_frames <= 0 && (data->end_of_input == 0 || priv->reset))
+		return SRC_ERR_NO_ERROR ;
+
+	if (priv->reset)
+	{	/* If we have just been reset, the history is the first frame repeated. */
+		for (j = 0 ; j < priv->points - 1 ; j++)
+			for (ch = 0 ; ch < channels ; ch++)
+				priv->history [j * channels + ch] = data->data_in [ch] ;
+		priv->reset = 0 ;
+		} ;
+
+	src_ratio = psrc->last_ratio ;
+
+	if (is_bad_src_ratio (src_ratio))
+		return SRC_ERR_BAD_INTERNAL_STATE ;
+
+	/* As for the linear converter, last_position is relative to the frame before data_in. */
+	position = psrc->last_position - 1.0 ;
+
+	for (out_gen = 0 ; out_gen < data->output_frames ; out_gen++)
+	{	k = lrint (floor (position)) ;
+
+		/* Need all the taps, except at the end of input where the last frame is held. */
+		if (k + half >= in_frames && (data->end_of_input == 0 || k + 1 >= in_frames))
+			break ;
+
+		if (psrc->envelope != NULL)
+			src_ratio = envelope_ratio (psrc->envelope, out_gen) ;
+		else if (data->output_frames > 0 && fabs (psrc->last_ratio - data->src_ratio) > SRC_MIN_RATIO_DIFF)
+			src_ratio = psrc->last_ratio + out_gen * (data->src_ratio - psrc->last_ratio) / data->output_frames ;
+
+		poly_weights (priv->converter, position - k, weights) ;
+
+		first = k + 1 - half ;
+		out = data->data_out + out_gen * channels ;
+
+		if (first >= 0 && k + half < in_frames)
+			poly_output (weights, priv->points, data->data_in + first * channels, channels, out) ;
+		else
+		{	for (ch = 0 ; ch < channels ; ch++)
+			{	sum = 0.0 ;
+				for (j = 0 ; j < priv->points ; j++)
+					sum += weights [j] * poly_fetch (priv, data, first + j, ch) ;
+				out [ch] = (float) sum ;
+				} ;
+			} ;
+
+		/* Figure out the next index. */
+		position += 1.0 / src_ratio ;
+		} ;
+
+	/* Consume everything the next output does not need, keeping the tail as history. */
+	k = lrint (floor (position)) ;
+	used = MIN (in_frames, MAX (0, k + half)) ;
+
+	/* Output still pending at the end of input needs the last frame passed in again. */
+	if (data->end_of_input && k + 1 < in_frames)
+		used = MIN (used, in_frames - 1) ;
+
+	for (j = 1 - priv->points ; j < 0 ; j++)
+		for (ch = 0 ; ch < channels ; ch++)
+			priv->history [(priv->points - 1 + j) * channels + ch] = poly_fetch (priv, data, used + j, ch) ;
+
+	psrc->last_position = position - used + 1.0 ;
+
+	/* Save current ratio rather then target ratio. */
+	psrc->last_ratio = src_ratio ;
+
+	data->input_frames_used = used ;
+	data->output_frames_gen = out_gen ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* poly_vari_process */
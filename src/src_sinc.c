@@ -8,12 +8,26 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <math.h>
+#include <limits.h>
 
 #include "src_config.h"
 #include "common.h"
 
+#if (HAVE_MADVISE && ENABLE_HUGE_PAGES)
+#include <sys/mman.h>
+#endif
+
+#if (ENABLE_HALF_COEFFS && defined (__F16C__))
+#include <immintrin.h>
+#endif
+
+#if (HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
 #define	SINC_MAGIC_MARKER	MAKE_MAGIC (' ', 's', 'i', 'n', 'c', ' ')
 
 /*========================================================================================
@@ -25,12 +39,73 @@
 #define	FP_ONE					((double) (((increment_t) 1) << SHIFT_BITS))
 #define	INV_FP_ONE				(1.0 / FP_ONE)
 
+/* Input blocks shorter than this many half filter lengths are not read in place. */
+#define	SINC_DIRECT_MIN_LEN		8
+
+/* Cubic segments per zero crossing of the filter, at least, with ENABLE_CUBIC_COEFFS. */
+#define	SINC_CUBIC_SPANS		32
+
+/* Most taps of the interpolated kernel. Longer filters go through the half loops. */
+#define	SINC_KERNEL_LEN			2048
+
+/* Outputs filtered together by calc_output_block (). */
+#define	SINC_BLOCK_LEN			4
+
+/*
+** Input window, over all channels, that sinc_direct_process () expects to
+** stay in cache. Wider buses are filtered a group of channels at a time.
+** Half of a 256 kB L2, the smallest in common use, leaves the rest for the
+** output, the kernel and the coefficients. Override it with -D to tune for
+** a particular cache.
+*/
+#ifndef SINC_TILE_BYTES
+#define	SINC_TILE_BYTES			(128 * 1024)
+#endif
+
+/* Alignment of SINC_FILTER and of the start of its buffer, a cache line. */
+#define	SINC_ALIGN				64
+
+/* States at least this long are aligned to and backed by huge pages where possible. */
+#define	SINC_HUGE_PAGE_LEN		(2 * 1024 * 1024)
+
 /*========================================================================================
 */
 
 typedef int32_t increment_t ;
 typedef float	coeff_t ;
 
+#if (ENABLE_HALF_COEFFS)
+
+/*
+** A filter coefficient and the step to the next one, as IEEE half precision
+** bit patterns. Half the cache footprint of coeff_t pairs, at the cost of
+** the coefficient error limiting the SNR to somewhere near 75 dB.
+*/
+typedef struct
+{	uint16_t	c, dc ;
+} coeff_pair_t ;
+
+#else
+
+/*
+** A filter coefficient and the step to the next one, so interpolating between
+** them is one multiply-add on a single load.
+*/
+typedef struct
+{	coeff_t	c, dc ;
+} coeff_pair_t ;
+
+#endif
+
+/*
+** The filter over 1 << cubic_shift stored coefficients as a cubic in x, the
+** fraction of the way across, a [0] + x * (a [1] + x * (a [2] + x * a [3])).
+** Used instead of the pairs when built with ENABLE_CUBIC_COEFFS.
+*/
+typedef struct
+{	coeff_t	a [4] ;
+} coeff_cubic_t ;
+
 #include "fastest_coeffs.h"
 #include "mid_qual_coeffs.h"
 #include "high_qual_coeffs.h"
@@ -48,13 +123,72 @@ typedef struct
 
 	coeff_t const	*coeffs ;
 
+	/* The coefficients as (c, dc) pairs, shared by every state of the converter. */
+	coeff_pair_t const	*coeff_pairs ;
+
+	/*
+	** With ENABLE_CUBIC_COEFFS, shared cubic segments instead, each
+	** spanning 1 << cubic_shift coefficients, and the scale from the fixed
+	** point offset into a segment to x.
+	*/
+	coeff_cubic_t const	*coeff_cubics ;
+	int		cubic_shift ;
+	double	cubic_scale ;
+
 	int		b_current, b_end, b_real_end, b_len ;
 
-	/* Sure hope noone does more than 128 channels at once. */
-	double left_calc [128], right_calc [128] ;
+	/* Samples in front of buffer that start it on a SINC_ALIGN boundary. */
+	int		b_pad ;
+
+	/*
+	** Exact ratio rational_num / rational_den set by src_new_rational (), or
+	** zero. The position of the next output is then rational_phase / rational_num
+	** of a frame after b_current and advances by whole integers. Each output
+	** moves rational_frames frames and rational_step phase on. Its filter
+	** index, rational_phase * rational_inc / rational_num, is kept as
+	** rational_index plus rational_index_rem / rational_num and moves on by
+	** the quotient and remainder of rational_step * rational_inc / rational_num.
+	*/
+	int		rational_num, rational_den, rational_phase ;
+	int		rational_frames, rational_step ;
+	increment_t	rational_inc, rational_index, rational_index_step ;
+	int		rational_index_rem, rational_index_rem_step ;
+	int		(*rational_process) (SRC_PRIVATE *psrc, SRC_DATA *data) ;
+
+	/* The process function for the channel count, always working from buffer. */
+	int		(*buffer_process) (SRC_PRIVATE *psrc, SRC_DATA *data) ;
+
+	/*
+	** The main loop of sinc_direct_process () built for this converter and
+	** channel count, used at ratios of one or more. NULL when there is none.
+	*/
+	void	(*fixed_loop) (SRC_PRIVATE *psrc, SRC_DATA *data, int half_filter_len,
+					long *current_ptr, double *input_index_ptr, long *out_gen_ptr) ;
+
+	/*
+	** Scratch after the buffer for the filter of the current output, oldest
+	** input frame first, at most kernel_len taps. For calc_output_block () it
+	** holds SINC_BLOCK_LEN filters interleaved, the taps for each input frame
+	** together. Only sinc_direct_process () uses it.
+	*/
+	double	*kernel ;
+	int		kernel_len ;
+
+	/* One sum per channel for calc_output_multi () and friends, after the kernel. */
+	double	*left_calc ;
+
+	/*
+	** Channels sinc_direct_process () last filtered together, zero before it
+	** has run, and its description for sinc_get_plan ().
+	*/
+	int		group_width ;
+	char	plan [64] ;
+
+	/* Points b_pad samples into storage. */
+	float	*buffer ;
 
 	/* C99 struct flexible array. */
-	float	buffer [] ;
+	float	storage [] ;
 } SINC_FILTER ;
 
 static int sinc_multichan_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data) ;
@@ -63,10 +197,20 @@ static int sinc_quad_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data) ;
 static int sinc_stereo_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data) ;
 static int sinc_mono_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data) ;
 
+static int sinc_rational_process (SRC_PRIVATE *psrc, SRC_DATA *data) ;
+static int sinc_direct_process (SRC_PRIVATE *psrc, SRC_DATA *data) ;
+
 static int prepare_data (SINC_FILTER *filter, SRC_DATA *data, int half_filter_chan_len) WARN_UNUSED ;
+static size_t sinc_private_length (int channels, int b_pad, int b_len, int kernel_len) ;
+static void sinc_set_pointers (SINC_FILTER *filter) ;
+static SINC_FILTER *sinc_alloc (size_t length) ;
+static int sinc_set_coeffs (SINC_FILTER *filter, int src_enum) ;
+static void sinc_set_fixed_loop (SINC_FILTER *filter, int src_enum) ;
 
 static void sinc_reset (SRC_PRIVATE *psrc) ;
 static int sinc_copy (SRC_PRIVATE *from, SRC_PRIVATE *to) ;
+static double sinc_latency (SRC_PRIVATE *psrc, double src_ratio) ;
+static long sinc_predict (SRC_PRIVATE *psrc, double start_ratio, double end_ratio, long input_frames, long output_frames) ;
 
 static inline increment_t
 double_to_fp (double x)
@@ -93,6 +237,143 @@ fp_to_double (increment_t x)
 {	return fp_fraction_part (x) * INV_FP_ONE ;
 } /* fp_to_double */
 
+#if (ENABLE_HALF_COEFFS)
+
+static inline float
+half_to_float (uint16_t half)
+{
+#if defined (__F16C__)
+	return _cvtsh_ss (half) ;
+#else
+	uint32_t	bits, mant = half & 0x3FF ;
+	int			exp = (half >> 10) & 0x1F ;
+	float		value ;
+
+	/* Subnormal, or zero. The filters have no infinities or NaNs. */
+	if (exp == 0)
+	{	value = mant * (1.0f / (1 << 24)) ;
+		return (half & 0x8000) ? -value : value ;
+		} ;
+
+	bits = ((uint32_t) (half & 0x8000) << 16) | ((uint32_t) (exp + 127 - 15) << 23) | (mant << 13) ;
+	memcpy (&value, &bits, sizeof (value)) ;
+
+	return value ;
+#endif
+} /* half_to_float */
+
+/* Shift mant right, rounding to nearest and ties to even. */
+static inline uint32_t
+round_shift (uint32_t mant, int shift)
+{	uint32_t half = 1u << (shift - 1), rest = mant & ((half << 1) - 1) ;
+
+	mant >>= shift ;
+	if (rest > half || (rest == half && (mant & 1)))
+		mant ++ ;
+
+	return mant ;
+} /* round_shift */
+
+static uint16_t
+float_to_half (float value)
+{	uint32_t	bits, mant, sign ;
+	int			exp ;
+
+	memcpy (&bits, &value, sizeof (bits)) ;
+	sign = (bits >> 16) & 0x8000 ;
+	exp = (int) ((bits >> 23) & 0xFF) - 127 + 15 ;
+	mant = bits & 0x7FFFFF ;
+
+	if (exp >= 31)
+		return sign | 0x7BFF ;	/* Clamp to the largest half. */
+
+	if (exp <= 0)
+	{	/* Subnormal. */
+		if (exp < -10)
+			return sign ;
+		return sign | round_shift (mant | 0x800000, 14 - exp) ;
+		} ;
+
+	/* A carry out of the mantissa bumps the exponent, as it should. */
+	return sign | (((uint32_t) exp << 10) + round_shift (mant, 13)) ;
+} /* float_to_half */
+
+#endif
+
+/* The coefficient at fraction of the way from pair to the next one. */
+static inline double
+pair_coeff (const coeff_pair_t *pair, double fraction)
+{
+#if (ENABLE_HALF_COEFFS)
+	return half_to_float (pair->c) + fraction * half_to_float (pair->dc) ;
+#else
+	return pair->c + fraction * pair->dc ;
+#endif
+} /* pair_coeff */
+
+/* The filter at filter_index, in whole coefficients from the centre. */
+static inline double
+sinc_coeff (const SINC_FILTER *filter, increment_t filter_index)
+{
+#if (ENABLE_CUBIC_COEFFS)
+	const coeff_cubic_t	*cubic ;
+	double				x ;
+
+	cubic = filter->coeff_cubics + (filter_index >> (SHIFT_BITS + filter->cubic_shift)) ;
+	x = (filter_index & ((MAKE_INCREMENT_T (1) << (SHIFT_BITS + filter->cubic_shift)) - 1)) * filter->cubic_scale ;
+
+	return cubic->a [0] + x * (cubic->a [1] + x * (cubic->a [2] + x * cubic->a [3])) ;
+#else
+	return pair_coeff (filter->coeff_pairs + fp_to_int (filter_index), fp_to_double (filter_index)) ;
+#endif
+} /* sinc_coeff */
+
+/* On to the next output in rational mode, with integer adds only. */
+static inline void
+rational_advance (SINC_FILTER *filter)
+{	int frames = filter->rational_frames ;
+
+	filter->rational_phase += filter->rational_step ;
+	filter->rational_index += filter->rational_index_step ;
+	filter->rational_index_rem += filter->rational_index_rem_step ;
+
+	if (filter->rational_index_rem >= filter->rational_num)
+	{	filter->rational_index_rem -= filter->rational_num ;
+		filter->rational_index ++ ;
+		} ;
+
+	/* A whole frame of phase is rational_inc of filter index, remainder and all. */
+	if (filter->rational_phase >= filter->rational_num)
+	{	filter->rational_phase -= filter->rational_num ;
+		filter->rational_index -= filter->rational_inc ;
+		frames ++ ;
+		} ;
+
+	filter->b_current += filter->channels * frames ;
+	if (filter->b_current >= filter->b_len)
+		filter->b_current -= filter->b_len ;
+} /* rational_advance */
+
+/* Sets the filter index accumulators from rational_phase. */
+static void
+rational_set_index (SINC_FILTER *filter)
+{	int64_t index ;
+
+	if (filter->rational_num == 0)
+		return ;
+
+	index = (int64_t) filter->rational_phase * filter->rational_inc ;
+	filter->rational_index = (increment_t) (index / filter->rational_num) ;
+	filter->rational_index_rem = (int) (index % filter->rational_num) ;
+} /* rational_set_index */
+
+static inline int
+rational_at_end (const SINC_FILTER *filter)
+{	/* Output m is the last if (m + 1) * den <= input_frames * num. */
+	return ((int64_t) (filter->b_real_end - filter->b_current) / filter->channels) * filter->rational_num
+			< (int64_t) filter->rational_phase + filter->rational_den ;
+} /* rational_at_end */
+
 
 /*----------------------------------------------------------------------------------------
 */
@@ -138,9 +419,11 @@ sinc_get_description (int src_enum)
 
 int
 sinc_set_converter (SRC_PRIVATE *psrc, int src_enum)
-{	SINC_FILTER *filter, temp_filter ;
+{	SINC_FILTER *filter ;
+	const float *coeffs ;
 	increment_t count ;
 	uint32_t bits ;
+	int		coeff_half_len, index_inc, b_len, b_pad, kernel_len, cubic_shift = 0, error ;
 
 	/* Quick sanity check. */
 	if (SHIFT_BITS >= sizeof (increment_t) * 8 - 1)
@@ -151,14 +434,7 @@ sinc_set_converter (SRC_PRIVATE *psrc, int src_enum)
 		psrc->private_data = NULL ;
 		} ;
 
-	memset (&temp_filter, 0, sizeof (temp_filter)) ;
-
-	temp_filter.sinc_magic_marker = SINC_MAGIC_MARKER ;
-	temp_filter.channels = psrc->channels ;
-
-	if (psrc->channels > ARRAY_LEN (temp_filter.left_calc))
-		return SRC_ERR_BAD_CHANNEL_COUNT ;
-	else if (psrc->channels == 1)
+	if (psrc->channels == 1)
 	{	psrc->const_process = sinc_mono_vari_process ;
 		psrc->vari_process = sinc_mono_vari_process ;
 		}
@@ -181,62 +457,128 @@ sinc_set_converter (SRC_PRIVATE *psrc, int src_enum)
 	{	psrc->const_process = sinc_multichan_vari_process ;
 		psrc->vari_process = sinc_multichan_vari_process ;
 		} ;
+
 	psrc->reset = sinc_reset ;
 	psrc->copy = sinc_copy ;
+	psrc->latency = sinc_latency ;
 
-	switch (src_enum)
-	{	case SRC_SINC_FASTEST :
-				temp_filter.coeffs = fastest_coeffs.coeffs ;
-				temp_filter.coeff_half_len = ARRAY_LEN (fastest_coeffs.coeffs) - 2 ;
-				temp_filter.index_inc = fastest_coeffs.increment ;
-				break ;
-
-		case SRC_SINC_MEDIUM_QUALITY :
-				temp_filter.coeffs = slow_mid_qual_coeffs.coeffs ;
-				temp_filter.coeff_half_len = ARRAY_LEN (slow_mid_qual_coeffs.coeffs) - 2 ;
-				temp_filter.index_inc = slow_mid_qual_coeffs.increment ;
-				break ;
-
-		case SRC_SINC_BEST_QUALITY :
-				temp_filter.coeffs = slow_high_qual_coeffs.coeffs ;
-				temp_filter.coeff_half_len = ARRAY_LEN (slow_high_qual_coeffs.coeffs) - 2 ;
-				temp_filter.index_inc = slow_high_qual_coeffs.increment ;
-				break ;
-
-		default :
-				return SRC_ERR_BAD_CONVERTER ;
-		} ;
+	if ((error = sinc_get_coeffs (src_enum, &coeffs, &coeff_half_len, &index_inc)) != SRC_ERR_NO_ERROR)
+		return error ;
 
 	/*
 	** FIXME : This needs to be looked at more closely to see if there is
 	** a better way. Need to look at prepare_data () at the same time.
 	*/
 
-	temp_filter.b_len = 3 * (int) lrint ((temp_filter.coeff_half_len + 2.0) / temp_filter.index_inc * SRC_MAX_RATIO + 1) ;
-	temp_filter.b_len = MAX (temp_filter.b_len, 4096) ;
-	temp_filter.b_len *= temp_filter.channels ;
-	temp_filter.b_len += 1 ; // There is a <= check against samples_in_hand requiring a buffer bigger than the calculation above
+	b_len = 3 * (int) lrint ((coeff_half_len + 2.0) / index_inc * SRC_MAX_RATIO + 1) ;
+	b_len = MAX (b_len, 4096) ;
 
-	if ((filter = ZERO_ALLOC (SINC_FILTER, sizeof (SINC_FILTER) + sizeof (filter->buffer [0]) * (temp_filter.b_len + temp_filter.channels))) == NULL)
-		return SRC_ERR_MALLOC_FAILED ;
+	/* Any channel count will do, as long as the buffer stays indexable by int. */
+	if (psrc->channels > (INT_MAX - SINC_ALIGN) / b_len - 1)
+		return SRC_ERR_BAD_CHANNEL_COUNT ;
 
-	*filter = temp_filter ;
-	memset (&temp_filter, 0xEE, sizeof (temp_filter)) ;
+	b_len *= psrc->channels ;
+	b_len += 1 ; // There is a <= check against samples_in_hand requiring a buffer bigger than the calculation above
 
-	psrc->private_data = filter ;
+	b_pad = (SINC_ALIGN - offsetof (SINC_FILTER, storage) % SINC_ALIGN) % SINC_ALIGN / sizeof (filter->storage [0]) ;
 
-	sinc_reset (psrc) ;
+	/* The widest filter there can be, both halves, unless that is past SINC_KERNEL_LEN. */
+	kernel_len = MIN (2 * (int) lrint ((coeff_half_len + 2.0) / index_inc * SRC_MAX_RATIO) + 4, SINC_KERNEL_LEN) ;
+
+#if (ENABLE_CUBIC_COEFFS)
+	/* The widest cubic segments that still give SINC_CUBIC_SPANS per zero crossing. */
+	while ((2 << cubic_shift) * SINC_CUBIC_SPANS <= index_inc)
+		cubic_shift ++ ;
+#endif
 
-	count = filter->coeff_half_len ;
+	count = coeff_half_len ;
 	for (bits = 0 ; (MAKE_INCREMENT_T (1) << bits) < count ; bits++)
 		count |= (MAKE_INCREMENT_T (1) << bits) ;
 
 	if (bits + SHIFT_BITS - 1 >= (int) (sizeof (increment_t) * 8))
 		return SRC_ERR_FILTER_LEN ;
 
+	if ((filter = sinc_alloc (sinc_private_length (psrc->channels, b_pad, b_len, kernel_len))) == NULL)
+		return SRC_ERR_MALLOC_FAILED ;
+
+	filter->sinc_magic_marker = SINC_MAGIC_MARKER ;
+	filter->channels = psrc->channels ;
+	filter->coeffs = coeffs ;
+	filter->coeff_half_len = coeff_half_len ;
+	filter->index_inc = index_inc ;
+	filter->cubic_shift = cubic_shift ;
+	filter->b_len = b_len ;
+	filter->b_pad = b_pad ;
+	filter->kernel_len = kernel_len ;
+
+	sinc_set_pointers (filter) ;
+
+	/* Only hand the filter over once nothing else can fail. */
+	if (sinc_set_coeffs (filter, src_enum) != SRC_ERR_NO_ERROR)
+	{	free (filter) ;
+		return SRC_ERR_MALLOC_FAILED ;
+		} ;
+
+	/* At a constant ratio, long input blocks can be filtered where they are. */
+	filter->buffer_process = psrc->vari_process ;
+	psrc->const_process = sinc_direct_process ;
+	psrc->envelope_process = psrc->vari_process ;
+
+	psrc->private_data = filter ;
+
+	sinc_set_fixed_loop (filter, src_enum) ;
+	psrc->predict = sinc_predict ;
+
+	sinc_reset (psrc) ;
+
 	return SRC_ERR_NO_ERROR ;
 } /* sinc_set_converter */
 
+const char*
+sinc_get_plan (SRC_PRIVATE *psrc)
+{	SINC_FILTER *filter ;
+
+	if (psrc->const_process != sinc_direct_process || (filter = (SINC_FILTER*) psrc->private_data) == NULL)
+		return NULL ;
+
+	if (filter->group_width == 0)
+		return NULL ;
+
+	snprintf (filter->plan, sizeof (filter->plan), "Channel groups of %d, %d byte tile",
+				filter->group_width, SINC_TILE_BYTES) ;
+
+	return filter->plan ;
+} /* sinc_get_plan */
+
+int
+sinc_get_coeffs (int src_enum, const float **coeffs, int *coeff_half_len, int *index_inc)
+{
+	switch (src_enum)
+	{	case SRC_SINC_FASTEST :
+				*coeffs = fastest_coeffs.coeffs ;
+				*coeff_half_len = ARRAY_LEN (fastest_coeffs.coeffs) - 2 ;
+				*index_inc = fastest_coeffs.increment ;
+				break ;
+
+		case SRC_SINC_MEDIUM_QUALITY :
+				*coeffs = slow_mid_qual_coeffs.coeffs ;
+				*coeff_half_len = ARRAY_LEN (slow_mid_qual_coeffs.coeffs) - 2 ;
+				*index_inc = slow_mid_qual_coeffs.increment ;
+				break ;
+
+		case SRC_SINC_BEST_QUALITY :
+				*coeffs = slow_high_qual_coeffs.coeffs ;
+				*coeff_half_len = ARRAY_LEN (slow_high_qual_coeffs.coeffs) - 2 ;
+				*index_inc = slow_high_qual_coeffs.increment ;
+				break ;
+
+		default :
+				return SRC_ERR_BAD_CONVERTER ;
+		} ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* sinc_get_coeffs */
+
 static void
 sinc_reset (SRC_PRIVATE *psrc)
 {	SINC_FILTER *filter ;
@@ -249,8 +591,10 @@ sinc_reset (SRC_PRIVATE *psrc)
 	filter->b_real_end = -1 ;
 
 	filter->src_ratio = filter->input_index = 0.0 ;
+	filter->rational_phase = 0 ;
+	rational_set_index (filter) ;
 
-	memset (filter->buffer, 0, filter->b_len * sizeof (filter->buffer [0])) ;
+	memset (filter->storage, 0, (filter->b_pad + filter->b_len) * sizeof (filter->buffer [0])) ;
 
 	/* Set this for a sanity check */
 	memset (filter->buffer + filter->b_len, 0xAA, filter->channels * sizeof (filter->buffer [0])) ;
@@ -264,26 +608,587 @@ sinc_copy (SRC_PRIVATE *from, SRC_PRIVATE *to)
 
 	SINC_FILTER *to_filter = NULL ;
 	SINC_FILTER* from_filter = (SINC_FILTER*) from->private_data ;
-	size_t private_length = sizeof (SINC_FILTER) + sizeof (from_filter->buffer [0]) * (from_filter->b_len + from_filter->channels) ;
+	size_t private_length = sinc_private_length (from_filter->channels, from_filter->b_pad, from_filter->b_len, from_filter->kernel_len) ;
 
-	if ((to_filter = ZERO_ALLOC (SINC_FILTER, private_length)) == NULL)
+	if ((to_filter = sinc_alloc (private_length)) == NULL)
 		return SRC_ERR_MALLOC_FAILED ;
 
 	memcpy (to_filter, from_filter, private_length) ;
+	sinc_set_pointers (to_filter) ;
 	to->private_data = to_filter ;
 
 	return SRC_ERR_NO_ERROR ;
 } /* sinc_copy */
 
+/* Samples from the start of buffer to the kernel, past the buffer and its guard frame. */
+static inline int
+sinc_kernel_offset (int channels, int b_len)
+{	int align = SINC_ALIGN / sizeof (float) ;
+
+	return (b_len + channels + align - 1) / align * align ;
+} /* sinc_kernel_offset */
+
+/* Doubles of kernel, room for SINC_BLOCK_LEN where calc_output_block () runs. */
+static inline int
+sinc_kernel_size (int channels, int kernel_len)
+{	return channels <= 2 ? SINC_BLOCK_LEN * kernel_len : kernel_len ;
+} /* sinc_kernel_size */
+
+static size_t
+sinc_private_length (int channels, int b_pad, int b_len, int kernel_len)
+{	/* The padding, the buffer plus a guard frame, the kernel, then the sums. */
+	return sizeof (SINC_FILTER) + sizeof (float) * (b_pad + sinc_kernel_offset (channels, b_len))
+				+ sizeof (double) * (sinc_kernel_size (channels, kernel_len) + channels) ;
+} /* sinc_private_length */
+
+static void
+sinc_set_pointers (SINC_FILTER *filter)
+{	filter->buffer = filter->storage + filter->b_pad ;
+	filter->kernel = (double *) (filter->buffer + sinc_kernel_offset (filter->channels, filter->b_len)) ;
+	filter->left_calc = filter->kernel + sinc_kernel_size (filter->channels, filter->kernel_len) ;
+} /* sinc_set_pointers */
+
+/*
+** Zeroed storage for a SINC_FILTER, SINC_ALIGN aligned so the buffer is too.
+** Large states, as best quality with many channels makes, are aligned to a
+** huge page and marked for transparent huge pages before they are touched,
+** to cut TLB misses when the filter sweeps the buffer. Freed with free ().
+*/
+static SINC_FILTER *
+sinc_alloc (size_t length)
+{
+#if (HAVE_POSIX_MEMALIGN)
+	void	*ptr ;
+	size_t	align = SINC_ALIGN ;
+
+#if (HAVE_MADVISE && ENABLE_HUGE_PAGES && defined (MADV_HUGEPAGE))
+	if (length >= SINC_HUGE_PAGE_LEN)
+		align = SINC_HUGE_PAGE_LEN ;
+#endif
+
+	if (posix_memalign (&ptr, align, length) != 0)
+		return NULL ;
+
+#if (HAVE_MADVISE && ENABLE_HUGE_PAGES && defined (MADV_HUGEPAGE))
+	/* Only a hint, failure just leaves normal pages. */
+	if (length >= SINC_HUGE_PAGE_LEN)
+		madvise (ptr, length, MADV_HUGEPAGE) ;
+#endif
+
+	memset (ptr, 0, length) ;
+
+	return (SINC_FILTER *) ptr ;
+#else
+	return ZERO_ALLOC (SINC_FILTER, length) ;
+#endif
+} /* sinc_alloc */
+
+#if (ENABLE_CUBIC_COEFFS)
+
+/* The stored filter, even about zero and zero past its end. */
+static double
+sinc_table_value (const SINC_FILTER *filter, int k)
+{	if (k < 0)
+		k = -k ;
+
+	return k <= filter->coeff_half_len + 1 ? filter->coeffs [k] : 0.0 ;
+} /* sinc_table_value */
+
+/* The slope of the stored filter at coefficient k, per coefficient. */
+static double
+sinc_table_slope (const SINC_FILTER *filter, int k)
+{	return (sinc_table_value (filter, k - 2) - 8.0 * sinc_table_value (filter, k - 1)
+				+ 8.0 * sinc_table_value (filter, k + 1) - sinc_table_value (filter, k + 2)) / 12.0 ;
+} /* sinc_table_slope */
+
+/*
+** Fit a cubic Hermite segment between every 1 << cubic_shift'th stored
+** coefficient, matching the values and the slopes of the table at each end.
+** Segment s covers coefficients s << cubic_shift to (s + 1) << cubic_shift.
+*/
+static void *
+sinc_build_table (const SINC_FILTER *filter)
+{	coeff_cubic_t *cubics ;
+	double	p0, p1, m0, m1 ;
+	int		k, span, count ;
+
+	span = 1 << filter->cubic_shift ;
+	count = (filter->coeff_half_len >> filter->cubic_shift) + 1 ;
+
+	if ((cubics = ZERO_ALLOC (coeff_cubic_t, count * sizeof (coeff_cubic_t))) == NULL)
+		return NULL ;
+
+	for (k = 0 ; k < count ; k++)
+	{	p0 = sinc_table_value (filter, k * span) ;
+		p1 = sinc_table_value (filter, (k + 1) * span) ;
+		m0 = span * sinc_table_slope (filter, k * span) ;
+		m1 = span * sinc_table_slope (filter, (k + 1) * span) ;
+
+		cubics [k].a [0] = p0 ;
+		cubics [k].a [1] = m0 ;
+		cubics [k].a [2] = 3.0 * (p1 - p0) - 2.0 * m0 - m1 ;
+		cubics [k].a [3] = 2.0 * (p0 - p1) + m0 + m1 ;
+		} ;
+
+	return cubics ;
+} /* sinc_build_table */
+
+#else
+
+static void *
+sinc_build_table (const SINC_FILTER *filter)
+{	coeff_pair_t *pairs ;
+	int k ;
+
+	if ((pairs = ZERO_ALLOC (coeff_pair_t, (filter->coeff_half_len + 2) * sizeof (coeff_pair_t))) == NULL)
+		return NULL ;
+
+#if (ENABLE_HALF_COEFFS)
+	/* The step is taken between the rounded coefficients, so the pairs join up. */
+	for (k = 0 ; k < filter->coeff_half_len + 1 ; k++)
+	{	pairs [k].c = float_to_half (filter->coeffs [k]) ;
+		pairs [k].dc = float_to_half (half_to_float (float_to_half (filter->coeffs [k + 1])) - half_to_float (pairs [k].c)) ;
+		} ;
+
+	pairs [k].c = float_to_half (filter->coeffs [k]) ;
+	pairs [k].dc = 0 ;
+#else
+	/* The difference is taken in coeff_t, just as the kernels used to. */
+	for (k = 0 ; k < filter->coeff_half_len + 1 ; k++)
+	{	pairs [k].c = filter->coeffs [k] ;
+		pairs [k].dc = filter->coeffs [k + 1] - filter->coeffs [k] ;
+		} ;
+
+	pairs [k].c = filter->coeffs [k] ;
+	pairs [k].dc = 0.0f ;
+#endif
+
+	return pairs ;
+} /* sinc_build_table */
+
+#endif
+
+/*
+** The stored filter of each converter, indexed by its src_enum, built by the
+** first state that needs it and then shared by every state, and clones, for
+** the life of the process. States only ever read it. Building it is guarded
+** so that states can be created from several threads at once.
+*/
+static void *sinc_tables [SRC_SINC_FASTEST + 1] ;
+
+#if (HAVE_PTHREAD)
+static pthread_mutex_t sinc_table_lock = PTHREAD_MUTEX_INITIALIZER ;
+#define	SINC_TABLE_LOCK()		pthread_mutex_lock (&sinc_table_lock)
+#define	SINC_TABLE_UNLOCK()		pthread_mutex_unlock (&sinc_table_lock)
+#elif (HAVE_STDATOMIC_H)
+static atomic_flag sinc_table_lock = ATOMIC_FLAG_INIT ;
+#define	SINC_TABLE_LOCK()		while (atomic_flag_test_and_set_explicit (&sinc_table_lock, memory_order_acquire))
+#define	SINC_TABLE_UNLOCK()		atomic_flag_clear_explicit (&sinc_table_lock, memory_order_release)
+#else
+#define	SINC_TABLE_LOCK()
+#define	SINC_TABLE_UNLOCK()
+#endif
+
+static int
+sinc_set_coeffs (SINC_FILTER *filter, int src_enum)
+{	void *table ;
+
+	SINC_TABLE_LOCK () ;
+	if (sinc_tables [src_enum] == NULL)
+		sinc_tables [src_enum] = sinc_build_table (filter) ;
+	table = sinc_tables [src_enum] ;
+	SINC_TABLE_UNLOCK () ;
+
+	if (table == NULL)
+		return SRC_ERR_MALLOC_FAILED ;
+
+#if (ENABLE_CUBIC_COEFFS)
+	filter->coeff_cubics = (const coeff_cubic_t *) table ;
+	filter->cubic_scale = INV_FP_ONE / (1 << filter->cubic_shift) ;
+#else
+	filter->coeff_pairs = (const coeff_pair_t *) table ;
+#endif
+
+	return SRC_ERR_NO_ERROR ;
+} /* sinc_set_coeffs */
+
+static double
+sinc_latency (SRC_PRIVATE *psrc, double src_ratio)
+{	SINC_FILTER *filter ;
+	double count ;
+
+	if ((filter = (SINC_FILTER*) psrc->private_data) == NULL)
+		return 0.0 ;
+
+	/*
+	** Output is not delayed as such, prepare_data () starts with silence
+	** instead, but an output frame only comes out once the right hand half
+	** of the filter is in hand. Same sum as in the process functions.
+	*/
+	count = (filter->coeff_half_len + 2.0) / filter->index_inc ;
+	if (src_ratio < 1.0)
+		count /= src_ratio ;
+
+	return lrint (count) + 1.0 ;
+} /* sinc_latency */
+
+static long
+sinc_predict (SRC_PRIVATE *psrc, double start_ratio, double end_ratio, long input_frames, long output_frames)
+{	SINC_FILTER *filter ;
+	double	src_ratio, input_index, count, terminate, rem ;
+	long	available, current, out_count, out_gen ;
+	int		half_filter_chan_len, channels, phase ;
+
+	if ((filter = (SINC_FILTER*) psrc->private_data) == NULL)
+		return -SRC_ERR_NO_PRIVATE ;
+
+	channels = filter->channels ;
+
+	if (filter->rational_num > 0)
+	{	if (fabs (end_ratio - (1.0 * filter->rational_num) / filter->rational_den) > 1e-9 * end_ratio)
+			return -SRC_ERR_NO_VARIABLE_RATIO ;
+		start_ratio = end_ratio = (1.0 * filter->rational_num) / filter->rational_den ;
+		} ;
+
+	/* Same as in the process functions. */
+	count = (filter->coeff_half_len + 2.0) / filter->index_inc ;
+	if (MIN (start_ratio, end_ratio) < 1.0)
+		count /= MIN (start_ratio, end_ratio) ;
+	half_filter_chan_len = channels * (int) (lrint (count) + 1) ;
+
+	/*
+	** An output is made while more than half_filter_chan_len samples are in
+	** hand from the frame at or before it on, whether they are buffered or
+	** filtered where they lie by sinc_direct_process (). Once the end of
+	** input has been seen nothing more is loaded.
+	*/
+	available = (filter->b_end - filter->b_current + filter->b_len) % filter->b_len ;
+	if (filter->b_real_end < 0)
+		available = (filter->b_current == 0 ? 0 : available) + input_frames * channels ;
+
+	src_ratio = start_ratio ;
+	input_index = psrc->last_position ;
+	rem = fmod_one (input_index) ;
+	current = channels * lrint (input_index - rem) ;
+	input_index = rem ;
+
+	phase = filter->rational_phase ;
+	terminate = 1.0 / src_ratio + 1e-20 ;
+	out_count = output_frames * channels ;
+
+	for (out_gen = 0 ; out_gen < out_count ; out_gen += channels)
+	{	if (available - current <= half_filter_chan_len)
+			break ;
+
+		if (filter->b_real_end >= 0)
+		{	if (filter->rational_num > 0)
+			{	if (((int64_t) (filter->b_real_end - filter->b_current - current) / channels) * filter->rational_num
+						< (int64_t) phase + filter->rational_den)
+					break ;
+				}
+			else if (channels == 1 ? filter->b_current + current + input_index + terminate > filter->b_real_end
+						: filter->b_current + current + input_index + terminate >= filter->b_real_end)
+				break ;
+			} ;
+
+		if (out_count > 0 && fabs (start_ratio - end_ratio) > 1e-10)
+			src_ratio = start_ratio + out_gen * (end_ratio - start_ratio) / out_count ;
+
+		if (filter->rational_num > 0)
+		{	phase += filter->rational_step ;
+			current += channels * filter->rational_frames ;
+			if (phase >= filter->rational_num)
+			{	phase -= filter->rational_num ;
+				current += channels ;
+				} ;
+			}
+		else
+		{	input_index += 1.0 / src_ratio ;
+			rem = fmod_one (input_index) ;
+			current += channels * lrint (input_index - rem) ;
+			input_index = rem ;
+			} ;
+		} ;
+
+	return out_gen / channels ;
+} /* sinc_predict */
+
+int
+sinc_set_rational (SRC_PRIVATE *psrc, int num, int den)
+{	SINC_FILTER *filter ;
+	int64_t		step ;
+	double		ratio ;
+
+	filter = (SINC_FILTER*) psrc->private_data ;
+	if (filter == NULL || filter->sinc_magic_marker != SINC_MAGIC_MARKER)
+		return SRC_ERR_BAD_CONVERTER ;
+
+	filter->rational_num = num ;
+	filter->rational_den = den ;
+	filter->rational_frames = den / num ;
+	filter->rational_step = den % num ;
+
+	/* The increment the process functions work out for this ratio. */
+	ratio = (1.0 * num) / den ;
+	filter->rational_inc = double_to_fp (filter->index_inc * (ratio < 1.0 ? ratio : 1.0)) ;
+
+	step = (int64_t) filter->rational_step * filter->rational_inc ;
+	filter->rational_index_step = (increment_t) (step / num) ;
+	filter->rational_index_rem_step = (int) (step % num) ;
+	rational_set_index (filter) ;
+	filter->rational_process = filter->buffer_process ;
+
+	psrc->const_process = sinc_rational_process ;
+	psrc->vari_process = sinc_rational_process ;
+	psrc->envelope_process = NULL ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* sinc_set_rational */
+
+static int
+sinc_rational_process (SRC_PRIVATE *psrc, SRC_DATA *data)
+{	SINC_FILTER *filter ;
+	SRC_DATA	exact ;
+	double		ratio ;
+	int			error ;
+
+	if ((filter = (SINC_FILTER*) psrc->private_data) == NULL)
+		return SRC_ERR_NO_PRIVATE ;
+
+	ratio = (1.0 * filter->rational_num) / filter->rational_den ;
+	if (fabs (data->src_ratio - ratio) > 1e-9 * ratio)
+		return SRC_ERR_NO_VARIABLE_RATIO ;
+
+	/* Run the usual loop at exactly num / den, which then steps in integers. */
+	exact = *data ;
+	exact.src_ratio = ratio ;
+	psrc->last_ratio = ratio ;
+
+	error = filter->rational_process (psrc, &exact) ;
+
+	data->input_frames_used = exact.input_frames_used ;
+	data->output_frames_gen = exact.output_frames_gen ;
+
+	return error ;
+} /* sinc_rational_process */
+
 /*========================================================================================
 **	Beware all ye who dare pass this point. There be dragons here.
 */
 
+/* Taps of the left half of the filter, before the output's own frame. */
+static inline int
+sinc_left_count (const SINC_FILTER *filter, increment_t increment, increment_t start_filter_index)
+{	return (int_to_fp (filter->coeff_half_len) - start_filter_index) / increment ;
+} /* sinc_left_count */
+
+/*
+** Interpolate the taps for one output into every stride'th element of kernel,
+** in the order of the input frames they apply to, so both halves of the filter
+** become one straight dot product. Returns the number of taps and sets *first
+** to the offset of the oldest frame from the output's frame, or returns zero
+** when the kernel does not fit in room taps and the two half loops are needed.
+*/
+static inline int
+sinc_make_kernel (const SINC_FILTER *filter, double *kernel, int stride, int room, increment_t increment, increment_t start_filter_index, int *first)
+{	increment_t	filter_index, max_filter_index, right_index ;
+	int			left_count, right_count, k, pos ;
+
+	max_filter_index = int_to_fp (filter->coeff_half_len) ;
+
+	left_count = sinc_left_count (filter, increment, start_filter_index) ;
+	right_index = increment - start_filter_index ;
+	right_count = (max_filter_index - right_index) / increment ;
+
+	if (left_count + right_count + 2 > room)
+		return 0 ;
+
+	/* The left half, walked just as in calc_output_single (). */
+	filter_index = start_filter_index + left_count * increment ;
+	k = 0 ;
+	do
+	{	kernel [stride * k++] = sinc_coeff (filter, filter_index) ;
+		filter_index -= increment ;
+		}
+	while (filter_index >= MAKE_INCREMENT_T (0)) ;
+
+	/*
+	** The right half runs backwards from frame right_count + 1. The left half
+	** may have reached past frame 0 when start_filter_index is a whole
+	** increment, but then the right half stops short of it.
+	*/
+	filter_index = right_index + right_count * increment ;
+	pos = left_count + 1 + right_count ;
+	do
+	{	kernel [stride * pos--] = sinc_coeff (filter, filter_index) ;
+		filter_index -= increment ;
+		}
+	while (filter_index > MAKE_INCREMENT_T (0)) ;
+
+	while (pos >= k)
+		kernel [stride * pos--] = 0.0 ;
+
+	*first = -left_count ;
+
+	return left_count + right_count + 2 ;
+} /* sinc_make_kernel */
+
+/*
+** One dot product per channel over taps contiguous frames. Called with a
+** constant channel count, the inner loop unrolls away.
+*/
+static inline void
+sinc_apply_kernel (const double *kernel, int taps, const float *in, int channels, double *sum)
+{	int k, ch ;
+
+	for (ch = 0 ; ch < channels ; ch++)
+		sum [ch] = 0.0 ;
+
+	for (k = 0 ; k < taps ; k++)
+		for (ch = 0 ; ch < channels ; ch++)
+			sum [ch] += kernel [k] * in [k * channels + ch] ;
+} /* sinc_apply_kernel */
+
+/* Channels handled together by sinc_apply_kernel_wide (). */
+#define	SINC_LANES				8
+
+/*
+** sinc_apply_kernel () for any channel count, taking the first channels of
+** frames stride samples apart. Each tap's coefficient is shared by all
+** channels, so the channels go SINC_LANES at a time with the sums held in
+** locals, which the compiler can keep in vector registers. Each sum is still
+** taken in tap order, as sinc_apply_kernel () does.
+*/
+static inline void
+sinc_apply_kernel_wide (const double *kernel, int taps, const float *in, int stride, int channels, double *sum)
+{	double	lane [SINC_LANES] ;
+	int		k, ch, base, rest ;
+
+	for (base = 0 ; base + SINC_LANES <= channels ; base += SINC_LANES)
+	{	for (ch = 0 ; ch < SINC_LANES ; ch++)
+			lane [ch] = 0.0 ;
+
+		for (k = 0 ; k < taps ; k++)
+			for (ch = 0 ; ch < SINC_LANES ; ch++)
+				lane [ch] += kernel [k] * in [k * stride + base + ch] ;
+
+		for (ch = 0 ; ch < SINC_LANES ; ch++)
+			sum [base + ch] = lane [ch] ;
+		} ;
+
+	if ((rest = channels - base) > 0)
+	{	/* The odd channels left over, one at a time. */
+		in += base ;
+		sum += base ;
+
+		for (ch = 0 ; ch < rest ; ch++)
+			sum [ch] = 0.0 ;
+
+		for (k = 0 ; k < taps ; k++)
+			for (ch = 0 ; ch < rest ; ch++)
+				sum [ch] += kernel [k] * in [k * stride + ch] ;
+		} ;
+} /* sinc_apply_kernel_wide */
+
+/*
+** One output of a wide bus from the built kernel, for sinc_direct_process ()
+** where the ratio stays put. in points at the output's frame. Returns zero,
+** having done nothing, when the kernel does not fit and the half loops of
+** calc_output_multi () are needed.
+*/
+static inline int
+calc_output_kernel (SINC_FILTER *filter, const float *in, increment_t increment, increment_t start_filter_index,
+			int channels, double scale, float *output)
+{	double	*sum = filter->left_calc ;
+	int		taps, first, ch ;
+
+	if ((taps = sinc_make_kernel (filter, filter->kernel, 1, filter->kernel_len, increment, start_filter_index, &first)) == 0)
+		return 0 ;
+
+	/* Literal channel counts for the common wide buses. */
+	switch (channels)
+	{	case 8 :
+			sinc_apply_kernel (filter->kernel, taps, in + 8 * first, 8, sum) ;
+			break ;
+		case 16 :
+			sinc_apply_kernel_wide (filter->kernel, taps, in + 16 * first, 16, 16, sum) ;
+			break ;
+		default :
+			if (channels < SINC_LANES)
+				sinc_apply_kernel (filter->kernel, taps, in + channels * first, channels, sum) ;
+			else
+				sinc_apply_kernel_wide (filter->kernel, taps, in + channels * first, channels, channels, sum) ;
+			break ;
+		} ;
+
+	for (ch = 0 ; ch < channels ; ch++)
+		output [ch] = (float) (scale * sum [ch]) ;
+
+	return 1 ;
+} /* calc_output_kernel */
+
+/*
+** SINC_BLOCK_LEN consecutive outputs at a constant ratio, at input frames
+** pos [] of in. Each kernel is laid out against the oldest frame any of them
+** needs, padded with zeros, so every input sample is loaded once and feeds
+** all the outputs, with their taps side by side. Adding the zeros leaves each
+** sum exactly as the single output path has it. Returns zero, having done
+** nothing, when the block does not fit.
+*/
+static inline int
+calc_output_block (SINC_FILTER *filter, const float *in, const long *pos, const increment_t *start_filter_index,
+			increment_t increment, int channels, double scale, float *output)
+{	double	*kernel = filter->kernel, sum [2][SINC_BLOCK_LEN], x ;
+	long	start ;
+	int		len [SINC_BLOCK_LEN], j, k, ch, shift, taps, first, max_len = 0 ;
+
+	start = pos [0] - sinc_left_count (filter, increment, start_filter_index [0]) ;
+
+	for (j = 0 ; j < SINC_BLOCK_LEN ; j++)
+	{	shift = pos [j] - sinc_left_count (filter, increment, start_filter_index [j]) - start ;
+
+		if (shift < 0 || shift >= filter->kernel_len)
+			return 0 ;
+
+		taps = sinc_make_kernel (filter, kernel + SINC_BLOCK_LEN * shift + j, SINC_BLOCK_LEN, filter->kernel_len - shift, increment, start_filter_index [j], &first) ;
+		if (taps == 0)
+			return 0 ;
+
+		for (k = 0 ; k < shift ; k++)
+			kernel [SINC_BLOCK_LEN * k + j] = 0.0 ;
+
+		len [j] = shift + taps ;
+		max_len = MAX (max_len, len [j]) ;
+		} ;
+
+	for (j = 0 ; j < SINC_BLOCK_LEN ; j++)
+	{	for (k = len [j] ; k < max_len ; k++)
+			kernel [SINC_BLOCK_LEN * k + j] = 0.0 ;
+		for (ch = 0 ; ch < channels ; ch++)
+			sum [ch][j] = 0.0 ;
+		} ;
+
+	in += start * channels ;
+
+	for (k = 0 ; k < max_len ; k++)
+		for (ch = 0 ; ch < channels ; ch++)
+		{	x = in [k * channels + ch] ;
+			for (j = 0 ; j < SINC_BLOCK_LEN ; j++)
+				sum [ch][j] += kernel [SINC_BLOCK_LEN * k + j] * x ;
+			} ;
+
+	for (j = 0 ; j < SINC_BLOCK_LEN ; j++)
+		for (ch = 0 ; ch < channels ; ch++)
+			output [j * channels + ch] = (float) (scale * sum [ch][j]) ;
+
+	return SINC_BLOCK_LEN ;
+} /* calc_output_block */
+
 static inline double
-calc_output_single (SINC_FILTER *filter, increment_t increment, increment_t start_filter_index)
-{	double		fraction, left, right, icoeff ;
+calc_output_single (SINC_FILTER *filter, const float *buffer, int b_current, increment_t increment, increment_t start_filter_index)
+{	double		sum, icoeff ;
 	increment_t	filter_index, max_filter_index ;
-	int			data_index, coeff_count, indx ;
+	int			data_index, coeff_count ;
 
 	/* Convert input parameters into fixed point. */
 	max_filter_index = int_to_fp (filter->coeff_half_len) ;
@@ -292,45 +1197,55 @@ calc_output_single (SINC_FILTER *filter, increment_t increment, increment_t star
 	filter_index = start_filter_index ;
 	coeff_count = (max_filter_index - filter_index) / increment ;
 	filter_index = filter_index + coeff_count * increment ;
-	data_index = filter->b_current - coeff_count ;
+	data_index = b_current - coeff_count ;
 
-	left = 0.0 ;
-	do
-	{	if (data_index >= 0) /* Avoid underflow access to filter->buffer. */
-		{	fraction = fp_to_double (filter_index) ;
-			indx = fp_to_int (filter_index) ;
+	/*
+	** Right after the ratio drops the filter can reach back past the history
+	** the buffer holds. That input counts as silence, so start from the
+	** first tap that lands in the buffer, once per output rather than testing
+	** every tap.
+	*/
+	if (data_index < 0)
+	{	filter_index -= (-data_index) * increment ;
+		data_index = 0 ;
+		} ;
 
-			icoeff = filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
+	sum = 0.0 ;
+	do
+	{	icoeff = sinc_coeff (filter, filter_index) ;
 
-			left += icoeff * filter->buffer [data_index] ;
-			}  ;
+		sum += icoeff * buffer [data_index] ;
 
 		filter_index -= increment ;
 		data_index = data_index + 1 ;
 		}
 	while (filter_index >= MAKE_INCREMENT_T (0)) ;
 
-	/* Now apply the right half of the filter. */
+	/*
+	** Now the right half, walked forwards into the same sums so that the taps
+	** go in oldest first, as the kernels of sinc_direct_process () add them.
+	** A tap at zero has already gone in with the left half.
+	*/
 	filter_index = increment - start_filter_index ;
 	coeff_count = (max_filter_index - filter_index) / increment ;
-	filter_index = filter_index + coeff_count * increment ;
-	data_index = filter->b_current + 1 + coeff_count ;
+	max_filter_index = filter_index + coeff_count * increment ;
+	data_index = b_current + 1 ;
 
-	right = 0.0 ;
-	do
-	{	fraction = fp_to_double (filter_index) ;
-		indx = fp_to_int (filter_index) ;
+	if (filter_index == MAKE_INCREMENT_T (0))
+	{	filter_index += increment ;
+		data_index = data_index + 1 ;
+		} ;
 
-		icoeff = filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
+	while (filter_index <= max_filter_index)
+	{	icoeff = sinc_coeff (filter, filter_index) ;
 
-		right += icoeff * filter->buffer [data_index] ;
+		sum += icoeff * buffer [data_index] ;
 
-		filter_index -= increment ;
-		data_index = data_index - 1 ;
-		}
-	while (filter_index > MAKE_INCREMENT_T (0)) ;
+		filter_index += increment ;
+		data_index = data_index + 1 ;
+		} ;
 
-	return (left + right) ;
+	return sum ;
 } /* calc_output_single */
 
 static int
@@ -360,8 +1275,8 @@ sinc_mono_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 
 	/* Check the sample rate ratio wrt the buffer len. */
 	count = (filter->coeff_half_len + 2.0) / filter->index_inc ;
-	if (MIN (psrc->last_ratio, data->src_ratio) < 1.0)
-		count /= MIN (psrc->last_ratio, data->src_ratio) ;
+	if (process_min_ratio (psrc, data) < 1.0)
+		count /= process_min_ratio (psrc, data) ;
 
 	/* Maximum coefficientson either side of center point. */
 	half_filter_chan_len = filter->channels * (int) (lrint (count) + 1) ;
@@ -374,6 +1289,9 @@ sinc_mono_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 
 	terminate = 1.0 / src_ratio + 1e-20 ;
 
+	float_increment = filter->index_inc * (src_ratio < 1.0 ? src_ratio : 1.0) ;
+	increment = double_to_fp (float_increment) ;
+
 	/* Main processing loop. */
 	while (filter->out_gen < filter->out_count)
 	{
@@ -391,30 +1309,43 @@ sinc_mono_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 
 		/* This is the termination condition. */
 		if (filter->b_real_end >= 0)
-		{	if (filter->b_current + input_index + terminate > filter->b_real_end)
+		{	if (filter->rational_num > 0 ? rational_at_end (filter) : filter->b_current + input_index + terminate > filter->b_real_end)
 				break ;
 			} ;
 
-		if (filter->out_count > 0 && fabs (psrc->last_ratio - data->src_ratio) > 1e-10)
-			src_ratio = psrc->last_ratio + filter->out_gen * (data->src_ratio - psrc->last_ratio) / filter->out_count ;
-
-		float_increment = filter->index_inc * (src_ratio < 1.0 ? src_ratio : 1.0) ;
-		increment = double_to_fp (float_increment) ;
+		if (psrc->envelope != NULL || (filter->out_count > 0 && fabs (psrc->last_ratio - data->src_ratio) > 1e-10))
+		{	if (psrc->envelope != NULL)
+				src_ratio = envelope_ratio (psrc->envelope, filter->out_gen / filter->channels) ;
+			else
+				src_ratio = psrc->last_ratio + filter->out_gen * (data->src_ratio - psrc->last_ratio) / filter->out_count ;
+			float_increment = filter->index_inc * (src_ratio < 1.0 ? src_ratio : 1.0) ;
+			increment = double_to_fp (float_increment) ;
+			} ;
 
-		start_filter_index = double_to_fp (input_index * float_increment) ;
+		if (filter->rational_num > 0)
+			start_filter_index = filter->rational_index ;
+		else
+			start_filter_index = double_to_fp (input_index * float_increment) ;
 
 		data->data_out [filter->out_gen] = (float) ((float_increment / filter->index_inc) *
-										calc_output_single (filter, increment, start_filter_index)) ;
+										calc_output_single (filter, filter->buffer, filter->b_current, increment, start_filter_index)) ;
 		filter->out_gen ++ ;
 
 		/* Figure out the next index. */
-		input_index += 1.0 / src_ratio ;
-		rem = fmod_one (input_index) ;
-
-		filter->b_current = (filter->b_current + filter->channels * lrint (input_index - rem)) % filter->b_len ;
-		input_index = rem ;
+		if (filter->rational_num > 0)
+			rational_advance (filter) ;
+		else
+		{	input_index += 1.0 / src_ratio ;
+			rem = fmod_one (input_index) ;
+
+			filter->b_current = (filter->b_current + filter->channels * lrint (input_index - rem)) % filter->b_len ;
+			input_index = rem ;
+			} ;
 		} ;
 
+	if (filter->rational_num > 0)
+		input_index = (1.0 * filter->rational_phase) / filter->rational_num ;
+
 	psrc->last_position = input_index ;
 
 	/* Save current ratio rather then target ratio. */
@@ -427,10 +1358,10 @@ sinc_mono_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 } /* sinc_mono_vari_process */
 
 static inline void
-calc_output_stereo (SINC_FILTER *filter, increment_t increment, increment_t start_filter_index, double scale, float * output)
-{	double		fraction, left [2], right [2], icoeff ;
+calc_output_stereo (SINC_FILTER *filter, const float *buffer, int b_current, increment_t increment, increment_t start_filter_index, double scale, float * output)
+{	double		sum [2], icoeff ;
 	increment_t	filter_index, max_filter_index ;
-	int			data_index, coeff_count, indx ;
+	int			data_index, coeff_count ;
 
 	/* Convert input parameters into fixed point. */
 	max_filter_index = int_to_fp (filter->coeff_half_len) ;
@@ -439,48 +1370,49 @@ calc_output_stereo (SINC_FILTER *filter, increment_t increment, increment_t star
 	filter_index = start_filter_index ;
 	coeff_count = (max_filter_index - filter_index) / increment ;
 	filter_index = filter_index + coeff_count * increment ;
-	data_index = filter->b_current - filter->channels * coeff_count ;
+	data_index = b_current - filter->channels * coeff_count ;
 
-	left [0] = left [1] = 0.0 ;
-	do
-	{	if (data_index >= 0) /* Avoid underflow access to filter->buffer. */
-		{	fraction = fp_to_double (filter_index) ;
-			indx = fp_to_int (filter_index) ;
+	/* Past the history held counts as silence, as in calc_output_single (). */
+	if (data_index < 0)
+	{	filter_index -= (-data_index / filter->channels) * increment ;
+		data_index = 0 ;
+		} ;
 
-			icoeff = filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
+	sum [0] = sum [1] = 0.0 ;
+	do
+	{	icoeff = sinc_coeff (filter, filter_index) ;
 
-			left [0] += icoeff * filter->buffer [data_index] ;
-			left [1] += icoeff * filter->buffer [data_index + 1] ;
-			} ;
+		sum [0] += icoeff * buffer [data_index] ;
+		sum [1] += icoeff * buffer [data_index + 1] ;
 
 		filter_index -= increment ;
 		data_index = data_index + 2 ;
 		}
 	while (filter_index >= MAKE_INCREMENT_T (0)) ;
 
-	/* Now apply the right half of the filter. */
+	/* Now the right half, forwards into the same sums as in calc_output_single (). */
 	filter_index = increment - start_filter_index ;
 	coeff_count = (max_filter_index - filter_index) / increment ;
-	filter_index = filter_index + coeff_count * increment ;
-	data_index = filter->b_current + filter->channels * (1 + coeff_count) ;
+	max_filter_index = filter_index + coeff_count * increment ;
+	data_index = b_current + 2 ;
 
-	right [0] = right [1] = 0.0 ;
-	do
-	{	fraction = fp_to_double (filter_index) ;
-		indx = fp_to_int (filter_index) ;
+	if (filter_index == MAKE_INCREMENT_T (0))
+	{	filter_index += increment ;
+		data_index = data_index + 2 ;
+		} ;
 
-		icoeff = filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
+	while (filter_index <= max_filter_index)
+	{	icoeff = sinc_coeff (filter, filter_index) ;
 
-		right [0] += icoeff * filter->buffer [data_index] ;
-		right [1] += icoeff * filter->buffer [data_index + 1] ;
+		sum [0] += icoeff * buffer [data_index] ;
+		sum [1] += icoeff * buffer [data_index + 1] ;
 
-		filter_index -= increment ;
-		data_index = data_index - 2 ;
-		}
-	while (filter_index > MAKE_INCREMENT_T (0)) ;
+		filter_index += increment ;
+		data_index = data_index + 2 ;
+		} ;
 
-	output [0] = scale * (left [0] + right [0]) ;
-	output [1] = scale * (left [1] + right [1]) ;
+	output [0] = scale * sum [0] ;
+	output [1] = scale * sum [1] ;
 } /* calc_output_stereo */
 
 static int
@@ -510,8 +1442,8 @@ sinc_stereo_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 
 	/* Check the sample rate ratio wrt the buffer len. */
 	count = (filter->coeff_half_len + 2.0) / filter->index_inc ;
-	if (MIN (psrc->last_ratio, data->src_ratio) < 1.0)
-		count /= MIN (psrc->last_ratio, data->src_ratio) ;
+	if (process_min_ratio (psrc, data) < 1.0)
+		count /= process_min_ratio (psrc, data) ;
 
 	/* Maximum coefficientson either side of center point. */
 	half_filter_chan_len = filter->channels * (int) (lrint (count) + 1) ;
@@ -524,6 +1456,9 @@ sinc_stereo_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 
 	terminate = 1.0 / src_ratio + 1e-20 ;
 
+	float_increment = filter->index_inc * (src_ratio < 1.0 ? src_ratio : 1.0) ;
+	increment = double_to_fp (float_increment) ;
+
 	/* Main processing loop. */
 	while (filter->out_gen < filter->out_count)
 	{
@@ -541,29 +1476,42 @@ sinc_stereo_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 
 		/* This is the termination condition. */
 		if (filter->b_real_end >= 0)
-		{	if (filter->b_current + input_index + terminate >= filter->b_real_end)
+		{	if (filter->rational_num > 0 ? rational_at_end (filter) : filter->b_current + input_index + terminate >= filter->b_real_end)
 				break ;
 			} ;
 
-		if (filter->out_count > 0 && fabs (psrc->last_ratio - data->src_ratio) > 1e-10)
-			src_ratio = psrc->last_ratio + filter->out_gen * (data->src_ratio - psrc->last_ratio) / filter->out_count ;
-
-		float_increment = filter->index_inc * (src_ratio < 1.0 ? src_ratio : 1.0) ;
-		increment = double_to_fp (float_increment) ;
+		if (psrc->envelope != NULL || (filter->out_count > 0 && fabs (psrc->last_ratio - data->src_ratio) > 1e-10))
+		{	if (psrc->envelope != NULL)
+				src_ratio = envelope_ratio (psrc->envelope, filter->out_gen / filter->channels) ;
+			else
+				src_ratio = psrc->last_ratio + filter->out_gen * (data->src_ratio - psrc->last_ratio) / filter->out_count ;
+			float_increment = filter->index_inc * (src_ratio < 1.0 ? src_ratio : 1.0) ;
+			increment = double_to_fp (float_increment) ;
+			} ;
 
-		start_filter_index = double_to_fp (input_index * float_increment) ;
+		if (filter->rational_num > 0)
+			start_filter_index = filter->rational_index ;
+		else
+			start_filter_index = double_to_fp (input_index * float_increment) ;
 
-		calc_output_stereo (filter, increment, start_filter_index, float_increment / filter->index_inc, data->data_out + filter->out_gen) ;
+		calc_output_stereo (filter, filter->buffer, filter->b_current, increment, start_filter_index, float_increment / filter->index_inc, data->data_out + filter->out_gen) ;
 		filter->out_gen += 2 ;
 
 		/* Figure out the next index. */
-		input_index += 1.0 / src_ratio ;
-		rem = fmod_one (input_index) ;
-
-		filter->b_current = (filter->b_current + filter->channels * lrint (input_index - rem)) % filter->b_len ;
-		input_index = rem ;
+		if (filter->rational_num > 0)
+			rational_advance (filter) ;
+		else
+		{	input_index += 1.0 / src_ratio ;
+			rem = fmod_one (input_index) ;
+
+			filter->b_current = (filter->b_current + filter->channels * lrint (input_index - rem)) % filter->b_len ;
+			input_index = rem ;
+			} ;
 		} ;
 
+	if (filter->rational_num > 0)
+		input_index = (1.0 * filter->rational_phase) / filter->rational_num ;
+
 	psrc->last_position = input_index ;
 
 	/* Save current ratio rather then target ratio. */
@@ -576,10 +1524,10 @@ sinc_stereo_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 } /* sinc_stereo_vari_process */
 
 static inline void
-calc_output_quad (SINC_FILTER *filter, increment_t increment, increment_t start_filter_index, double scale, float * output)
-{	double		fraction, left [4], right [4], icoeff ;
+calc_output_quad (SINC_FILTER *filter, const float *buffer, int b_current, increment_t increment, increment_t start_filter_index, double scale, float * output)
+{	double		sum [4], icoeff ;
 	increment_t	filter_index, max_filter_index ;
-	int			data_index, coeff_count, indx ;
+	int			data_index, coeff_count ;
 
 	/* Convert input parameters into fixed point. */
 	max_filter_index = int_to_fp (filter->coeff_half_len) ;
@@ -588,54 +1536,55 @@ calc_output_quad (SINC_FILTER *filter, increment_t increment, increment_t start_
 	filter_index = start_filter_index ;
 	coeff_count = (max_filter_index - filter_index) / increment ;
 	filter_index = filter_index + coeff_count * increment ;
-	data_index = filter->b_current - filter->channels * coeff_count ;
+	data_index = b_current - filter->channels * coeff_count ;
 
-	left [0] = left [1] = left [2] = left [3] = 0.0 ;
-	do
-	{	if (data_index >= 0) /* Avoid underflow access to filter->buffer. */
-		{	fraction = fp_to_double (filter_index) ;
-			indx = fp_to_int (filter_index) ;
+	/* Past the history held counts as silence, as in calc_output_single (). */
+	if (data_index < 0)
+	{	filter_index -= (-data_index / filter->channels) * increment ;
+		data_index = 0 ;
+		} ;
 
-			icoeff = filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
+	sum [0] = sum [1] = sum [2] = sum [3] = 0.0 ;
+	do
+	{	icoeff = sinc_coeff (filter, filter_index) ;
 
-			left [0] += icoeff * filter->buffer [data_index] ;
-			left [1] += icoeff * filter->buffer [data_index + 1] ;
-			left [2] += icoeff * filter->buffer [data_index + 2] ;
-			left [3] += icoeff * filter->buffer [data_index + 3] ;
-			} ;
+		sum [0] += icoeff * buffer [data_index] ;
+		sum [1] += icoeff * buffer [data_index + 1] ;
+		sum [2] += icoeff * buffer [data_index + 2] ;
+		sum [3] += icoeff * buffer [data_index + 3] ;
 
 		filter_index -= increment ;
 		data_index = data_index + 4 ;
 		}
 	while (filter_index >= MAKE_INCREMENT_T (0)) ;
 
-	/* Now apply the right half of the filter. */
+	/* Now the right half, forwards into the same sums as in calc_output_single (). */
 	filter_index = increment - start_filter_index ;
 	coeff_count = (max_filter_index - filter_index) / increment ;
-	filter_index = filter_index + coeff_count * increment ;
-	data_index = filter->b_current + filter->channels * (1 + coeff_count) ;
+	max_filter_index = filter_index + coeff_count * increment ;
+	data_index = b_current + 4 ;
 
-	right [0] = right [1] = right [2] = right [3] = 0.0 ;
-	do
-	{	fraction = fp_to_double (filter_index) ;
-		indx = fp_to_int (filter_index) ;
+	if (filter_index == MAKE_INCREMENT_T (0))
+	{	filter_index += increment ;
+		data_index = data_index + 4 ;
+		} ;
 
-		icoeff = filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
+	while (filter_index <= max_filter_index)
+	{	icoeff = sinc_coeff (filter, filter_index) ;
 
-		right [0] += icoeff * filter->buffer [data_index] ;
-		right [1] += icoeff * filter->buffer [data_index + 1] ;
-		right [2] += icoeff * filter->buffer [data_index + 2] ;
-		right [3] += icoeff * filter->buffer [data_index + 3] ;
+		sum [0] += icoeff * buffer [data_index] ;
+		sum [1] += icoeff * buffer [data_index + 1] ;
+		sum [2] += icoeff * buffer [data_index + 2] ;
+		sum [3] += icoeff * buffer [data_index + 3] ;
 
-		filter_index -= increment ;
-		data_index = data_index - 4 ;
-		}
-	while (filter_index > MAKE_INCREMENT_T (0)) ;
+		filter_index += increment ;
+		data_index = data_index + 4 ;
+		} ;
 
-	output [0] = scale * (left [0] + right [0]) ;
-	output [1] = scale * (left [1] + right [1]) ;
-	output [2] = scale * (left [2] + right [2]) ;
-	output [3] = scale * (left [3] + right [3]) ;
+	output [0] = scale * sum [0] ;
+	output [1] = scale * sum [1] ;
+	output [2] = scale * sum [2] ;
+	output [3] = scale * sum [3] ;
 } /* calc_output_quad */
 
 static int
@@ -665,8 +1614,8 @@ sinc_quad_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 
 	/* Check the sample rate ratio wrt the buffer len. */
 	count = (filter->coeff_half_len + 2.0) / filter->index_inc ;
-	if (MIN (psrc->last_ratio, data->src_ratio) < 1.0)
-		count /= MIN (psrc->last_ratio, data->src_ratio) ;
+	if (process_min_ratio (psrc, data) < 1.0)
+		count /= process_min_ratio (psrc, data) ;
 
 	/* Maximum coefficientson either side of center point. */
 	half_filter_chan_len = filter->channels * (int) (lrint (count) + 1) ;
@@ -679,6 +1628,9 @@ sinc_quad_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 
 	terminate = 1.0 / src_ratio + 1e-20 ;
 
+	float_increment = filter->index_inc * (src_ratio < 1.0 ? src_ratio : 1.0) ;
+	increment = double_to_fp (float_increment) ;
+
 	/* Main processing loop. */
 	while (filter->out_gen < filter->out_count)
 	{
@@ -696,29 +1648,42 @@ sinc_quad_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 
 		/* This is the termination condition. */
 		if (filter->b_real_end >= 0)
-		{	if (filter->b_current + input_index + terminate >= filter->b_real_end)
+		{	if (filter->rational_num > 0 ? rational_at_end (filter) : filter->b_current + input_index + terminate >= filter->b_real_end)
 				break ;
 			} ;
 
-		if (filter->out_count > 0 && fabs (psrc->last_ratio - data->src_ratio) > 1e-10)
-			src_ratio = psrc->last_ratio + filter->out_gen * (data->src_ratio - psrc->last_ratio) / filter->out_count ;
-
-		float_increment = filter->index_inc * (src_ratio < 1.0 ? src_ratio : 1.0) ;
-		increment = double_to_fp (float_increment) ;
+		if (psrc->envelope != NULL || (filter->out_count > 0 && fabs (psrc->last_ratio - data->src_ratio) > 1e-10))
+		{	if (psrc->envelope != NULL)
+				src_ratio = envelope_ratio (psrc->envelope, filter->out_gen / filter->channels) ;
+			else
+				src_ratio = psrc->last_ratio + filter->out_gen * (data->src_ratio - psrc->last_ratio) / filter->out_count ;
+			float_increment = filter->index_inc * (src_ratio < 1.0 ? src_ratio : 1.0) ;
+			increment = double_to_fp (float_increment) ;
+			} ;
 
-		start_filter_index = double_to_fp (input_index * float_increment) ;
+		if (filter->rational_num > 0)
+			start_filter_index = filter->rational_index ;
+		else
+			start_filter_index = double_to_fp (input_index * float_increment) ;
 
-		calc_output_quad (filter, increment, start_filter_index, float_increment / filter->index_inc, data->data_out + filter->out_gen) ;
+		calc_output_quad (filter, filter->buffer, filter->b_current, increment, start_filter_index, float_increment / filter->index_inc, data->data_out + filter->out_gen) ;
 		filter->out_gen += 4 ;
 
 		/* Figure out the next index. */
-		input_index += 1.0 / src_ratio ;
-		rem = fmod_one (input_index) ;
-
-		filter->b_current = (filter->b_current + filter->channels * lrint (input_index - rem)) % filter->b_len ;
-		input_index = rem ;
+		if (filter->rational_num > 0)
+			rational_advance (filter) ;
+		else
+		{	input_index += 1.0 / src_ratio ;
+			rem = fmod_one (input_index) ;
+
+			filter->b_current = (filter->b_current + filter->channels * lrint (input_index - rem)) % filter->b_len ;
+			input_index = rem ;
+			} ;
 		} ;
 
+	if (filter->rational_num > 0)
+		input_index = (1.0 * filter->rational_phase) / filter->rational_num ;
+
 	psrc->last_position = input_index ;
 
 	/* Save current ratio rather then target ratio. */
@@ -731,10 +1696,10 @@ sinc_quad_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 } /* sinc_quad_vari_process */
 
 static inline void
-calc_output_hex (SINC_FILTER *filter, increment_t increment, increment_t start_filter_index, double scale, float * output)
-{	double		fraction, left [6], right [6], icoeff ;
+calc_output_hex (SINC_FILTER *filter, const float *buffer, int b_current, increment_t increment, increment_t start_filter_index, double scale, float * output)
+{	double		sum [6], icoeff ;
 	increment_t	filter_index, max_filter_index ;
-	int			data_index, coeff_count, indx ;
+	int			data_index, coeff_count ;
 
 	/* Convert input parameters into fixed point. */
 	max_filter_index = int_to_fp (filter->coeff_half_len) ;
@@ -743,60 +1708,61 @@ calc_output_hex (SINC_FILTER *filter, increment_t increment, increment_t start_f
 	filter_index = start_filter_index ;
 	coeff_count = (max_filter_index - filter_index) / increment ;
 	filter_index = filter_index + coeff_count * increment ;
-	data_index = filter->b_current - filter->channels * coeff_count ;
+	data_index = b_current - filter->channels * coeff_count ;
 
-	left [0] = left [1] = left [2] = left [3] = left [4] = left [5] = 0.0 ;
+	/* Past the history held counts as silence, as in calc_output_single (). */
+	if (data_index < 0)
+	{	filter_index -= (-data_index / filter->channels) * increment ;
+		data_index = 0 ;
+		} ;
+
+	sum [0] = sum [1] = sum [2] = sum [3] = sum [4] = sum [5] = 0.0 ;
 	do
-	{	if (data_index >= 0) /* Avoid underflow access to filter->buffer. */
-		{	fraction = fp_to_double (filter_index) ;
-			indx = fp_to_int (filter_index) ;
-
-			icoeff = filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
-
-			left [0] += icoeff * filter->buffer [data_index] ;
-			left [1] += icoeff * filter->buffer [data_index + 1] ;
-			left [2] += icoeff * filter->buffer [data_index + 2] ;
-			left [3] += icoeff * filter->buffer [data_index + 3] ;
-			left [4] += icoeff * filter->buffer [data_index + 4] ;
-			left [5] += icoeff * filter->buffer [data_index + 5] ;
-			} ;
+	{	icoeff = sinc_coeff (filter, filter_index) ;
+
+		sum [0] += icoeff * buffer [data_index] ;
+		sum [1] += icoeff * buffer [data_index + 1] ;
+		sum [2] += icoeff * buffer [data_index + 2] ;
+		sum [3] += icoeff * buffer [data_index + 3] ;
+		sum [4] += icoeff * buffer [data_index + 4] ;
+		sum [5] += icoeff * buffer [data_index + 5] ;
 
 		filter_index -= increment ;
 		data_index = data_index + 6 ;
 		}
 	while (filter_index >= MAKE_INCREMENT_T (0)) ;
 
-	/* Now apply the right half of the filter. */
+	/* Now the right half, forwards into the same sums as in calc_output_single (). */
 	filter_index = increment - start_filter_index ;
 	coeff_count = (max_filter_index - filter_index) / increment ;
-	filter_index = filter_index + coeff_count * increment ;
-	data_index = filter->b_current + filter->channels * (1 + coeff_count) ;
+	max_filter_index = filter_index + coeff_count * increment ;
+	data_index = b_current + 6 ;
 
-	right [0] = right [1] = right [2] = right [3] = right [4] = right [5] = 0.0 ;
-	do
-	{	fraction = fp_to_double (filter_index) ;
-		indx = fp_to_int (filter_index) ;
+	if (filter_index == MAKE_INCREMENT_T (0))
+	{	filter_index += increment ;
+		data_index = data_index + 6 ;
+		} ;
 
-		icoeff = filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
+	while (filter_index <= max_filter_index)
+	{	icoeff = sinc_coeff (filter, filter_index) ;
 
-		right [0] += icoeff * filter->buffer [data_index] ;
-		right [1] += icoeff * filter->buffer [data_index + 1] ;
-		right [2] += icoeff * filter->buffer [data_index + 2] ;
-		right [3] += icoeff * filter->buffer [data_index + 3] ;
-		right [4] += icoeff * filter->buffer [data_index + 4] ;
-		right [5] += icoeff * filter->buffer [data_index + 5] ;
+		sum [0] += icoeff * buffer [data_index] ;
+		sum [1] += icoeff * buffer [data_index + 1] ;
+		sum [2] += icoeff * buffer [data_index + 2] ;
+		sum [3] += icoeff * buffer [data_index + 3] ;
+		sum [4] += icoeff * buffer [data_index + 4] ;
+		sum [5] += icoeff * buffer [data_index + 5] ;
 
-		filter_index -= increment ;
-		data_index = data_index - 6 ;
-		}
-	while (filter_index > MAKE_INCREMENT_T (0)) ;
+		filter_index += increment ;
+		data_index = data_index + 6 ;
+		} ;
 
-	output [0] = scale * (left [0] + right [0]) ;
-	output [1] = scale * (left [1] + right [1]) ;
-	output [2] = scale * (left [2] + right [2]) ;
-	output [3] = scale * (left [3] + right [3]) ;
-	output [4] = scale * (left [4] + right [4]) ;
-	output [5] = scale * (left [5] + right [5]) ;
+	output [0] = scale * sum [0] ;
+	output [1] = scale * sum [1] ;
+	output [2] = scale * sum [2] ;
+	output [3] = scale * sum [3] ;
+	output [4] = scale * sum [4] ;
+	output [5] = scale * sum [5] ;
 } /* calc_output_hex */
 
 static int
@@ -826,8 +1792,8 @@ sinc_hex_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 
 	/* Check the sample rate ratio wrt the buffer len. */
 	count = (filter->coeff_half_len + 2.0) / filter->index_inc ;
-	if (MIN (psrc->last_ratio, data->src_ratio) < 1.0)
-		count /= MIN (psrc->last_ratio, data->src_ratio) ;
+	if (process_min_ratio (psrc, data) < 1.0)
+		count /= process_min_ratio (psrc, data) ;
 
 	/* Maximum coefficientson either side of center point. */
 	half_filter_chan_len = filter->channels * (int) (lrint (count) + 1) ;
@@ -840,6 +1806,9 @@ sinc_hex_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 
 	terminate = 1.0 / src_ratio + 1e-20 ;
 
+	float_increment = filter->index_inc * (src_ratio < 1.0 ? src_ratio : 1.0) ;
+	increment = double_to_fp (float_increment) ;
+
 	/* Main processing loop. */
 	while (filter->out_gen < filter->out_count)
 	{
@@ -857,29 +1826,42 @@ sinc_hex_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 
 		/* This is the termination condition. */
 		if (filter->b_real_end >= 0)
-		{	if (filter->b_current + input_index + terminate >= filter->b_real_end)
+		{	if (filter->rational_num > 0 ? rational_at_end (filter) : filter->b_current + input_index + terminate >= filter->b_real_end)
 				break ;
 			} ;
 
-		if (filter->out_count > 0 && fabs (psrc->last_ratio - data->src_ratio) > 1e-10)
-			src_ratio = psrc->last_ratio + filter->out_gen * (data->src_ratio - psrc->last_ratio) / filter->out_count ;
-
-		float_increment = filter->index_inc * (src_ratio < 1.0 ? src_ratio : 1.0) ;
-		increment = double_to_fp (float_increment) ;
+		if (psrc->envelope != NULL || (filter->out_count > 0 && fabs (psrc->last_ratio - data->src_ratio) > 1e-10))
+		{	if (psrc->envelope != NULL)
+				src_ratio = envelope_ratio (psrc->envelope, filter->out_gen / filter->channels) ;
+			else
+				src_ratio = psrc->last_ratio + filter->out_gen * (data->src_ratio - psrc->last_ratio) / filter->out_count ;
+			float_increment = filter->index_inc * (src_ratio < 1.0 ? src_ratio : 1.0) ;
+			increment = double_to_fp (float_increment) ;
+			} ;
 
-		start_filter_index = double_to_fp (input_index * float_increment) ;
+		if (filter->rational_num > 0)
+			start_filter_index = filter->rational_index ;
+		else
+			start_filter_index = double_to_fp (input_index * float_increment) ;
 
-		calc_output_hex (filter, increment, start_filter_index, float_increment / filter->index_inc, data->data_out + filter->out_gen) ;
+		calc_output_hex (filter, filter->buffer, filter->b_current, increment, start_filter_index, float_increment / filter->index_inc, data->data_out + filter->out_gen) ;
 		filter->out_gen += 6 ;
 
 		/* Figure out the next index. */
-		input_index += 1.0 / src_ratio ;
-		rem = fmod_one (input_index) ;
-
-		filter->b_current = (filter->b_current + filter->channels * lrint (input_index - rem)) % filter->b_len ;
-		input_index = rem ;
+		if (filter->rational_num > 0)
+			rational_advance (filter) ;
+		else
+		{	input_index += 1.0 / src_ratio ;
+			rem = fmod_one (input_index) ;
+
+			filter->b_current = (filter->b_current + filter->channels * lrint (input_index - rem)) % filter->b_len ;
+			input_index = rem ;
+			} ;
 		} ;
 
+	if (filter->rational_num > 0)
+		input_index = (1.0 * filter->rational_phase) / filter->rational_num ;
+
 	psrc->last_position = input_index ;
 
 	/* Save current ratio rather then target ratio. */
@@ -891,16 +1873,17 @@ sinc_hex_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 	return SRC_ERR_NO_ERROR ;
 } /* sinc_hex_vari_process */
 
+/*
+** calc_output_multi () for lanes channels, SINC_LANES or twice that, passed
+** as a constant. Each tap's coefficient is broadcast across the lanes, with
+** the sums in locals the compiler can keep in vector registers. The taps go
+** into each sum in the same order as in calc_output_single ().
+*/
 static inline void
-calc_output_multi (SINC_FILTER *filter, increment_t increment, increment_t start_filter_index, int channels, double scale, float * output)
-{	double		fraction, icoeff ;
-	/* The following line is 1999 ISO Standard C. If your compiler complains, get a better compiler. */
-	double		*left, *right ;
+calc_output_lanes (SINC_FILTER *filter, const float *buffer, int b_current, increment_t increment, increment_t start_filter_index, int lanes, int stride, double scale, float * output)
+{	double		sum [2 * SINC_LANES], icoeff ;
 	increment_t	filter_index, max_filter_index ;
-	int			data_index, coeff_count, indx, ch ;
-
-	left = filter->left_calc ;
-	right = filter->right_calc ;
+	int			data_index, coeff_count, ch ;
 
 	/* Convert input parameters into fixed point. */
 	max_filter_index = int_to_fp (filter->coeff_half_len) ;
@@ -909,77 +1892,165 @@ calc_output_multi (SINC_FILTER *filter, increment_t increment, increment_t start
 	filter_index = start_filter_index ;
 	coeff_count = (max_filter_index - filter_index) / increment ;
 	filter_index = filter_index + coeff_count * increment ;
-	data_index = filter->b_current - channels * coeff_count ;
+	data_index = b_current - stride * coeff_count ;
 
-	memset (left, 0, sizeof (left [0]) * channels) ;
+	/* Past the history held counts as silence, as in calc_output_single (). */
+	if (data_index < 0)
+	{	filter_index -= (-data_index / stride) * increment ;
+		data_index = 0 ;
+		} ;
+
+	for (ch = 0 ; ch < lanes ; ch++)
+		sum [ch] = 0.0 ;
 
 	do
-	{	fraction = fp_to_double (filter_index) ;
-		indx = fp_to_int (filter_index) ;
-
-		icoeff = filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
-
-		if (data_index >= 0) /* Avoid underflow access to filter->buffer. */
-		{	/*
-			**	Duff's Device.
-			**	See : http://en.wikipedia.org/wiki/Duff's_device
-			*/
-			ch = channels ;
-			do
-			{	switch (ch % 8)
-				{	default :
-						ch -- ;
-						left [ch] += icoeff * filter->buffer [data_index + ch] ;
-						/* Falls through. */
-					case 7 :
-						ch -- ;
-						left [ch] += icoeff * filter->buffer [data_index + ch] ;
-						/* Falls through. */
-					case 6 :
-						ch -- ;
-						left [ch] += icoeff * filter->buffer [data_index + ch] ;
-						/* Falls through. */
-					case 5 :
-						ch -- ;
-						left [ch] += icoeff * filter->buffer [data_index + ch] ;
-						/* Falls through. */
-					case 4 :
-						ch -- ;
-						left [ch] += icoeff * filter->buffer [data_index + ch] ;
-						/* Falls through. */
-					case 3 :
-						ch -- ;
-						left [ch] += icoeff * filter->buffer [data_index + ch] ;
-						/* Falls through. */
-					case 2 :
-						ch -- ;
-						left [ch] += icoeff * filter->buffer [data_index + ch] ;
-						/* Falls through. */
-					case 1 :
-						ch -- ;
-						left [ch] += icoeff * filter->buffer [data_index + ch] ;
-					} ;
-				}
-			while (ch > 0) ;
-			} ;
+	{	icoeff = sinc_coeff (filter, filter_index) ;
+
+		for (ch = 0 ; ch < lanes ; ch++)
+			sum [ch] += icoeff * buffer [data_index + ch] ;
 
 		filter_index -= increment ;
-		data_index = data_index + channels ;
+		data_index = data_index + stride ;
 		}
 	while (filter_index >= MAKE_INCREMENT_T (0)) ;
 
-	/* Now apply the right half of the filter. */
+	/* Now the right half, forwards into the same sums as in calc_output_single (). */
 	filter_index = increment - start_filter_index ;
 	coeff_count = (max_filter_index - filter_index) / increment ;
+	max_filter_index = filter_index + coeff_count * increment ;
+	data_index = b_current + stride ;
+
+	if (filter_index == MAKE_INCREMENT_T (0))
+	{	filter_index += increment ;
+		data_index = data_index + stride ;
+		} ;
+
+	while (filter_index <= max_filter_index)
+	{	icoeff = sinc_coeff (filter, filter_index) ;
+
+		for (ch = 0 ; ch < lanes ; ch++)
+			sum [ch] += icoeff * buffer [data_index + ch] ;
+
+		filter_index += increment ;
+		data_index = data_index + stride ;
+		} ;
+
+	for (ch = 0 ; ch < lanes ; ch++)
+		output [ch] = scale * sum [ch] ;
+
+	return ;
+} /* calc_output_lanes */
+
+/*
+** The first channels of each frame, frames stride samples apart in buffer.
+** All of them when stride is the channel count.
+*/
+static inline void
+calc_output_multi (SINC_FILTER *filter, const float *buffer, int b_current, increment_t increment, increment_t start_filter_index, int channels, int stride, double scale, float * output)
+{	double		icoeff ;
+	/* The following line is 1999 ISO Standard C. If your compiler complains, get a better compiler. */
+	double		*sum ;
+	increment_t	filter_index, max_filter_index ;
+	int			data_index, coeff_count, ch, base ;
+
+	/* Literal channel counts for the common wide buses, others SINC_LANES at a time. */
+	if (channels == 16)
+	{	calc_output_lanes (filter, buffer, b_current, increment, start_filter_index, 16, stride, scale, output) ;
+		return ;
+		} ;
+
+	for (base = 0 ; base + SINC_LANES <= channels ; base += SINC_LANES)
+		calc_output_lanes (filter, buffer + base, b_current, increment, start_filter_index, SINC_LANES, stride, scale, output + base) ;
+
+	/* The odd channels left over. */
+	if ((channels -= base) == 0)
+		return ;
+
+	buffer += base ;
+	output += base ;
+
+	sum = filter->left_calc ;
+
+	/* Convert input parameters into fixed point. */
+	max_filter_index = int_to_fp (filter->coeff_half_len) ;
+
+	/* First apply the left half of the filter. */
+	filter_index = start_filter_index ;
+	coeff_count = (max_filter_index - filter_index) / increment ;
 	filter_index = filter_index + coeff_count * increment ;
-	data_index = filter->b_current + channels * (1 + coeff_count) ;
+	data_index = b_current - stride * coeff_count ;
+
+	/* Past the history held counts as silence, as in calc_output_single (). */
+	if (data_index < 0)
+	{	filter_index -= (-data_index / stride) * increment ;
+		data_index = 0 ;
+		} ;
+
+	memset (sum, 0, sizeof (sum [0]) * channels) ;
 
-	memset (right, 0, sizeof (right [0]) * channels) ;
 	do
-	{	fraction = fp_to_double (filter_index) ;
-		indx = fp_to_int (filter_index) ;
+	{	icoeff = sinc_coeff (filter, filter_index) ;
+
+		/*
+		**	Duff's Device.
+		**	See : http://en.wikipedia.org/wiki/Duff's_device
+		*/
+		ch = channels ;
+		do
+		{	switch (ch % 8)
+			{	default :
+					ch -- ;
+					sum [ch] += icoeff * buffer [data_index + ch] ;
+					/* Falls through. */
+				case 7 :
+					ch -- ;
+					sum [ch] += icoeff * buffer [data_index + ch] ;
+					/* Falls through. */
+				case 6 :
+					ch -- ;
+					sum [ch] += icoeff * buffer [data_index + ch] ;
+					/* Falls through. */
+				case 5 :
+					ch -- ;
+					sum [ch] += icoeff * buffer [data_index + ch] ;
+					/* Falls through. */
+				case 4 :
+					ch -- ;
+					sum [ch] += icoeff * buffer [data_index + ch] ;
+					/* Falls through. */
+				case 3 :
+					ch -- ;
+					sum [ch] += icoeff * buffer [data_index + ch] ;
+					/* Falls through. */
+				case 2 :
+					ch -- ;
+					sum [ch] += icoeff * buffer [data_index + ch] ;
+					/* Falls through. */
+				case 1 :
+					ch -- ;
+					sum [ch] += icoeff * buffer [data_index + ch] ;
+				} ;
+			}
+		while (ch > 0) ;
+
+		filter_index -= increment ;
+		data_index = data_index + stride ;
+		}
+	while (filter_index >= MAKE_INCREMENT_T (0)) ;
+
+	/* Now the right half, forwards into the same sums as in calc_output_single (). */
+	filter_index = increment - start_filter_index ;
+	coeff_count = (max_filter_index - filter_index) / increment ;
+	max_filter_index = filter_index + coeff_count * increment ;
+	data_index = b_current + stride ;
+
+	if (filter_index == MAKE_INCREMENT_T (0))
+	{	filter_index += increment ;
+		data_index = data_index + stride ;
+		} ;
 
-		icoeff = filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
+	while (filter_index <= max_filter_index)
+	{	icoeff = sinc_coeff (filter, filter_index) ;
 
 		ch = channels ;
 		do
@@ -987,43 +2058,42 @@ calc_output_multi (SINC_FILTER *filter, increment_t increment, increment_t start
 			switch (ch % 8)
 			{	default :
 					ch -- ;
-					right [ch] += icoeff * filter->buffer [data_index + ch] ;
+					sum [ch] += icoeff * buffer [data_index + ch] ;
 					/* Falls through. */
 				case 7 :
 					ch -- ;
-					right [ch] += icoeff * filter->buffer [data_index + ch] ;
+					sum [ch] += icoeff * buffer [data_index + ch] ;
 					/* Falls through. */
 				case 6 :
 					ch -- ;
-					right [ch] += icoeff * filter->buffer [data_index + ch] ;
+					sum [ch] += icoeff * buffer [data_index + ch] ;
 					/* Falls through. */
 				case 5 :
 					ch -- ;
-					right [ch] += icoeff * filter->buffer [data_index + ch] ;
+					sum [ch] += icoeff * buffer [data_index + ch] ;
 					/* Falls through. */
 				case 4 :
 					ch -- ;
-					right [ch] += icoeff * filter->buffer [data_index + ch] ;
+					sum [ch] += icoeff * buffer [data_index + ch] ;
 					/* Falls through. */
 				case 3 :
 					ch -- ;
-					right [ch] += icoeff * filter->buffer [data_index + ch] ;
+					sum [ch] += icoeff * buffer [data_index + ch] ;
 					/* Falls through. */
 				case 2 :
 					ch -- ;
-					right [ch] += icoeff * filter->buffer [data_index + ch] ;
+					sum [ch] += icoeff * buffer [data_index + ch] ;
 					/* Falls through. */
 				case 1 :
 					ch -- ;
-					right [ch] += icoeff * filter->buffer [data_index + ch] ;
+					sum [ch] += icoeff * buffer [data_index + ch] ;
 				} ;
 			}
 		while (ch > 0) ;
 
-		filter_index -= increment ;
-		data_index = data_index - channels ;
-		}
-	while (filter_index > MAKE_INCREMENT_T (0)) ;
+		filter_index += increment ;
+		data_index = data_index + stride ;
+		} ;
 
 	ch = channels ;
 	do
@@ -1031,35 +2101,35 @@ calc_output_multi (SINC_FILTER *filter, increment_t increment, increment_t start
 		switch (ch % 8)
 		{	default :
 				ch -- ;
-				output [ch] = scale * (left [ch] + right [ch]) ;
+				output [ch] = scale * sum [ch] ;
 				/* Falls through. */
 			case 7 :
 				ch -- ;
-				output [ch] = scale * (left [ch] + right [ch]) ;
+				output [ch] = scale * sum [ch] ;
 				/* Falls through. */
 			case 6 :
 				ch -- ;
-				output [ch] = scale * (left [ch] + right [ch]) ;
+				output [ch] = scale * sum [ch] ;
 				/* Falls through. */
 			case 5 :
 				ch -- ;
-				output [ch] = scale * (left [ch] + right [ch]) ;
+				output [ch] = scale * sum [ch] ;
 				/* Falls through. */
 			case 4 :
 				ch -- ;
-				output [ch] = scale * (left [ch] + right [ch]) ;
+				output [ch] = scale * sum [ch] ;
 				/* Falls through. */
 			case 3 :
 				ch -- ;
-				output [ch] = scale * (left [ch] + right [ch]) ;
+				output [ch] = scale * sum [ch] ;
 				/* Falls through. */
 			case 2 :
 				ch -- ;
-				output [ch] = scale * (left [ch] + right [ch]) ;
+				output [ch] = scale * sum [ch] ;
 				/* Falls through. */
 			case 1 :
 				ch -- ;
-				output [ch] = scale * (left [ch] + right [ch]) ;
+				output [ch] = scale * sum [ch] ;
 			} ;
 		}
 	while (ch > 0) ;
@@ -1094,8 +2164,8 @@ sinc_multichan_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 
 	/* Check the sample rate ratio wrt the buffer len. */
 	count = (filter->coeff_half_len + 2.0) / filter->index_inc ;
-	if (MIN (psrc->last_ratio, data->src_ratio) < 1.0)
-		count /= MIN (psrc->last_ratio, data->src_ratio) ;
+	if (process_min_ratio (psrc, data) < 1.0)
+		count /= process_min_ratio (psrc, data) ;
 
 	/* Maximum coefficientson either side of center point. */
 	half_filter_chan_len = filter->channels * (int) (lrint (count) + 1) ;
@@ -1108,6 +2178,9 @@ sinc_multichan_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 
 	terminate = 1.0 / src_ratio + 1e-20 ;
 
+	float_increment = filter->index_inc * (src_ratio < 1.0 ? src_ratio : 1.0) ;
+	increment = double_to_fp (float_increment) ;
+
 	/* Main processing loop. */
 	while (filter->out_gen < filter->out_count)
 	{
@@ -1125,29 +2198,42 @@ sinc_multichan_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 
 		/* This is the termination condition. */
 		if (filter->b_real_end >= 0)
-		{	if (filter->b_current + input_index + terminate >= filter->b_real_end)
+		{	if (filter->rational_num > 0 ? rational_at_end (filter) : filter->b_current + input_index + terminate >= filter->b_real_end)
 				break ;
 			} ;
 
-		if (filter->out_count > 0 && fabs (psrc->last_ratio - data->src_ratio) > 1e-10)
-			src_ratio = psrc->last_ratio + filter->out_gen * (data->src_ratio - psrc->last_ratio) / filter->out_count ;
-
-		float_increment = filter->index_inc * (src_ratio < 1.0 ? src_ratio : 1.0) ;
-		increment = double_to_fp (float_increment) ;
+		if (psrc->envelope != NULL || (filter->out_count > 0 && fabs (psrc->last_ratio - data->src_ratio) > 1e-10))
+		{	if (psrc->envelope != NULL)
+				src_ratio = envelope_ratio (psrc->envelope, filter->out_gen / filter->channels) ;
+			else
+				src_ratio = psrc->last_ratio + filter->out_gen * (data->src_ratio - psrc->last_ratio) / filter->out_count ;
+			float_increment = filter->index_inc * (src_ratio < 1.0 ? src_ratio : 1.0) ;
+			increment = double_to_fp (float_increment) ;
+			} ;
 
-		start_filter_index = double_to_fp (input_index * float_increment) ;
+		if (filter->rational_num > 0)
+			start_filter_index = filter->rational_index ;
+		else
+			start_filter_index = double_to_fp (input_index * float_increment) ;
 
-		calc_output_multi (filter, increment, start_filter_index, filter->channels, float_increment / filter->index_inc, data->data_out + filter->out_gen) ;
+		calc_output_multi (filter, filter->buffer, filter->b_current, increment, start_filter_index, filter->channels, filter->channels, float_increment / filter->index_inc, data->data_out + filter->out_gen) ;
 		filter->out_gen += psrc->channels ;
 
 		/* Figure out the next index. */
-		input_index += 1.0 / src_ratio ;
-		rem = fmod_one (input_index) ;
-
-		filter->b_current = (filter->b_current + filter->channels * lrint (input_index - rem)) % filter->b_len ;
-		input_index = rem ;
+		if (filter->rational_num > 0)
+			rational_advance (filter) ;
+		else
+		{	input_index += 1.0 / src_ratio ;
+			rem = fmod_one (input_index) ;
+
+			filter->b_current = (filter->b_current + filter->channels * lrint (input_index - rem)) % filter->b_len ;
+			input_index = rem ;
+			} ;
 		} ;
 
+	if (filter->rational_num > 0)
+		input_index = (1.0 * filter->rational_phase) / filter->rational_num ;
+
 	psrc->last_position = input_index ;
 
 	/* Save current ratio rather then target ratio. */
@@ -1162,6 +2248,373 @@ sinc_multichan_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 /*----------------------------------------------------------------------------------------
 */
 
+/*
+** Channels per group for sinc_direct_groups (), a multiple of SINC_LANES
+** whose input window fits in SINC_TILE_BYTES.
+*/
+static int
+sinc_channel_group (const SINC_FILTER *filter, int half_filter_len)
+{	int group ;
+
+	/* Past this the taps no longer fit the kernel and the half loops do the work. */
+	if (2 * half_filter_len + 2 > filter->kernel_len)
+		return filter->channels ;
+
+	group = SINC_TILE_BYTES / ((2 * half_filter_len + 2) * (int) sizeof (filter->buffer [0])) ;
+	group -= group % SINC_LANES ;
+
+	return MAX (group, SINC_LANES) ;
+} /* sinc_channel_group */
+
+/*
+** The main loop of sinc_direct_process () for a bus too wide for the input
+** window of every channel to stay in cache. Every output is made for one
+** group of channels before moving on to the next, with the kernels rebuilt
+** for each group. Leaves the position after the last output, as the main
+** loop does.
+*/
+static void
+sinc_direct_groups (SINC_FILTER *filter, SRC_DATA *data, int group, int half_filter_len, double src_ratio,
+			long *current_ptr, double *input_index_ptr, long *out_gen_ptr)
+{	double		input_index = 0.0, float_increment, scale, rem ;
+	increment_t	increment, start_filter_index ;
+	const float	*in ;
+	float		*output ;
+	long		current = 0, out_gen = 0 ;
+	int			channels, base, width, taps, first, ch ;
+
+	channels = filter->channels ;
+
+	float_increment = filter->index_inc * (src_ratio < 1.0 ? src_ratio : 1.0) ;
+	increment = double_to_fp (float_increment) ;
+	scale = float_increment / filter->index_inc ;
+
+	for (base = 0 ; base < channels ; base += group)
+	{	width = MIN (group, channels - base) ;
+
+		current = *current_ptr ;
+		input_index = *input_index_ptr ;
+		out_gen = *out_gen_ptr ;
+
+		while (out_gen < data->output_frames && current + half_filter_len < data->input_frames)
+		{	start_filter_index = double_to_fp (input_index * float_increment) ;
+			in = data->data_in + current * channels + base ;
+			output = data->data_out + out_gen * channels ;
+
+			if ((taps = sinc_make_kernel (filter, filter->kernel, 1, filter->kernel_len, increment, start_filter_index, &first)) > 0)
+			{	sinc_apply_kernel_wide (filter->kernel, taps, in + channels * first, channels, width, filter->left_calc) ;
+				for (ch = 0 ; ch < width ; ch++)
+					output [base + ch] = (float) (scale * filter->left_calc [ch]) ;
+				}
+			else	/* Just this group, through the half loops. */
+				calc_output_multi (filter, data->data_in + base, channels * current, increment, start_filter_index, width, channels, scale, output + base) ;
+			out_gen ++ ;
+
+			input_index += 1.0 / src_ratio ;
+			rem = fmod_one (input_index) ;
+			current += lrint (input_index - rem) ;
+			input_index = rem ;
+			} ;
+		} ;
+
+	*current_ptr = current ;
+	*input_index_ptr = input_index ;
+	*out_gen_ptr = out_gen ;
+} /* sinc_direct_groups */
+
+/*
+** The main loop of sinc_direct_process () at a ratio of one or more, where
+** the increment is the table's own. Called from the SINC_FIXED_LOOP functions
+** below with the filter length, increment and channel count as constants, so
+** every trip count and stride is known to the compiler. Each output takes the
+** 2 * half_taps + 2 frames around it, oldest first. Only the two end taps can
+** fall outside the filter, and get a zero coefficient there, which leaves the
+** sums exactly as calc_output_single () and friends have them.
+*/
+static inline void
+sinc_fixed_loop (SRC_PRIVATE *psrc, SRC_DATA *data, int half_filter_len, long *current_ptr,
+			double *input_index_ptr, long *out_gen_ptr, int coeff_half_len, int index_inc, int channels)
+{	SINC_FILTER *filter = (SINC_FILTER*) psrc->private_data ;
+	double		sum [SINC_LANES], input_index, icoeff, rem ;
+	increment_t	increment, max_filter_index, start_filter_index, filter_index ;
+	const float	*in ;
+	float		*output ;
+	long		current, out_gen ;
+	int			half_taps, k, ch ;
+
+	increment = int_to_fp (index_inc) ;
+	max_filter_index = int_to_fp (coeff_half_len) ;
+	half_taps = coeff_half_len / index_inc ;
+
+	current = *current_ptr ;
+	input_index = *input_index_ptr ;
+	out_gen = *out_gen_ptr ;
+
+	while (out_gen < data->output_frames && current + half_filter_len < data->input_frames)
+	{	start_filter_index = double_to_fp (input_index * index_inc) ;
+		in = data->data_in + (current - half_taps) * channels ;
+		output = data->data_out + out_gen * channels ;
+
+		filter_index = start_filter_index + half_taps * increment ;
+		icoeff = filter_index <= max_filter_index ? sinc_coeff (filter, filter_index) : 0.0 ;
+		for (ch = 0 ; ch < channels ; ch++)
+			sum [ch] = 0.0 + icoeff * in [ch] ;
+
+		/* The rest of the left half, up to and including the output's own frame. */
+		for (k = 1 ; k <= half_taps ; k++)
+		{	icoeff = sinc_coeff (filter, start_filter_index + (half_taps - k) * increment) ;
+			for (ch = 0 ; ch < channels ; ch++)
+				sum [ch] += icoeff * in [k * channels + ch] ;
+			} ;
+
+		/* The right half but its last tap. */
+		for (k = 1 ; k <= half_taps ; k++)
+		{	icoeff = sinc_coeff (filter, k * increment - start_filter_index) ;
+			for (ch = 0 ; ch < channels ; ch++)
+				sum [ch] += icoeff * in [(half_taps + k) * channels + ch] ;
+			} ;
+
+		filter_index = (half_taps + 1) * increment - start_filter_index ;
+		icoeff = filter_index <= max_filter_index ? sinc_coeff (filter, filter_index) : 0.0 ;
+		for (ch = 0 ; ch < channels ; ch++)
+			output [ch] = (float) (sum [ch] + icoeff * in [(2 * half_taps + 1) * channels + ch]) ;
+
+		out_gen ++ ;
+
+		input_index += 1.0 / psrc->last_ratio ;
+		rem = fmod_one (input_index) ;
+		current += lrint (input_index - rem) ;
+		input_index = rem ;
+		} ;
+
+	*current_ptr = current ;
+	*input_index_ptr = input_index ;
+	*out_gen_ptr = out_gen ;
+} /* sinc_fixed_loop */
+
+/*
+** One sinc_fixed_loop () per converter and common channel count. The table
+** lengths and increments are constant, so the compiler folds them in.
+*/
+#define	SINC_FIXED_LOOP(name, table, channels) \
+	static void \
+	sinc_fixed_loop_##name##_##channels (SRC_PRIVATE *psrc, SRC_DATA *data, int half_filter_len, \
+				long *current_ptr, double *input_index_ptr, long *out_gen_ptr) \
+	{	sinc_fixed_loop (psrc, data, half_filter_len, current_ptr, input_index_ptr, out_gen_ptr, \
+				ARRAY_LEN (table.coeffs) - 2, table.increment, channels) ; \
+	}
+
+#define	SINC_FIXED_LOOPS(name, table) \
+	SINC_FIXED_LOOP (name, table, 1) \
+	SINC_FIXED_LOOP (name, table, 2) \
+	SINC_FIXED_LOOP (name, table, 4) \
+	SINC_FIXED_LOOP (name, table, 6) \
+	SINC_FIXED_LOOP (name, table, 8)
+
+#define	SINC_FIXED_ROW(name) \
+	{	sinc_fixed_loop_##name##_1, sinc_fixed_loop_##name##_2, sinc_fixed_loop_##name##_4, \
+		sinc_fixed_loop_##name##_6, sinc_fixed_loop_##name##_8 \
+		}
+
+SINC_FIXED_LOOPS (fastest, fastest_coeffs)
+SINC_FIXED_LOOPS (medium, slow_mid_qual_coeffs)
+SINC_FIXED_LOOPS (best, slow_high_qual_coeffs)
+
+static void
+sinc_set_fixed_loop (SINC_FILTER *filter, int src_enum)
+{	static void (* const loops [3][5]) (SRC_PRIVATE *psrc, SRC_DATA *data, int half_filter_len,
+						long *current_ptr, double *input_index_ptr, long *out_gen_ptr) =
+	{	SINC_FIXED_ROW (fastest),
+		SINC_FIXED_ROW (medium),
+		SINC_FIXED_ROW (best)
+		} ;
+	static const int channel_counts [5] = { 1, 2, 4, 6, 8 } ;
+	int k ;
+
+	filter->fixed_loop = NULL ;
+
+	if (src_enum < SRC_SINC_BEST_QUALITY || src_enum > SRC_SINC_FASTEST)
+		return ;
+
+	for (k = 0 ; k < ARRAY_LEN (channel_counts) ; k++)
+		if (channel_counts [k] == filter->channels)
+			filter->fixed_loop = loops [SRC_SINC_FASTEST - src_enum][k] ;
+} /* sinc_set_fixed_loop */
+
+/*
+** Constant ratio processing. When the caller passes a block much longer than
+** the filter, the outputs whose filter support lies wholly inside it are
+** computed straight from data_in rather than from a copy in filter->buffer.
+** Only the edges of the block go through the buffer: enough of its start for
+** the filter to move off the history, and on the way out the history needed
+** by the next call.
+*/
+static int
+sinc_direct_process (SRC_PRIVATE *psrc, SRC_DATA *data)
+{	SINC_FILTER *filter ;
+	SRC_DATA	edge ;
+	double		input_index, src_ratio, count, float_increment, scale, rem ;
+	double		block_index ;
+	increment_t	increment, start_filter_index, block_start [SINC_BLOCK_LEN] ;
+	float		*output ;
+	long		in_frames, in_used, out_gen, current, first, last, block_pos [SINC_BLOCK_LEN] ;
+	int			channels, half_filter_len, group, error, j ;
+
+	if ((filter = (SINC_FILTER*) psrc->private_data) == NULL)
+		return SRC_ERR_NO_PRIVATE ;
+
+	channels = filter->channels ;
+	in_frames = data->input_frames ;
+	src_ratio = psrc->last_ratio ;
+
+	/* Same as in the process functions. */
+	count = (filter->coeff_half_len + 2.0) / filter->index_inc ;
+	if (MIN (psrc->last_ratio, data->src_ratio) < 1.0)
+		count /= MIN (psrc->last_ratio, data->src_ratio) ;
+	half_filter_len = (int) lrint (count) + 1 ;
+
+	if (filter->b_real_end >= 0 || in_frames < SINC_DIRECT_MIN_LEN * half_filter_len
+			|| in_frames > INT_MAX / channels)
+		return filter->buffer_process (psrc, data) ;
+
+	/* Take the start of the block through the buffer as usual. */
+	edge = *data ;
+	edge.input_frames = 2 * half_filter_len + 2 ;
+	edge.end_of_input = SRC_FALSE ;
+
+	if ((error = filter->buffer_process (psrc, &edge)) != 0)
+		return error ;
+
+	in_used = edge.input_frames_used ;
+	out_gen = edge.output_frames_gen ;
+
+	/* The frame of data_in at or before the next output. */
+	input_index = psrc->last_position ;
+	rem = fmod_one (input_index) ;
+	current = in_used - (filter->b_end - filter->b_current) / channels + lrint (input_index - rem) ;
+	input_index = rem ;
+
+	if (out_gen >= data->output_frames || in_used < edge.input_frames || current < half_filter_len)
+	{	data->input_frames_used = in_used ;
+		data->output_frames_gen = out_gen ;
+		return SRC_ERR_NO_ERROR ;
+		} ;
+
+	float_increment = filter->index_inc * (src_ratio < 1.0 ? src_ratio : 1.0) ;
+	increment = double_to_fp (float_increment) ;
+	scale = float_increment / filter->index_inc ;
+
+	/* Very wide buses go a group of channels at a time, leaving nothing for the loop below. */
+	if ((group = sinc_channel_group (filter, half_filter_len)) < channels)
+		sinc_direct_groups (filter, data, group, half_filter_len, src_ratio, &current, &input_index, &out_gen) ;
+
+	filter->group_width = MIN (group, channels) ;
+
+	/* The common converters and channel counts have a loop of their own above one. */
+	if (filter->fixed_loop != NULL && src_ratio >= 1.0)
+		filter->fixed_loop (psrc, data, half_filter_len, &current, &input_index, &out_gen) ;
+
+	while (out_gen < data->output_frames && current + half_filter_len < in_frames)
+	{	start_filter_index = double_to_fp (input_index * float_increment) ;
+		output = data->data_out + out_gen * channels ;
+
+		/* Mono and stereo take several outputs per pass over the input. */
+		if (channels <= 2 && out_gen + SINC_BLOCK_LEN <= data->output_frames)
+		{	block_pos [0] = current ;
+			block_start [0] = start_filter_index ;
+			block_index = input_index ;
+
+			for (j = 1 ; j < SINC_BLOCK_LEN ; j++)
+			{	block_index += 1.0 / src_ratio ;
+				rem = fmod_one (block_index) ;
+				block_pos [j] = block_pos [j - 1] + lrint (block_index - rem) ;
+				block_index = rem ;
+				block_start [j] = double_to_fp (block_index * float_increment) ;
+				} ;
+
+			/* Literal channel counts, so the inner loop unrolls away. */
+			if (block_pos [SINC_BLOCK_LEN - 1] + half_filter_len < in_frames
+					&& (channels == 1 ?
+						calc_output_block (filter, data->data_in, block_pos, block_start, increment, 1, scale, output) :
+						calc_output_block (filter, data->data_in, block_pos, block_start, increment, 2, scale, output)) > 0)
+			{	out_gen += SINC_BLOCK_LEN ;
+
+				block_index += 1.0 / src_ratio ;
+				rem = fmod_one (block_index) ;
+				current = block_pos [SINC_BLOCK_LEN - 1] + lrint (block_index - rem) ;
+				input_index = rem ;
+				continue ;
+				} ;
+			} ;
+
+		switch (channels)
+		{	case 1 :
+				output [0] = (float) (scale * calc_output_single (filter, data->data_in, current, increment, start_filter_index)) ;
+				break ;
+			case 2 :
+				calc_output_stereo (filter, data->data_in, 2 * current, increment, start_filter_index, scale, output) ;
+				break ;
+			case 4 :
+				calc_output_quad (filter, data->data_in, 4 * current, increment, start_filter_index, scale, output) ;
+				break ;
+			case 6 :
+				calc_output_hex (filter, data->data_in, 6 * current, increment, start_filter_index, scale, output) ;
+				break ;
+			default :
+				if (calc_output_kernel (filter, data->data_in + channels * current, increment, start_filter_index, channels, scale, output) == 0)
+					calc_output_multi (filter, data->data_in, channels * current, increment, start_filter_index, channels, channels, scale, output) ;
+				break ;
+			} ;
+		out_gen ++ ;
+
+		input_index += 1.0 / src_ratio ;
+		rem = fmod_one (input_index) ;
+		current += lrint (input_index - rem) ;
+		input_index = rem ;
+		} ;
+
+	/* Leave the buffer holding the history for the next output and a little more. */
+	first = current - half_filter_len ;
+	last = MIN (in_frames, current + half_filter_len + 1) ;
+
+	memcpy (filter->buffer, data->data_in + first * channels, (last - first) * channels * sizeof (filter->buffer [0])) ;
+	filter->b_current = half_filter_len * channels ;
+	filter->b_end = (last - first) * channels ;
+
+	in_used = last ;
+	psrc->last_position = input_index ;
+
+	if (in_used == in_frames && data->end_of_input && out_gen < data->output_frames)
+	{	/* Let the buffer code handle the end of input. */
+		edge = *data ;
+		edge.data_in = data->data_in + in_frames * channels ;
+		edge.input_frames = 0 ;
+		edge.data_out = data->data_out + out_gen * channels ;
+		edge.output_frames = data->output_frames - out_gen ;
+
+		if ((error = filter->buffer_process (psrc, &edge)) != 0)
+			return error ;
+
+		out_gen += edge.output_frames_gen ;
+		} ;
+
+	data->input_frames_used = in_used ;
+	data->output_frames_gen = out_gen ;
+
+	return SRC_ERR_NO_ERROR ;
+} /* sinc_direct_process */
+
+/*----------------------------------------------------------------------------------------
+*/
+
+/*
+** Only half_filter_chan_len samples of history are kept behind b_current, as
+** much as the filter of the current call needs, and there is no zeroed guard
+** in front of buffer. After the ratio drops the filter can reach back past
+** the start of buffer. Each calc_output_* () then clamps its left half to
+** the first tap inside buffer, once per output, and counts the rest as
+** silence. Anything changing this layout has to keep that clamp in step.
+*/
 static int
 prepare_data (SINC_FILTER *filter, SRC_DATA *data, int half_filter_chan_len)
 {	int len = 0 ;
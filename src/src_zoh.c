@@ -17,6 +17,8 @@
 static int zoh_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data) ;
 static void zoh_reset (SRC_PRIVATE *psrc) ;
 static int zoh_copy (SRC_PRIVATE *from, SRC_PRIVATE *to) ;
+static double zoh_latency (SRC_PRIVATE *psrc, double src_ratio) ;
+static long zoh_predict (SRC_PRIVATE *psrc, double start_ratio, double end_ratio, long input_frames, long output_frames) ;
 
 /*========================================================================================
 */
@@ -73,7 +75,9 @@ zoh_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 		if (priv->in_used + priv->channels * input_index >= priv->in_count)
 			break ;
 
-		if (priv->out_count > 0 && fabs (psrc->last_ratio - data->src_ratio) > SRC_MIN_RATIO_DIFF)
+		if (psrc->envelope != NULL)
+			src_ratio = envelope_ratio (psrc->envelope, priv->out_gen / priv->channels) ;
+		else if (priv->out_count > 0 && fabs (psrc->last_ratio - data->src_ratio) > SRC_MIN_RATIO_DIFF)
 			src_ratio = psrc->last_ratio + priv->out_gen * (data->src_ratio - psrc->last_ratio) / priv->out_count ;
 
 		for (ch = 0 ; ch < priv->channels ; ch++)
@@ -92,7 +96,9 @@ zoh_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 	/* Main processing loop. */
 	while (priv->out_gen < priv->out_count && priv->in_used + priv->channels * input_index <= priv->in_count)
 	{
-		if (priv->out_count > 0 && fabs (psrc->last_ratio - data->src_ratio) > SRC_MIN_RATIO_DIFF)
+		if (psrc->envelope != NULL)
+			src_ratio = envelope_ratio (psrc->envelope, priv->out_gen / priv->channels) ;
+		else if (priv->out_count > 0 && fabs (psrc->last_ratio - data->src_ratio) > SRC_MIN_RATIO_DIFF)
 			src_ratio = psrc->last_ratio + priv->out_gen * (data->src_ratio - psrc->last_ratio) / priv->out_count ;
 
 		for (ch = 0 ; ch < priv->channels ; ch++)
@@ -174,8 +180,11 @@ zoh_set_converter (SRC_PRIVATE *psrc, int src_enum)
 
 	psrc->const_process = zoh_vari_process ;
 	psrc->vari_process = zoh_vari_process ;
+	psrc->envelope_process = zoh_vari_process ;
 	psrc->reset = zoh_reset ;
 	psrc->copy = zoh_copy ;
+	psrc->latency = zoh_latency ;
+	psrc->predict = zoh_predict ;
 
 	zoh_reset (psrc) ;
 
@@ -218,3 +227,52 @@ zoh_copy (SRC_PRIVATE *from, SRC_PRIVATE *to)
 
 	return SRC_ERR_NO_ERROR ;
 } /* zoh_copy */
+
+static double
+zoh_latency (SRC_PRIVATE * UNUSED (psrc), double UNUSED (src_ratio))
+{	/* Output holds the frame before the one it lands on. */
+	return 1.0 ;
+} /* zoh_latency */
+
+static long
+zoh_predict (SRC_PRIVATE *psrc, double start_ratio, double end_ratio, long input_frames, long output_frames)
+{	double	src_ratio, input_index, rem ;
+	long	in_count, in_used, out_count, out_gen ;
+	int		channels = psrc->channels ;
+
+	/* Step through the index exactly as zoh_vari_process () does. */
+	if (input_frames <= 0)
+		return 0 ;
+
+	in_count = input_frames * channels ;
+	out_count = output_frames * channels ;
+	in_used = out_gen = 0 ;
+
+	src_ratio = start_ratio ;
+	input_index = psrc->last_position ;
+
+	while (input_index < 1.0 && out_gen < out_count)
+	{	if (in_used + channels * input_index >= in_count)
+			break ;
+		if (out_count > 0 && fabs (start_ratio - end_ratio) > SRC_MIN_RATIO_DIFF)
+			src_ratio = start_ratio + out_gen * (end_ratio - start_ratio) / out_count ;
+		out_gen += channels ;
+		input_index += 1.0 / src_ratio ;
+		} ;
+
+	rem = fmod_one (input_index) ;
+	in_used += channels * lrint (input_index - rem) ;
+	input_index = rem ;
+
+	while (out_gen < out_count && in_used + channels * input_index <= in_count)
+	{	if (out_count > 0 && fabs (start_ratio - end_ratio) > SRC_MIN_RATIO_DIFF)
+			src_ratio = start_ratio + out_gen * (end_ratio - start_ratio) / out_count ;
+		out_gen += channels ;
+		input_index += 1.0 / src_ratio ;
+		rem = fmod_one (input_index) ;
+		in_used += channels * lrint (input_index - rem) ;
+		input_index = rem ;
+		} ;
+
+	return out_gen / channels ;
+} /* zoh_predict */
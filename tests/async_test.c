@@ -0,0 +1,324 @@
+/*
+** Copyright (c) 2002-2016, Erik de Castro Lopo <erikd@mega-nerd.com>
+** All rights reserved.
+**
+** This code is released under 2-clause BSD license. Please see the
+** file at : https://github.com/libsndfile/libsamplerate/blob/master/COPYING
+*/
+
+#include "src_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#if HAVE_PTHREAD && HAVE_STDATOMIC_H
+
+#include <samplerate.h>
+
+#include "util.h"
+
+#define	BUFFER_LEN		20000
+#define	CHANNELS		2
+#define	CB_BLOCK_LEN	300
+#define	READ_LEN		256
+
+typedef struct
+{	long	pos ;
+	int		sleep_usec ;
+	float	block [CB_BLOCK_LEN * CHANNELS] ;
+} TEST_CB_DATA ;
+
+static void async_test (int converter, double src_ratio, long ring_frames, int sleep_usec) ;
+static void bad_args_test (void) ;
+static void hand_out_test (void) ;
+static long read_all (SRC_STATE *state, double src_ratio, float *out, long out_len) ;
+static long test_callback (void *cb_data, float **data) ;
+
+static float input [BUFFER_LEN * CHANNELS] ;
+static float sync_output [BUFFER_LEN * CHANNELS * 3] ;
+static float async_output [BUFFER_LEN * CHANNELS * 3] ;
+
+int
+main (void)
+{	static const double freq = 0.0531 ;
+
+	puts ("") ;
+
+	gen_windowed_sines (1, &freq, 0.9, input, BUFFER_LEN * CHANNELS) ;
+
+	bad_args_test () ;
+	hand_out_test () ;
+
+	async_test (SRC_SINC_FASTEST, 1.37, 0, 0) ;
+	async_test (SRC_SINC_FASTEST, 0.52, 1000, 0) ;
+	async_test (SRC_LINEAR, 2.9, 512, 0) ;
+
+	/* A slow callback and a small ring, so reads run dry. */
+	async_test (SRC_SINC_FASTEST, 1.0, 400, 200) ;
+
+	puts ("") ;
+
+	return 0 ;
+} /* main */
+
+/*
+** Reading ahead on another thread must not change the output, however
+** the reads get split up by underruns.
+*/
+static void
+async_test (int converter, double src_ratio, long ring_frames, int sleep_usec)
+{	SRC_ASYNC_CONFIG	config ;
+	SRC_ASYNC_STATS		stats ;
+	TEST_CB_DATA		cb_data ;
+	SRC_STATE	*state ;
+	long		sync_frames, async_frames, k ;
+	int			err ;
+
+	printf ("\tasync_test (%-26s, ratio %5.3f, ring %5ld, sleep %3d) ... ", src_get_name (converter), src_ratio, ring_frames, sleep_usec) ;
+	fflush (stdout) ;
+
+	memset (&cb_data, 0, sizeof (cb_data)) ;
+	if ((state = src_callback_new (test_callback, converter, CHANNELS, &err, &cb_data)) == NULL)
+	{	printf ("\n\nLine %d : src_callback_new () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+	sync_frames = read_all (state, src_ratio, sync_output, ARRAY_LEN (sync_output) / CHANNELS) ;
+	state = src_delete (state) ;
+
+	memset (&cb_data, 0, sizeof (cb_data)) ;
+	cb_data.sleep_usec = sleep_usec ;
+	if ((state = src_callback_new (test_callback, converter, CHANNELS, &err, &cb_data)) == NULL)
+	{	printf ("\n\nLine %d : src_callback_new () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	memset (&config, 0, sizeof (config)) ;
+	config.ring_frames = ring_frames ;
+
+	if ((err = src_callback_set_async (state, &config)) != 0)
+	{	printf ("\n\nLine %d : src_callback_set_async () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	async_frames = read_all (state, src_ratio, async_output, ARRAY_LEN (async_output) / CHANNELS) ;
+
+	if ((err = src_callback_get_async_stats (state, &stats)) != 0)
+	{	printf ("\n\nLine %d : src_callback_get_async_stats () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	state = src_delete (state) ;
+
+	if (stats.end_of_input == 0 || stats.fill != 0)
+	{	printf ("\n\nLine %d : end_of_input %d, fill %ld at the end.\n\n", __LINE__, stats.end_of_input, stats.fill) ;
+		exit (1) ;
+		} ;
+
+	if (async_frames != sync_frames)
+	{	printf ("\n\nLine %d : async gave %ld frames, sync %ld frames.\n\n", __LINE__, async_frames, sync_frames) ;
+		exit (1) ;
+		} ;
+
+	for (k = 0 ; k < sync_frames * CHANNELS ; k++)
+		if (async_output [k] != sync_output [k])
+		{	printf ("\n\nLine %d : outputs differ at sample %ld.\n\n", __LINE__, k) ;
+			exit (1) ;
+			} ;
+
+	printf ("ok (%ld underruns)\n", stats.underruns) ;
+} /* async_test */
+
+static void
+bad_args_test (void)
+{	SRC_ASYNC_CONFIG	config ;
+	SRC_ASYNC_STATS		stats ;
+	TEST_CB_DATA		cb_data ;
+	SRC_STATE	*state, *clone ;
+	int			err ;
+
+	printf ("\tbad_args_test ...................................................... ") ;
+	fflush (stdout) ;
+
+	if ((state = src_new (SRC_LINEAR, CHANNELS, &err)) == NULL)
+	{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	if (src_callback_set_async (state, NULL) == 0)
+	{	printf ("\n\nLine %d : src_callback_set_async () should fail in process mode.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	state = src_delete (state) ;
+
+	memset (&cb_data, 0, sizeof (cb_data)) ;
+	if ((state = src_callback_new (test_callback, SRC_LINEAR, CHANNELS, &err, &cb_data)) == NULL)
+	{	printf ("\n\nLine %d : src_callback_new () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	if (src_callback_get_async_stats (state, &stats) == 0)
+	{	printf ("\n\nLine %d : src_callback_get_async_stats () should fail before read-ahead is on.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	memset (&config, 0, sizeof (config)) ;
+	config.ring_frames = 1000 ;
+	config.high_water = 500 ;
+	config.low_water = 600 ;
+
+	if (src_callback_set_async (state, &config) == 0)
+	{	printf ("\n\nLine %d : src_callback_set_async () should fail with low_water above high_water.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	if ((err = src_callback_set_async (state, NULL)) != 0)
+	{	printf ("\n\nLine %d : src_callback_set_async () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	if (src_callback_set_async (state, NULL) == 0)
+	{	printf ("\n\nLine %d : src_callback_set_async () should fail the second time.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	if ((clone = src_clone (state, &err)) != NULL || err == 0)
+	{	printf ("\n\nLine %d : src_clone () should fail with read-ahead on.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	/* Deleting with the thread part way through the input. */
+	state = src_delete (state) ;
+
+	puts ("ok") ;
+} /* bad_args_test */
+
+/*
+** The converter must not be handed the whole ring in one go, or the producer
+** thinks the ring is full until it has run completely dry. It gets at most
+** half the low water mark at a time, so after a short read from a full ring
+** no more than that is out of it, with the default and a set low water mark.
+*/
+static void
+hand_out_test (void)
+{	static const long low_waters [] = { 0, 256 } ;
+	SRC_ASYNC_CONFIG	config ;
+	SRC_ASYNC_STATS		stats ;
+	TEST_CB_DATA		cb_data ;
+	SRC_STATE	*state ;
+	long		low_water ;
+	int			k, err ;
+
+	printf ("\thand_out_test ...................................................... ") ;
+	fflush (stdout) ;
+
+	for (k = 0 ; k < ARRAY_LEN (low_waters) ; k++)
+	{	memset (&cb_data, 0, sizeof (cb_data)) ;
+		if ((state = src_callback_new (test_callback, SRC_LINEAR, CHANNELS, &err, &cb_data)) == NULL)
+		{	printf ("\n\nLine %d : src_callback_new () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+			exit (1) ;
+			} ;
+
+		memset (&config, 0, sizeof (config)) ;
+		config.ring_frames = 4096 ;
+		config.low_water = low_waters [k] ;
+
+		if ((err = src_callback_set_async (state, &config)) != 0)
+		{	printf ("\n\nLine %d : src_callback_set_async () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+			exit (1) ;
+			} ;
+
+		if (src_callback_read (state, 1.0, 16, async_output) != 16)
+		{	printf ("\n\nLine %d : src_callback_read () gave a short read.\n\n", __LINE__) ;
+			exit (1) ;
+			} ;
+
+		src_callback_get_async_stats (state, &stats) ;
+		state = src_delete (state) ;
+
+		low_water = low_waters [k] > 0 ? low_waters [k] : config.ring_frames / 2 ;
+
+		if (stats.fill < config.ring_frames - low_water / 2)
+		{	printf ("\n\nLine %d : only %ld of %ld frames left in the ring after a short read.\n\n",
+					__LINE__, stats.fill, config.ring_frames) ;
+			exit (1) ;
+			} ;
+		} ;
+
+	puts ("ok") ;
+} /* hand_out_test */
+
+/*
+** Reads until src_callback_read () returns zero, which must be the end of the
+** stream even while reading ahead. An underrun gives -1 instead.
+*/
+static long
+read_all (SRC_STATE *state, double src_ratio, float *out, long out_len)
+{	SRC_ASYNC_STATS	stats ;
+	long	frames, total = 0 ;
+
+	for (;;)
+	{	frames = src_callback_read (state, src_ratio, MIN (READ_LEN, out_len - total), out + total * CHANNELS) ;
+
+		if (frames < 0)
+		{	if (src_error (state) == 0)
+			{	printf ("\n\nLine %d : src_callback_read () gave %ld with no error.\n\n", __LINE__, frames) ;
+				exit (1) ;
+				} ;
+
+			/* Underrun, the read-ahead thread will catch up. */
+			usleep (100) ;
+			continue ;
+			} ;
+
+		if (src_error (state) != 0)
+		{	printf ("\n\nLine %d : src_callback_read () failed : %s\n\n", __LINE__, src_strerror (src_error (state))) ;
+			exit (1) ;
+			} ;
+
+		total += frames ;
+		if (frames > 0)
+			continue ;
+
+		if (src_callback_get_async_stats (state, &stats) == 0 && stats.end_of_input == 0)
+		{	printf ("\n\nLine %d : src_callback_read () returned 0 before the end of input.\n\n", __LINE__) ;
+			exit (1) ;
+			} ;
+		break ;
+		} ;
+
+	return total ;
+} /* read_all */
+
+static long
+test_callback (void *cb_data, float **data)
+{	TEST_CB_DATA *pcb_data = (TEST_CB_DATA *) cb_data ;
+	long	frames ;
+
+	if (pcb_data->sleep_usec > 0)
+		usleep (pcb_data->sleep_usec) ;
+
+	frames = MIN (CB_BLOCK_LEN, BUFFER_LEN - pcb_data->pos) ;
+
+	/* The ring must take a copy, so hand out a block that gets overwritten. */
+	memcpy (pcb_data->block, input + pcb_data->pos * CHANNELS, frames * CHANNELS * sizeof (float)) ;
+	pcb_data->pos += frames ;
+
+	*data = pcb_data->block ;
+
+	return frames ;
+} /* test_callback */
+
+#else
+
+int
+main (void)
+{
+	puts ("\tCan't run this test on this platform.") ;
+	return 0 ;
+} /* main */
+
+#endif
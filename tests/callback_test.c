@@ -39,6 +39,10 @@ main (void)
 	for (k = 0 ; k < ARRAY_LEN (src_ratios) ; k++)
 		callback_test (SRC_LINEAR, src_ratios [k]) ;
 
+	puts ("    Cubic Hermite interpolator :") ;
+	for (k = 0 ; k < ARRAY_LEN (src_ratios) ; k++)
+		callback_test (SRC_CUBIC_HERMITE, src_ratios [k]) ;
+
 	puts ("    Sinc interpolator :") ;
 	for (k = 0 ; k < ARRAY_LEN (src_ratios) ; k++)
 		callback_test (SRC_SINC_FASTEST, src_ratios [k]) ;
@@ -48,6 +52,7 @@ main (void)
 	puts ("    End of stream test :") ;
 	end_of_stream_test (SRC_ZERO_ORDER_HOLD) ;
 	end_of_stream_test (SRC_LINEAR) ;
+	end_of_stream_test (SRC_CUBIC_HERMITE) ;
 	end_of_stream_test (SRC_SINC_FASTEST) ;
 
 	puts ("") ;
@@ -121,6 +121,8 @@ main (void)
 
 	clone_test (SRC_ZERO_ORDER_HOLD) ;
 	clone_test (SRC_LINEAR) ;
+	clone_test (SRC_OPTIMAL_4POINT) ;
+	clone_test (SRC_OPTIMAL_6POINT) ;
 	clone_test (SRC_SINC_FASTEST) ;
 
 	puts("");
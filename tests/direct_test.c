@@ -0,0 +1,127 @@
+/*
+** Copyright (c) 2002-2016, Erik de Castro Lopo <erikd@mega-nerd.com>
+** All rights reserved.
+**
+** This code is released under 2-clause BSD license. Please see the
+** file at : https://github.com/libsndfile/libsamplerate/blob/master/COPYING
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <samplerate.h>
+
+#include "util.h"
+
+#define	BUFFER_LEN		20000
+
+/* Wide enough for a bus of more than 128 channels to go in channel groups. */
+#define	WIDE_CHANNELS	160
+#define	WIDE_LEN		2000
+
+static void direct_test (int converter, int channels, long frames, double src_ratio, long out_block) ;
+static long run_blocks (int converter, int channels, long frames, double src_ratio, long in_block, long out_block, float *out, long out_len) ;
+
+static float input [WIDE_LEN * WIDE_CHANNELS] ;
+static float small_output [WIDE_LEN * WIDE_CHANNELS * 3] ;
+static float large_output [WIDE_LEN * WIDE_CHANNELS * 3] ;
+
+int
+main (void)
+{	static const int channels [] = { 1, 2, 3, 4, 6 } ;
+	static const double ratios [] = { 0.37, 1.0, 2.731 } ;
+	int		k, ch ;
+
+	puts ("") ;
+
+	for (ch = 0 ; ch < ARRAY_LEN (channels) ; ch++)
+		for (k = 0 ; k < ARRAY_LEN (ratios) ; k++)
+			direct_test (SRC_SINC_FASTEST, channels [ch], BUFFER_LEN, ratios [k], BUFFER_LEN * 3) ;
+
+	/* Output running out part way through a block. */
+	direct_test (SRC_SINC_FASTEST, 2, BUFFER_LEN, 1.37, 1013) ;
+	direct_test (SRC_SINC_MEDIUM_QUALITY, 1, BUFFER_LEN, 0.52, 300) ;
+
+	/* Very wide buses, whole and in channel groups. */
+	direct_test (SRC_SINC_FASTEST, WIDE_CHANNELS, WIDE_LEN, 1.0, WIDE_LEN * 3) ;
+	direct_test (SRC_SINC_MEDIUM_QUALITY, WIDE_CHANNELS, WIDE_LEN, 0.37, WIDE_LEN * 3) ;
+
+	puts ("") ;
+
+	return 0 ;
+} /* main */
+
+/*
+** Large input blocks are filtered straight from the caller's buffer, small
+** ones through the converter's own buffer. The output must be identical.
+*/
+static void
+direct_test (int converter, int channels, long frames, double src_ratio, long out_block)
+{	static const double freq = 0.0731 ;
+	long	small_frames, large_frames, k ;
+
+	printf ("\tdirect_test (%-28s, %3d ch, ratio %5.3f, out %5ld) ... ", src_get_name (converter), channels, src_ratio, out_block) ;
+	fflush (stdout) ;
+
+	gen_windowed_sines (1, &freq, 0.9, input, frames * channels) ;
+
+	small_frames = run_blocks (converter, channels, frames, src_ratio, 50, out_block, small_output, ARRAY_LEN (small_output) / channels) ;
+	large_frames = run_blocks (converter, channels, frames, src_ratio, 7001, out_block, large_output, ARRAY_LEN (large_output) / channels) ;
+
+	if (small_frames != large_frames)
+	{	printf ("\n\nLine %d : small blocks gave %ld frames, large blocks %ld frames.\n\n", __LINE__, small_frames, large_frames) ;
+		exit (1) ;
+		} ;
+
+	if (fabs (small_frames - src_ratio * frames) > 2 + src_ratio)
+	{	printf ("\n\nLine %d : output frames %ld, should be %g.\n\n", __LINE__, small_frames, src_ratio * frames) ;
+		exit (1) ;
+		} ;
+
+	for (k = 0 ; k < small_frames * channels ; k++)
+		if (small_output [k] != large_output [k])
+		{	printf ("\n\nLine %d : outputs differ at sample %ld (%g, %g).\n\n", __LINE__, k, small_output [k], large_output [k]) ;
+			exit (1) ;
+			} ;
+
+	puts ("ok") ;
+} /* direct_test */
+
+static long
+run_blocks (int converter, int channels, long frames, double src_ratio, long in_block, long out_block, float *out, long out_len)
+{	SRC_STATE	*state ;
+	SRC_DATA	data ;
+	long		in_pos = 0, out_pos = 0 ;
+	int			err ;
+
+	if ((state = src_new (converter, channels, &err)) == NULL)
+	{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	memset (&data, 0, sizeof (data)) ;
+	data.src_ratio = src_ratio ;
+
+	do
+	{	data.data_in = input + in_pos * channels ;
+		data.input_frames = MIN (in_block, frames - in_pos) ;
+		data.end_of_input = (in_pos + data.input_frames >= frames) ;
+		data.data_out = out + out_pos * channels ;
+		data.output_frames = MIN (out_block, out_len - out_pos) ;
+
+		if ((err = src_process (state, &data)) != 0)
+		{	printf ("\n\nLine %d : src_process () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+			exit (1) ;
+			} ;
+
+		in_pos += data.input_frames_used ;
+		out_pos += data.output_frames_gen ;
+		}
+	while (data.end_of_input == 0 || data.output_frames_gen > 0) ;
+
+	state = src_delete (state) ;
+
+	return out_pos ;
+} /* run_blocks */
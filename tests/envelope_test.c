@@ -0,0 +1,273 @@
+/*
+** Copyright (c) 2002-2016, Erik de Castro Lopo <erikd@mega-nerd.com>
+** All rights reserved.
+**
+** This code is released under 2-clause BSD license. Please see the
+** file at : https://github.com/libsndfile/libsamplerate/blob/master/COPYING
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <samplerate.h>
+
+#include "util.h"
+
+#define	BUFFER_LEN		50000
+#define	OUTPUT_LEN		16000
+
+static void rate_test (int converter) ;
+static void frame_test (int converter, int channels) ;
+static void bad_args_test (void) ;
+
+static const SRC_RATIO_POINT envelope [] =
+{	{ 0, 1.0 }, { 4000, 2.0 },
+	{ 4000, 0.5 }, { 10000, 0.5 },
+	{ 14000, 1.25 }
+	} ;
+
+#define	MAX_CHANNELS	6
+
+static float input [BUFFER_LEN * MAX_CHANNELS] ;
+static float output [OUTPUT_LEN * MAX_CHANNELS] ;
+static float ratios_output [OUTPUT_LEN * MAX_CHANNELS] ;
+static float frame_output [OUTPUT_LEN * MAX_CHANNELS] ;
+static double ratios [OUTPUT_LEN] ;
+
+int
+main (void)
+{	static const double freq = 0.0113 ;
+
+	puts ("") ;
+
+	gen_windowed_sines (1, &freq, 0.9, input, ARRAY_LEN (input)) ;
+
+	bad_args_test () ;
+
+	rate_test (SRC_ZERO_ORDER_HOLD) ;
+	rate_test (SRC_LINEAR) ;
+	rate_test (SRC_CUBIC_HERMITE) ;
+
+	frame_test (SRC_ZERO_ORDER_HOLD, 2) ;
+	frame_test (SRC_LINEAR, 1) ;
+	frame_test (SRC_SINC_FASTEST, 1) ;
+	frame_test (SRC_SINC_FASTEST, 2) ;
+	frame_test (SRC_SINC_FASTEST, 4) ;
+	frame_test (SRC_SINC_FASTEST, 6) ;
+	frame_test (SRC_SINC_FASTEST, 3) ;
+
+	puts ("") ;
+
+	return 0 ;
+} /* main */
+
+static double
+envelope_ratio (long frame)
+{	int k ;
+
+	for (k = ARRAY_LEN (envelope) - 1 ; k > 0 ; k--)
+		if (envelope [k - 1].frame <= frame)
+			break ;
+
+	if (frame >= envelope [k].frame || envelope [k].frame == envelope [k - 1].frame)
+		return envelope [k].ratio ;
+
+	return envelope [k - 1].ratio + (envelope [k].ratio - envelope [k - 1].ratio)
+				* (frame - envelope [k - 1].frame) / (envelope [k].frame - envelope [k - 1].frame) ;
+} /* envelope_ratio */
+
+/*
+** The input used must match the envelope, each output frame stepping
+** 1 / ratio input frames along.
+*/
+static void
+rate_test (int converter)
+{	SRC_STATE	*state ;
+	SRC_DATA	data ;
+	double		expected = 0.0 ;
+	long		k ;
+	int			err ;
+
+	printf ("\trate_test    (%-28s, 1 ch) ........ ", src_get_name (converter)) ;
+	fflush (stdout) ;
+
+	if ((state = src_new (converter, 1, &err)) == NULL)
+	{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	memset (&data, 0, sizeof (data)) ;
+	data.data_in = input ;
+	data.input_frames = BUFFER_LEN ;
+	data.data_out = output ;
+	data.output_frames = OUTPUT_LEN ;
+	data.src_ratio = 3.0 ;
+
+	/* The envelope sets the ratio, whatever is posted. */
+	src_set_target_ratio (state, 3.5) ;
+
+	if ((err = src_process_envelope (state, &data, envelope, ARRAY_LEN (envelope))) != 0)
+	{	printf ("\n\nLine %d : src_process_envelope () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	state = src_delete (state) ;
+
+	if (data.output_frames_gen != OUTPUT_LEN)
+	{	printf ("\n\nLine %d : %ld output frames, should be %d.\n\n", __LINE__, data.output_frames_gen, OUTPUT_LEN) ;
+		exit (1) ;
+		} ;
+
+	for (k = 0 ; k < OUTPUT_LEN ; k++)
+		expected += 1.0 / envelope_ratio (k) ;
+
+	if (fabs (data.input_frames_used - expected) > 8.0)
+	{	printf ("\n\nLine %d : used %ld input frames, should be %g.\n\n", __LINE__, data.input_frames_used, expected) ;
+		exit (1) ;
+		} ;
+
+	puts ("ok") ;
+} /* rate_test */
+
+/*
+** The envelope is followed inside one process call, with its own ratio for
+** every output frame. That must give exactly what calls of one frame each
+** do, at a ratio set for each frame, and what src_process_ratios () does
+** with those ratios. A call per segment, ramping from the ratio of the frame
+** before, would not.
+*/
+static void
+frame_test (int converter, int channels)
+{	SRC_STATE	*state ;
+	SRC_DATA	data ;
+	long		in_pos = 0, k ;
+	int			err ;
+
+	printf ("	frame_test   (%-28s, %d ch) ........ ", src_get_name (converter), channels) ;
+	fflush (stdout) ;
+
+	if ((state = src_new (converter, channels, &err)) == NULL)
+	{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	memset (&data, 0, sizeof (data)) ;
+	data.data_in = input ;
+	data.input_frames = BUFFER_LEN ;
+	data.data_out = output ;
+	data.output_frames = OUTPUT_LEN ;
+
+	if ((err = src_process_envelope (state, &data, envelope, ARRAY_LEN (envelope))) != 0)
+	{	printf ("\n\nLine %d : src_process_envelope () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	if (data.output_frames_gen != OUTPUT_LEN)
+	{	printf ("\n\nLine %d : %ld output frames, should be %d.\n\n", __LINE__, data.output_frames_gen, OUTPUT_LEN) ;
+		exit (1) ;
+		} ;
+
+	/* The same curve, a ratio per frame. */
+	for (k = 0 ; k < OUTPUT_LEN ; k++)
+		ratios [k] = envelope_ratio (k) ;
+
+	src_reset (state) ;
+
+	data.data_out = ratios_output ;
+
+	if ((err = src_process_ratios (state, &data, ratios)) != 0)
+	{	printf ("\n\nLine %d : src_process_ratios () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	if (data.output_frames_gen != OUTPUT_LEN)
+	{	printf ("\n\nLine %d : %ld output frames, should be %d.\n\n", __LINE__, data.output_frames_gen, OUTPUT_LEN) ;
+		exit (1) ;
+		} ;
+
+	src_reset (state) ;
+
+	/* By hand, a call and a step in the ratio for every frame. */
+	for (k = 0 ; k < OUTPUT_LEN ; k++)
+	{	src_set_ratio (state, ratios [k]) ;
+
+		data.data_in = input + in_pos * channels ;
+		data.input_frames = BUFFER_LEN - in_pos ;
+		data.data_out = frame_output + k * channels ;
+		data.output_frames = 1 ;
+		data.src_ratio = ratios [k] ;
+
+		if ((err = src_process (state, &data)) != 0)
+		{	printf ("\n\nLine %d : src_process () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+			exit (1) ;
+			} ;
+
+		if (data.output_frames_gen != 1)
+		{	printf ("\n\nLine %d : no output for frame %ld.\n\n", __LINE__, k) ;
+			exit (1) ;
+			} ;
+
+		in_pos += data.input_frames_used ;
+		} ;
+
+	state = src_delete (state) ;
+
+	for (k = 0 ; k < OUTPUT_LEN * channels ; k++)
+	{	if (output [k] != frame_output [k])
+		{	printf ("\n\nLine %d : envelope and frame by frame outputs differ at sample %ld.\n\n", __LINE__, k) ;
+			exit (1) ;
+			} ;
+		if (ratios_output [k] != frame_output [k])
+		{	printf ("\n\nLine %d : ratios and frame by frame outputs differ at sample %ld.\n\n", __LINE__, k) ;
+			exit (1) ;
+			} ;
+		} ;
+
+	puts ("ok") ;
+} /* frame_test */
+
+static void
+bad_args_test (void)
+{	static const SRC_RATIO_POINT backwards [] = { { 100, 1.0 }, { 50, 1.0 } } ;
+	static const SRC_RATIO_POINT bad_ratio [] = { { 100, 1.0 }, { 200, 1000.0 } } ;
+
+	SRC_STATE	*state ;
+	SRC_DATA	data ;
+	int			err ;
+
+	printf ("\tbad_args_test ...................................................... ") ;
+	fflush (stdout) ;
+
+	if ((state = src_new (SRC_LINEAR, 1, &err)) == NULL)
+	{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	memset (&data, 0, sizeof (data)) ;
+	data.data_in = input ;
+	data.input_frames = 1000 ;
+	data.data_out = output ;
+	data.output_frames = 1000 ;
+	data.src_ratio = 1.0 ;
+
+	if (src_process_envelope (state, &data, backwards, ARRAY_LEN (backwards)) == 0)
+	{	printf ("\n\nLine %d : src_process_envelope () should fail for points out of order.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	if (src_process_envelope (state, &data, bad_ratio, ARRAY_LEN (bad_ratio)) == 0)
+	{	printf ("\n\nLine %d : src_process_envelope () should fail for a bad ratio.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	if (src_process_envelope (state, &data, NULL, 2) == 0)
+	{	printf ("\n\nLine %d : src_process_envelope () should fail for NULL points.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	state = src_delete (state) ;
+
+	puts ("ok") ;
+} /* bad_args_test */
@@ -0,0 +1,280 @@
+/*
+** Copyright (c) 2002-2016, Erik de Castro Lopo <erikd@mega-nerd.com>
+** All rights reserved.
+**
+** This code is released under 2-clause BSD license. Please see the
+** file at : https://github.com/libsndfile/libsamplerate/blob/master/COPYING
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <samplerate.h>
+
+#include "util.h"
+
+#define	BUFFER_LEN		(1 << 16)
+#define	BLOCK_LEN		1000
+
+#ifndef	M_PI
+#define	M_PI			3.14159265358979323846264338
+#endif
+
+static void compare_test (int channels, double src_ratio) ;
+static void ratio_test (void) ;
+static void snr_test (double src_ratio) ;
+
+static double fit_snr (const float *data, long len, double freq) ;
+
+static long process_blocks (SRC_STATE *state, const float *input, long input_frames, int channels,
+				double src_ratio, float *output, long output_len) ;
+
+static float input [BUFFER_LEN * 3] ;
+static float sinc_output [BUFFER_LEN * 3 * 4] ;
+static float fft_output [BUFFER_LEN * 3 * 4] ;
+
+int
+main (void)
+{
+	puts ("") ;
+
+	compare_test (1, 3.0) ;
+	compare_test (2, 0.6) ;
+	compare_test (3, 1.0 / 16.0) ;
+	compare_test (1, 0.3) ;
+	compare_test (2, 1.0) ;
+
+	ratio_test () ;
+
+	snr_test (3.0) ;
+	snr_test (2.0 / 3.0) ;
+	snr_test (0.5) ;
+
+	puts ("") ;
+
+	return 0 ;
+} /* main */
+
+/*
+** The FFT engine evaluates the same filter as SRC_SINC_BEST_QUALITY so the two
+** should agree to within float rounding, but for the end where the direct form
+** converter may stop a frame early.
+*/
+static void
+compare_test (int channels, double src_ratio)
+{	SRC_STATE	*state ;
+	double		error, worst = 0.0 ;
+	long		sinc_frames, fft_frames, k ;
+	int			ch, err ;
+
+	printf ("\tcompare_test (%d ch, ratio %8.6f) ........................ ", channels, src_ratio) ;
+	fflush (stdout) ;
+
+	for (k = 0 ; k < BUFFER_LEN ; k++)
+		for (ch = 0 ; ch < channels ; ch++)
+			input [k * channels + ch] = (float) (0.4 * sin (2.0 * M_PI * 0.0123 * k + ch) + 0.4 * sin (2.0 * M_PI * 0.21 * k * (ch + 1))) ;
+
+	if ((state = src_new (SRC_SINC_BEST_QUALITY, channels, &err)) == NULL)
+	{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+	sinc_frames = process_blocks (state, input, BUFFER_LEN, channels, src_ratio, sinc_output, ARRAY_LEN (sinc_output) / channels) ;
+	state = src_delete (state) ;
+
+	if ((state = src_new (SRC_SINC_BEST_QUALITY_FFT, channels, &err)) == NULL)
+	{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+	fft_frames = process_blocks (state, input, BUFFER_LEN, channels, src_ratio, fft_output, ARRAY_LEN (fft_output) / channels) ;
+	state = src_delete (state) ;
+
+	if (labs (fft_frames - sinc_frames) > 2)
+	{	printf ("\n\nLine %d : output frames %ld, sinc converter gave %ld.\n\n", __LINE__, fft_frames, sinc_frames) ;
+		exit (1) ;
+		} ;
+
+	for (k = 0 ; k < MIN (fft_frames, sinc_frames) * channels ; k++)
+	{	error = fabs (fft_output [k] - sinc_output [k]) ;
+		worst = MAX (worst, error) ;
+		} ;
+
+	if (worst > SINC_TOLERANCE (SRC_SINC_BEST_QUALITY, 1e-5))
+	{	printf ("\n\nLine %d : worst difference %g, should be < %g.\n\n", __LINE__, worst, SINC_TOLERANCE (SRC_SINC_BEST_QUALITY, 1e-5)) ;
+		exit (1) ;
+		} ;
+
+	printf ("ok (%5.1f dB)\n", 20.0 * log10 (worst + 1e-20)) ;
+} /* compare_test */
+
+static void
+ratio_test (void)
+{	SRC_STATE	*state ;
+	SRC_DATA	data ;
+	int			error ;
+
+	printf ("\tratio_test ................................................ ") ;
+	fflush (stdout) ;
+
+	/* 1.9999 is 19999 / 10000, far too many phases. */
+	memset (&data, 0, sizeof (data)) ;
+	data.data_in = input ;
+	data.input_frames = BLOCK_LEN ;
+	data.data_out = fft_output ;
+	data.output_frames = BLOCK_LEN ;
+	data.src_ratio = 1.9999 ;
+
+	if ((error = src_simple (&data, SRC_SINC_BEST_QUALITY_FFT, 1)) == 0)
+	{	printf ("\n\nLine %d : src_simple () should have failed for ratio %f.\n\n", __LINE__, data.src_ratio) ;
+		exit (1) ;
+		} ;
+
+	if ((state = src_new (SRC_SINC_BEST_QUALITY_FFT, 1, &error)) == NULL)
+	{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	data.src_ratio = 0.5 ;
+	data.end_of_input = 0 ;
+	if ((error = src_process (state, &data)) != 0)
+	{	printf ("\n\nLine %d : src_process () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	/* Changing the ratio mid stream must fail. */
+	data.src_ratio = 0.25 ;
+	if ((error = src_process (state, &data)) == 0)
+	{	printf ("\n\nLine %d : src_process () should have failed on a ratio change.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	/* But is fine after a reset. */
+	src_reset (state) ;
+	if ((error = src_process (state, &data)) != 0)
+	{	printf ("\n\nLine %d : src_process () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	state = src_delete (state) ;
+
+	puts ("ok") ;
+} /* ratio_test */
+
+/* Absolute floor for snr_test (), well under what the best quality filter gives. */
+#define	FFT_MIN_SNR		110.0
+
+/*
+** How far under SRC_SINC_BEST_QUALITY the FFT engine may fall. Built with
+** ENABLE_CUBIC_COEFFS the direct form fits cubics to the filter table, which
+** is closer than the straight lines the FFT engine draws between its taps, so
+** there only the floor applies.
+*/
+#if (ENABLE_CUBIC_COEFFS)
+#define	FFT_SNR_MARGIN	100.0
+#else
+#define	FFT_SNR_MARGIN	2.0
+#endif
+
+/*
+** A sine through the FFT engine and through SRC_SINC_BEST_QUALITY, with the
+** SNR of each taken from a sine fit rather than a spectrum, so that this runs
+** without FFTW. The FFT engine must meet FFT_MIN_SNR and be within
+** FFT_SNR_MARGIN dB of the direct form converter using the same filter.
+*/
+static void
+snr_test (double src_ratio)
+{	static const int converters [] = { SRC_SINC_BEST_QUALITY, SRC_SINC_BEST_QUALITY_FFT } ;
+	SRC_STATE	*state ;
+	double		freq = 0.0917, snr [2] ;
+	long		frames, k ;
+	int			c, err ;
+
+	printf ("	snr_test (ratio %8.6f) ................................. ", src_ratio) ;
+	fflush (stdout) ;
+
+	for (k = 0 ; k < BUFFER_LEN ; k++)
+		input [k] = (float) (0.5 * sin (2.0 * M_PI * freq * k)) ;
+
+	for (c = 0 ; c < ARRAY_LEN (converters) ; c++)
+	{	if ((state = src_new (converters [c], 1, &err)) == NULL)
+		{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+			exit (1) ;
+			} ;
+		frames = process_blocks (state, input, BUFFER_LEN, 1, src_ratio, fft_output, ARRAY_LEN (fft_output)) ;
+		state = src_delete (state) ;
+
+		/* Leave out the start up and the tail. */
+		snr [c] = fit_snr (fft_output + 2000, frames - 4000, freq / src_ratio) ;
+		} ;
+
+	if (snr [1] < FFT_MIN_SNR || snr [1] < snr [0] - FFT_SNR_MARGIN)
+	{	printf ("\n\nLine %d : SNR %5.1f dB, should be > %5.1f dB and near the %5.1f dB of %s.\n\n",
+				__LINE__, snr [1], FFT_MIN_SNR, snr [0], src_get_name (SRC_SINC_BEST_QUALITY)) ;
+		exit (1) ;
+		} ;
+
+	printf ("ok (%5.1f dB)\n", snr [1]) ;
+} /* snr_test */
+
+/*
+** Least squares fit of a sine of the given frequency, in cycles per frame,
+** returning the ratio of its power to the power of what is left in dB.
+*/
+static double
+fit_snr (const float *data, long len, double freq)
+{	double	ss = 0.0, cc = 0.0, sc = 0.0, ys = 0.0, yc = 0.0 ;
+	double	s, c, a, b, det, fit, signal = 0.0, noise = 0.0 ;
+	long	k ;
+
+	for (k = 0 ; k < len ; k++)
+	{	s = sin (2.0 * M_PI * freq * k) ;
+		c = cos (2.0 * M_PI * freq * k) ;
+		ss += s * s ;
+		cc += c * c ;
+		sc += s * c ;
+		ys += data [k] * s ;
+		yc += data [k] * c ;
+		} ;
+
+	det = ss * cc - sc * sc ;
+	a = (ys * cc - yc * sc) / det ;
+	b = (yc * ss - ys * sc) / det ;
+
+	for (k = 0 ; k < len ; k++)
+	{	fit = a * sin (2.0 * M_PI * freq * k) + b * cos (2.0 * M_PI * freq * k) ;
+		signal += fit * fit ;
+		noise += (data [k] - fit) * (data [k] - fit) ;
+		} ;
+
+	return 10.0 * log10 (signal / (noise + 1e-30)) ;
+} /* fit_snr */
+
+static long
+process_blocks (SRC_STATE *state, const float *in, long input_frames, int channels, double src_ratio, float *out, long output_len)
+{	SRC_DATA	data ;
+	long		in_pos = 0, out_pos = 0 ;
+	int			error ;
+
+	memset (&data, 0, sizeof (data)) ;
+	data.src_ratio = src_ratio ;
+
+	do
+	{	data.data_in = in + in_pos * channels ;
+		data.input_frames = MIN (BLOCK_LEN, input_frames - in_pos) ;
+		data.end_of_input = (in_pos + data.input_frames >= input_frames) ;
+		data.data_out = out + out_pos * channels ;
+		data.output_frames = MIN (BLOCK_LEN, output_len - out_pos) ;
+
+		if ((error = src_process (state, &data)) != 0)
+		{	printf ("\n\nLine %d : src_process () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+			exit (1) ;
+			} ;
+
+		in_pos += data.input_frames_used ;
+		out_pos += data.output_frames_gen ;
+		}
+	while (data.end_of_input == 0 || data.output_frames_gen > 0) ;
+
+	return out_pos ;
+} /* process_blocks */
@@ -0,0 +1,284 @@
+/*
+** Copyright (c) 2002-2016, Erik de Castro Lopo <erikd@mega-nerd.com>
+** All rights reserved.
+**
+** This code is released under 2-clause BSD license. Please see the
+** file at : https://github.com/libsndfile/libsamplerate/blob/master/COPYING
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <samplerate.h>
+
+#include "util.h"
+
+#define	BUFFER_LEN		(1 << 15)
+#define	BLOCK_LEN		64
+#define	FREQ			0.002
+
+#ifndef	M_PI
+#define	M_PI			3.14159265358979323846264338
+#endif
+
+static void prime_test (SRC_STATE *state, const char *name, int channels, double src_ratio) ;
+static void impulse_test (int converter, double src_ratio) ;
+static void bad_args_test (void) ;
+
+static float input [BUFFER_LEN * 2] ;
+static float output [BUFFER_LEN * 2 * 4] ;
+
+int
+main (void)
+{	static const int converters [] =
+	{	SRC_ZERO_ORDER_HOLD, SRC_LINEAR, SRC_CUBIC_HERMITE, SRC_LAGRANGE_6POINT,
+		SRC_SINC_FASTEST, SRC_SINC_MEDIUM_QUALITY
+		} ;
+	SRC_STATE	*state ;
+	int			k, error ;
+
+	puts ("") ;
+
+	bad_args_test () ;
+
+	for (k = 0 ; k < ARRAY_LEN (converters) ; k++)
+	{	if ((state = src_new (converters [k], 1, &error)) == NULL)
+		{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+			exit (1) ;
+			} ;
+
+		prime_test (state, src_get_name (converters [k]), 1, 1.37) ;
+		src_reset (state) ;
+		prime_test (state, src_get_name (converters [k]), 1, 0.45) ;
+		state = src_delete (state) ;
+
+		if ((state = src_new (converters [k], 2, &error)) == NULL)
+		{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+			exit (1) ;
+			} ;
+
+		prime_test (state, src_get_name (converters [k]), 2, 3.0) ;
+		state = src_delete (state) ;
+		} ;
+
+	if ((state = src_new_multistage (SRC_SINC_FASTEST, 2, 0.1, &error)) == NULL)
+	{	printf ("\n\nLine %d : src_new_multistage () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	prime_test (state, "Multi-stage", 2, 0.1) ;
+	state = src_delete (state) ;
+
+	for (k = 0 ; k < ARRAY_LEN (converters) ; k++)
+	{	impulse_test (converters [k], 1.37) ;
+		impulse_test (converters [k], 0.45) ;
+		} ;
+
+	impulse_test (SRC_SINC_BEST_QUALITY_FFT, 2.0) ;
+	impulse_test (SRC_SINC_BEST_QUALITY_FFT, 0.5) ;
+
+	puts ("") ;
+
+	return 0 ;
+} /* main */
+
+static double
+signal_value (double frame, int ch)
+{	return 0.5 * sin (2.0 * M_PI * FREQ * frame + ch + 1.0) ;
+} /* signal_value */
+
+/*
+** Prime with twice the latency worth of audio, then stream the rest. The
+** output must start straight away, without a ramp up out of silence, at the
+** input frame the latency says it should.
+*/
+static void
+prime_test (SRC_STATE *state, const char *name, int channels, double src_ratio)
+{	SRC_DATA	data ;
+	double		latency, out_latency, expected, error, worst = 0.0, max_error ;
+	long		k, prime_frames, in_pos, out_pos ;
+	int			ch, err ;
+
+	printf ("\tprime_test (%-30s, %d ch, ratio %5.3f) ........ ", name, channels, src_ratio) ;
+	fflush (stdout) ;
+
+	if ((err = src_get_latency (state, src_ratio, &latency, &out_latency)) != 0)
+	{	printf ("\n\nLine %d : src_get_latency () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	if (latency <= 0.0 || fabs (out_latency - latency * src_ratio) > 1e-9 * out_latency)
+	{	printf ("\n\nLine %d : bad latency %g input frames, %g output frames.\n\n", __LINE__, latency, out_latency) ;
+		exit (1) ;
+		} ;
+
+	for (k = 0 ; k < BUFFER_LEN ; k++)
+		for (ch = 0 ; ch < channels ; ch++)
+			input [k * channels + ch] = (float) signal_value (k, ch) ;
+
+	prime_frames = 2 * lrint (ceil (latency)) + 10 ;
+
+	if ((err = src_prime (state, src_ratio, input, prime_frames)) != 0)
+	{	printf ("\n\nLine %d : src_prime () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	memset (&data, 0, sizeof (data)) ;
+	data.src_ratio = src_ratio ;
+
+	in_pos = prime_frames ;
+	out_pos = 0 ;
+	while (in_pos < BUFFER_LEN)
+	{	data.data_in = input + in_pos * channels ;
+		data.input_frames = MIN (BLOCK_LEN, BUFFER_LEN - in_pos) ;
+		data.data_out = output + out_pos * channels ;
+		data.output_frames = ARRAY_LEN (output) / channels - out_pos ;
+
+		if ((err = src_process (state, &data)) != 0)
+		{	printf ("\n\nLine %d : src_process () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+			exit (1) ;
+			} ;
+
+		in_pos += data.input_frames_used ;
+		out_pos += data.output_frames_gen ;
+
+		/* No first block shortfall, every block gives its full share of output. */
+		if (fabs (out_pos - (in_pos - prime_frames) * src_ratio) > 2.0 + src_ratio)
+		{	printf ("\n\nLine %d : %ld output frames after %ld input frames.\n\n", __LINE__, out_pos, in_pos - prime_frames) ;
+			exit (1) ;
+			} ;
+		} ;
+
+	/* Output frame k is input frame prime_frames - latency + k / src_ratio, give or take a frame. */
+	max_error = 2.0 * M_PI * FREQ * 0.5 * (1.5 + 1.0 / src_ratio) + 2e-3 ;
+
+	for (k = 0 ; k < out_pos ; k++)
+		for (ch = 0 ; ch < channels ; ch++)
+		{	expected = signal_value (prime_frames - latency + k / src_ratio, ch) ;
+			error = fabs (output [k * channels + ch] - expected) ;
+			worst = MAX (worst, error) ;
+			} ;
+
+	if (worst > max_error)
+	{	printf ("\n\nLine %d : worst error %g, should be < %g.\n\n", __LINE__, worst, max_error) ;
+		exit (1) ;
+		} ;
+
+	printf ("ok (latency %6.1f)\n", latency) ;
+} /* prime_test */
+
+#define	IMPULSE_POS		3000
+
+/*
+** Feed a short pulse centred on input frame IMPULSE_POS through one input
+** frame at a time, and count how many more input frames it takes before the
+** output frame at its peak comes out. src_get_latency () must never be less,
+** and for all but the FFT converter, whose delay depends on where the pulse
+** falls in a block, no more than a frame or so over.
+*/
+static void
+impulse_test (int converter, double src_ratio)
+{	SRC_STATE	*state ;
+	SRC_DATA	data ;
+	double		latency, delay, low, high ;
+	long		k, in_pos = 0, out_pos = 0, peak = 0, *emitted ;
+	int			err ;
+
+	printf ("\timpulse_test (%-30s, ratio %5.3f) ......... ", src_get_name (converter), src_ratio) ;
+	fflush (stdout) ;
+
+	if ((state = src_new (converter, 1, &err)) == NULL)
+	{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	if ((err = src_get_latency (state, src_ratio, &latency, NULL)) != 0)
+	{	printf ("\n\nLine %d : src_get_latency () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	/* Wide enough that the ZOH converter cannot step over it when downsampling. */
+	memset (input, 0, sizeof (input)) ;
+	for (k = -8 ; k <= 8 ; k++)
+		input [IMPULSE_POS + k] = (float) (0.5 + 0.5 * cos (M_PI * k / 8.0)) ;
+
+	/* The input frames taken by the time each output frame came out. */
+	if ((emitted = calloc (ARRAY_LEN (output), sizeof (emitted [0]))) == NULL)
+	{	printf ("\n\nLine %d : calloc () failed.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	memset (&data, 0, sizeof (data)) ;
+	data.src_ratio = src_ratio ;
+
+	while (in_pos < BUFFER_LEN && out_pos < ARRAY_LEN (output) / 2)
+	{	data.data_in = input + in_pos ;
+		data.input_frames = 1 ;
+		data.data_out = output + out_pos ;
+		data.output_frames = ARRAY_LEN (output) - out_pos ;
+
+		if ((err = src_process (state, &data)) != 0)
+		{	printf ("\n\nLine %d : src_process () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+			exit (1) ;
+			} ;
+
+		in_pos += data.input_frames_used ;
+		for (k = 0 ; k < data.output_frames_gen ; k++)
+			emitted [out_pos++] = in_pos ;
+		} ;
+
+	state = src_delete (state) ;
+
+	for (k = 0 ; k < out_pos ; k++)
+		if (fabs (output [k]) > fabs (output [peak]))
+			peak = k ;
+
+	delay = emitted [peak] - 1 - IMPULSE_POS ;
+	free (emitted) ;
+
+	low = converter == SRC_SINC_BEST_QUALITY_FFT ? 0.0 : latency - 1.0 - 1.0 / src_ratio ;
+	high = latency ;
+
+	if (delay < low || delay > high)
+	{	printf ("\n\nLine %d : output came %g input frames late, latency says %g.\n\n", __LINE__, delay, latency) ;
+		exit (1) ;
+		} ;
+
+	printf ("ok (%6.1f / %6.1f)\n", delay, latency) ;
+} /* impulse_test */
+
+static void
+bad_args_test (void)
+{	SRC_STATE	*state ;
+	double		latency ;
+	int			error ;
+
+	printf ("\tbad_args_test ................................................ ") ;
+	fflush (stdout) ;
+
+	if (src_get_latency (NULL, 1.0, &latency, NULL) == 0)
+	{	printf ("\n\nLine %d : src_get_latency () should fail for a NULL state.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	if ((state = src_new (SRC_LINEAR, 1, &error)) == NULL)
+	{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	if (src_get_latency (state, 1000.0, &latency, NULL) == 0)
+	{	printf ("\n\nLine %d : src_get_latency () should fail for a bad ratio.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	if (src_prime (state, 1.0, NULL, 10) == 0)
+	{	printf ("\n\nLine %d : src_prime () should fail for NULL data.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	state = src_delete (state) ;
+
+	puts ("ok") ;
+} /* bad_args_test */
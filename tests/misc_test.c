@@ -18,6 +18,8 @@ static void name_test (void) ;
 static void error_test (void) ;
 static void src_ratio_test (void) ;
 static void zero_input_test (int converter) ;
+static void single_frame_test (int converter) ;
+static void left_edge_test (int channels) ;
 static void get_channels_test (int converter);
 
 int
@@ -36,8 +38,19 @@ main (void)
 
 	zero_input_test (SRC_ZERO_ORDER_HOLD) ;
 	zero_input_test (SRC_LINEAR) ;
+	zero_input_test (SRC_CUBIC_HERMITE) ;
+	zero_input_test (SRC_LAGRANGE_6POINT) ;
 	zero_input_test (SRC_SINC_FASTEST) ;
 
+	single_frame_test (SRC_ZERO_ORDER_HOLD) ;
+	single_frame_test (SRC_LINEAR) ;
+
+	left_edge_test (1) ;
+	left_edge_test (2) ;
+	left_edge_test (4) ;
+	left_edge_test (6) ;
+	left_edge_test (3) ;
+
 	get_channels_test (SRC_ZERO_ORDER_HOLD) ;
 	get_channels_test (SRC_LINEAR) ;
 	get_channels_test (SRC_SINC_FASTEST) ;
@@ -169,6 +182,124 @@ zero_input_test (int converter)
 	puts ("ok") ;
 } /* zero_input_test */
 
+/*
+** One frame a call, each from its own allocation so that reading before it
+** is caught by a memory checker. The frames before the first of a call come
+** from the last call.
+*/
+static void
+single_frame_test (int converter)
+{	SRC_DATA data ;
+	SRC_STATE *state ;
+	float out [2 * 10], *in ;
+	int error, k, j ;
+
+	printf ("    %s (%-25s) ...... ", __func__, src_get_name (converter)) ;
+	fflush (stdout) ;
+
+	if ((state = src_new (converter, 2, &error)) == NULL)
+	{	printf ("\n\nLine %d : src_new failed : %s.\n\n", __LINE__, src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	memset (&data, 0, sizeof (data)) ;
+	data.data_out = out ;
+	data.output_frames = ARRAY_LEN (out) / 2 ;
+	data.src_ratio = 1.37 ;
+
+	for (k = 0 ; k < 50 ; k++)
+	{	if ((in = malloc (2 * sizeof (in [0]))) == NULL)
+		{	printf ("\n\nLine %d : malloc failed.\n\n", __LINE__) ;
+			exit (1) ;
+			} ;
+
+		in [0] = in [1] = 0.5f ;
+		data.data_in = in ;
+		data.input_frames = 1 ;
+
+		if ((error = src_process (state, &data)))
+		{	printf ("\n\nLine %d : src_process failed : %s.\n\n", __LINE__, src_strerror (error)) ;
+			exit (1) ;
+			} ;
+
+		free (in) ;
+
+		/* Everything between the initial silence and the input. */
+		for (j = 0 ; j < 2 * data.output_frames_gen ; j++)
+			if (out [j] < 0.0f || out [j] > 0.5f)
+			{	printf ("\n\nLine %d : call %d, output %g should be within [0, 0.5].\n\n", __LINE__, k, out [j]) ;
+				exit (1) ;
+				} ;
+		} ;
+
+	state = src_delete (state) ;
+
+	puts ("ok") ;
+} /* single_frame_test */
+
+/*
+** A fresh sinc converter fed one frame a call at a high ratio keeps only the
+** little history its narrow filter needs. Stepping the ratio right down then
+** gives a filter reaching far back past the start of the buffer, which each
+** of the calc_output_* () functions must count as silence.
+*/
+static void
+left_edge_test (int channels)
+{	SRC_DATA data ;
+	SRC_STATE *state ;
+	float out [6 * 128], *in ;
+	int error, k, j, ch ;
+
+	printf ("    %s (%d channel%s) ...... ", __func__, channels, channels == 1 ? "" : "s") ;
+	fflush (stdout) ;
+
+	if ((state = src_new (SRC_SINC_FASTEST, channels, &error)) == NULL)
+	{	printf ("\n\nLine %d : src_new failed : %s.\n\n", __LINE__, src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	memset (&data, 0, sizeof (data)) ;
+	data.data_out = out ;
+	data.output_frames = ARRAY_LEN (out) / channels ;
+	data.src_ratio = 64.0 ;
+
+	for (k = 0 ; k < 2000 ; k++)
+	{	if (k == 16)
+		{	/* A step, not a ramp across the next call. */
+			data.src_ratio = 1.0 / 64 ;
+			src_set_ratio (state, data.src_ratio) ;
+			} ;
+
+		if ((in = malloc (channels * sizeof (in [0]))) == NULL)
+		{	printf ("\n\nLine %d : malloc failed.\n\n", __LINE__) ;
+			exit (1) ;
+			} ;
+
+		for (ch = 0 ; ch < channels ; ch++)
+			in [ch] = 0.5f ;
+		data.data_in = in ;
+		data.input_frames = 1 ;
+
+		if ((error = src_process (state, &data)))
+		{	printf ("\n\nLine %d : src_process failed : %s.\n\n", __LINE__, src_strerror (error)) ;
+			exit (1) ;
+			} ;
+
+		free (in) ;
+
+		/* The step response of the filter, from silence to the input. */
+		for (j = 0 ; j < channels * data.output_frames_gen ; j++)
+			if (! (out [j] >= -0.1f && out [j] <= 0.6f))
+			{	printf ("\n\nLine %d : call %d, output %g should be within [-0.1, 0.6].\n\n", __LINE__, k, out [j]) ;
+				exit (1) ;
+				} ;
+		} ;
+
+	state = src_delete (state) ;
+
+	puts ("ok") ;
+} /* left_edge_test */
+
 static void get_channels_test(int converter)
 {
 	SRC_STATE *state;
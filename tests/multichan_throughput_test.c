@@ -24,15 +24,62 @@
 static float input [BUFFER_LEN] ;
 static float output [BUFFER_LEN] ;
 
+/*
+** Channels the sinc converter filters together at the test ratio, and the
+** tile size that sets that, read back from src_get_plan () after one run.
+** Both are zero if it does not say.
+*/
+static int
+channel_group (int converter, int channels, int *tile_bytes)
+{	SRC_STATE *state ;
+	SRC_DATA src_data ;
+	const char *plan ;
+	int group, error ;
+
+	if ((state = src_new (converter, channels, &error)) == NULL)
+	{	puts (src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	memset (&src_data, 0, sizeof (src_data)) ;
+	src_data.data_in = input ;
+	src_data.input_frames = ARRAY_LEN (input) / channels ;
+	src_data.data_out = output ;
+	src_data.output_frames = ARRAY_LEN (output) / channels ;
+	src_data.src_ratio = 0.99 ;
+	src_data.end_of_input = 1 ;
+
+	if ((error = src_process (state, &src_data)) != 0)
+	{	puts (src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	if ((plan = src_get_plan (state)) == NULL || sscanf (plan, "Channel groups of %d, %d byte tile", &group, tile_bytes) != 2)
+		group = *tile_bytes = 0 ;
+
+	src_delete (state) ;
+
+	return group ;
+} /* channel_group */
+
+static void
+print_tile_size (void)
+{	int tile_bytes ;
+
+	channel_group (SRC_SINC_FASTEST, 1, &tile_bytes) ;
+	printf ("    Sinc tile : %d bytes\n", tile_bytes) ;
+} /* print_tile_size */
+
 static long
 throughput_test (int converter, int channels, long best_throughput)
 {	SRC_DATA src_data ;
 	clock_t start_time, clock_time ;
 	double duration ;
 	long total_frames = 0, throughput ;
-	int error ;
+	int error, tile_bytes ;
 
-	printf ("    %-30s     %2d         ", src_get_name (converter), channels) ;
+	printf ("    %-30s     %2d        %2d       ", src_get_name (converter), channels,
+				channel_group (converter, channels, &tile_bytes)) ;
 	fflush (stdout) ;
 
 	src_data.data_in = input ;
@@ -94,11 +141,12 @@ single_run (void)
 	int k ;
 
 	printf ("\n    CPU name : %s\n", get_cpu_name ()) ;
+	print_tile_size () ;
 
 	puts (
 		"\n"
-		"    Converter                        Channels    Duration      Throughput\n"
-		"    ---------------------------------------------------------------------"
+		"    Converter                        Channels    Group    Duration      Throughput\n"
+		"    ------------------------------------------------------------------------------"
 		) ;
 
 	for (k = 1 ; k <= max_channels / 2 ; k++)
@@ -121,11 +169,12 @@ multi_run (int run_count)
 {	int k, ch ;
 
 	printf ("\n    CPU name : %s\n", get_cpu_name ()) ;
+	print_tile_size () ;
 
 	puts (
 		"\n"
-		"    Converter                        Channels    Duration      Throughput    Best Throughput\n"
-		"    ----------------------------------------------------------------------------------------"
+		"    Converter                        Channels    Group    Duration      Throughput    Best Throughput\n"
+		"    -------------------------------------------------------------------------------------------------"
 		) ;
 
 	for (ch = 1 ; ch <= 5 ; ch++)
@@ -197,6 +246,7 @@ main (int argc, char ** argv)
 		usage_exit (argv [0]) ;
 
 	puts (
+		"            Group is the channels filtered together to keep the input in the sinc tile.\n"
 		"            Duration is in seconds.\n"
 		"            Throughput is in frames/sec (more is better).\n"
 		) ;
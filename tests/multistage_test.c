@@ -0,0 +1,229 @@
+/*
+** Copyright (c) 2002-2016, Erik de Castro Lopo <erikd@mega-nerd.com>
+** All rights reserved.
+**
+** This code is released under 2-clause BSD license. Please see the
+** file at : https://github.com/libsndfile/libsamplerate/blob/master/COPYING
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <samplerate.h>
+
+#include "util.h"
+
+#define	BUFFER_LEN		(1 << 17)
+#define	BLOCK_LEN		1000
+
+#ifndef	M_PI
+#define	M_PI			3.14159265358979323846264338
+#endif
+
+static void plan_test (void) ;
+static void sine_test (int converter, int channels, double src_ratio, double freq, double max_error) ;
+static void clone_test (int converter, double src_ratio) ;
+
+static long process_blocks (SRC_STATE *state, const float *input, long input_frames, int channels,
+				double src_ratio, float *output, long output_len) ;
+
+static float input [BUFFER_LEN * 2] ;
+static float output [BUFFER_LEN * 2] ;
+static float cloned_output [BUFFER_LEN * 2] ;
+
+int
+main (void)
+{
+	puts ("") ;
+
+	plan_test () ;
+
+	sine_test (SRC_SINC_FASTEST, 1, 1.0 / 64.0, 0.002, 1e-4) ;
+	sine_test (SRC_SINC_FASTEST, 2, 1.0 / 7.3, 0.02, 1e-4) ;
+	sine_test (SRC_SINC_MEDIUM_QUALITY, 1, 1.0 / 250.0, 0.0005, 1e-5) ;
+	sine_test (SRC_SINC_MEDIUM_QUALITY, 2, 0.0613, 0.004, 1e-5) ;
+	sine_test (SRC_SINC_MEDIUM_QUALITY, 1, 0.4, 0.05, 1e-5) ;
+
+	clone_test (SRC_SINC_FASTEST, 1.0 / 37.0) ;
+
+	puts ("") ;
+
+	return 0 ;
+} /* main */
+
+static void
+plan_test (void)
+{	SRC_STATE	*state ;
+	const char	*plan ;
+	int			error ;
+
+	printf ("\tplan_test  ...................................................... ") ;
+	fflush (stdout) ;
+
+	if ((state = src_new (SRC_SINC_FASTEST, 1, &error)) == NULL)
+	{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	if (src_get_plan (state) != NULL)
+	{	printf ("\n\nLine %d : src_get_plan () should be NULL for a single stage converter.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	state = src_delete (state) ;
+
+	if ((state = src_new_multistage (SRC_SINC_FASTEST, 1, 1.0 / 300.0, &error)) != NULL || error == 0)
+	{	printf ("\n\nLine %d : src_new_multistage () should have failed with a bad ratio.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	if ((state = src_new_multistage (SRC_SINC_FASTEST, 1, 1.0 / 256.0, &error)) == NULL)
+	{	printf ("\n\nLine %d : src_new_multistage () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	/* 1/256 should be seven half-band stages followed by a final stage at 0.5. */
+	plan = src_get_plan (state) ;
+	if (plan == NULL || strstr (plan, "(ratio 0.5)") == NULL)
+	{	printf ("\n\nLine %d : bad plan : %s\n\n", __LINE__, plan ? plan : "(null)") ;
+		exit (1) ;
+		} ;
+
+	for (error = 0 ; (plan = strstr (plan, "Half-band")) != NULL ; error ++)
+		plan ++ ;
+
+	if (error != 7)
+	{	printf ("\n\nLine %d : expected 7 decimator stages, got %d : %s\n\n", __LINE__, error, src_get_plan (state)) ;
+		exit (1) ;
+		} ;
+
+	state = src_delete (state) ;
+
+	puts ("ok") ;
+} /* plan_test */
+
+static void
+sine_test (int converter, int channels, double src_ratio, double freq, double max_error)
+{	SRC_STATE	*state ;
+	double		expected, error, worst = 0.0 ;
+	long		input_frames, output_frames, k, margin ;
+	int			ch, err ;
+
+	printf ("\tsine_test  (%-26s, %d ch, ratio %8.6f) ........ ", src_get_name (converter), channels, src_ratio) ;
+	fflush (stdout) ;
+
+	input_frames = BUFFER_LEN ;
+	for (k = 0 ; k < input_frames ; k++)
+		for (ch = 0 ; ch < channels ; ch++)
+			input [k * channels + ch] = (float) (0.9 * sin (2.0 * M_PI * freq * k + ch)) ;
+
+	if ((state = src_new_multistage (converter, channels, src_ratio, &err)) == NULL)
+	{	printf ("\n\nLine %d : src_new_multistage () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	output_frames = process_blocks (state, input, input_frames, channels, src_ratio, output, BUFFER_LEN) ;
+
+	if (fabs (output_frames - src_ratio * input_frames) > 2)
+	{	printf ("\n\nLine %d : output frames %ld, should be %g +/- 2.\n\n", __LINE__, output_frames, src_ratio * input_frames) ;
+		exit (1) ;
+		} ;
+
+	/* Compare against the ideal output away from the start and end transients. */
+	margin = output_frames / 8 ;
+	for (k = margin ; k < output_frames - margin ; k++)
+		for (ch = 0 ; ch < channels ; ch++)
+		{	expected = 0.9 * sin (2.0 * M_PI * freq * k / src_ratio + ch) ;
+			error = fabs (output [k * channels + ch] - expected) ;
+			worst = MAX (worst, error) ;
+			} ;
+
+	if (worst > SINC_TOLERANCE (converter, max_error))
+	{	printf ("\n\nLine %d : worst error %g, should be < %g.\n\n", __LINE__, worst, SINC_TOLERANCE (converter, max_error)) ;
+		exit (1) ;
+		} ;
+
+	state = src_delete (state) ;
+
+	printf ("ok (%5.1f dB)\n", 20.0 * log10 (worst + 1e-20)) ;
+} /* sine_test */
+
+static void
+clone_test (int converter, double src_ratio)
+{	SRC_STATE	*state, *clone ;
+	SRC_DATA	data ;
+	long		output_frames, cloned_frames ;
+	int			error ;
+
+	printf ("\tclone_test (%-26s, ratio %8.6f) ............. ", src_get_name (converter), src_ratio) ;
+	fflush (stdout) ;
+
+	gen_windowed_sines (1, &src_ratio, 1.0, input, BUFFER_LEN) ;
+
+	if ((state = src_new_multistage (converter, 1, src_ratio, &error)) == NULL)
+	{	printf ("\n\nLine %d : src_new_multistage () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	/* Leave some audio inside the decimators before cloning. */
+	memset (&data, 0, sizeof (data)) ;
+	data.data_in = input ;
+	data.input_frames = BUFFER_LEN / 2 + 17 ;
+	data.data_out = output ;
+	data.output_frames = BUFFER_LEN ;
+	data.src_ratio = src_ratio ;
+
+	if ((error = src_process (state, &data)) != 0)
+	{	printf ("\n\nLine %d : src_process () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	if ((clone = src_clone (state, &error)) == NULL)
+	{	printf ("\n\nLine %d : src_clone () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	output_frames = process_blocks (state, input + data.input_frames_used, BUFFER_LEN - data.input_frames_used, 1, src_ratio, output, BUFFER_LEN) ;
+	cloned_frames = process_blocks (clone, input + data.input_frames_used, BUFFER_LEN - data.input_frames_used, 1, src_ratio, cloned_output, BUFFER_LEN) ;
+
+	if (output_frames != cloned_frames || memcmp (output, cloned_output, output_frames * sizeof (output [0])) != 0)
+	{	printf ("\n\nLine %d : cloned state output differs from the original.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	state = src_delete (state) ;
+	clone = src_delete (clone) ;
+
+	puts ("ok") ;
+} /* clone_test */
+
+static long
+process_blocks (SRC_STATE *state, const float *in, long input_frames, int channels, double src_ratio, float *out, long output_len)
+{	SRC_DATA	data ;
+	long		in_pos = 0, out_pos = 0 ;
+	int			error ;
+
+	memset (&data, 0, sizeof (data)) ;
+	data.src_ratio = src_ratio ;
+
+	do
+	{	data.data_in = in + in_pos * channels ;
+		data.input_frames = MIN (BLOCK_LEN, input_frames - in_pos) ;
+		data.end_of_input = (in_pos + data.input_frames >= input_frames) ;
+		data.data_out = out + out_pos * channels ;
+		data.output_frames = MIN (BLOCK_LEN, output_len - out_pos) ;
+
+		if ((error = src_process (state, &data)) != 0)
+		{	printf ("\n\nLine %d : src_process () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+			exit (1) ;
+			} ;
+
+		in_pos += data.input_frames_used ;
+		out_pos += data.output_frames_gen ;
+		}
+	while (data.end_of_input == 0 || data.output_frames_gen > 0) ;
+
+	return out_pos ;
+} /* process_blocks */
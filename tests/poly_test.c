@@ -0,0 +1,190 @@
+/*
+** Copyright (c) 2002-2016, Erik de Castro Lopo <erikd@mega-nerd.com>
+** All rights reserved.
+**
+** This code is released under 2-clause BSD license. Please see the
+** file at : https://github.com/libsndfile/libsamplerate/blob/master/COPYING
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <samplerate.h>
+
+#include "util.h"
+
+#define	BUFFER_LEN		20000
+
+#ifndef	M_PI
+#define	M_PI			3.14159265358979323846264338
+#endif
+
+static double sine_test (int converter, int channels, double src_ratio, double freq, double max_error) ;
+static void block_test (int converter, int channels, double src_ratio) ;
+
+static float input [BUFFER_LEN * 4] ;
+static float output [BUFFER_LEN * 4 * 3] ;
+static float block_output [BUFFER_LEN * 4 * 3] ;
+
+int
+main (void)
+{	static const struct
+	{	int		converter ;
+		double	max_error [3] ;
+	} tests [] =
+	{	/* The first threshold is relative to the linear interpolator's error. */
+		{	SRC_CUBIC_HERMITE,		{ 0.1, 2e-3, 1e-2 } },
+		{	SRC_LAGRANGE_6POINT,	{ 0.1, 2e-3, 1e-2 } },
+
+		/* Not exact interpolators, these droop a little in the pass band. */
+		{	SRC_OPTIMAL_4POINT,		{ 5.0, 1e-2, 5e-2 } },
+		{	SRC_OPTIMAL_6POINT,		{ 5.0, 1e-2, 5e-2 } }
+		} ;
+	double	linear ;
+	int		k ;
+
+	puts ("") ;
+
+	linear = sine_test (SRC_LINEAR, 1, 1.37, 0.01, 1.0) ;
+
+	for (k = 0 ; k < ARRAY_LEN (tests) ; k++)
+	{	sine_test (tests [k].converter, 1, 1.37, 0.01, tests [k].max_error [0] * linear) ;
+		sine_test (tests [k].converter, 2, 0.73, 0.02, tests [k].max_error [1]) ;
+		sine_test (tests [k].converter, 3, 2.9, 0.05, tests [k].max_error [2]) ;
+		} ;
+
+	puts ("") ;
+
+	for (k = 0 ; k < ARRAY_LEN (tests) ; k++)
+	{	block_test (tests [k].converter, 1, 1.37137) ;
+		block_test (tests [k].converter, 4, 0.31173) ;
+		} ;
+
+	puts ("") ;
+
+	return 0 ;
+} /* main */
+
+static double
+sine_test (int converter, int channels, double src_ratio, double freq, double max_error)
+{	SRC_DATA	data ;
+	double		expected, error, worst = 0.0 ;
+	long		k, margin ;
+	int			ch, err ;
+
+	printf ("\tsine_test  (%-30s, %d ch, ratio %5.3f) ........ ", src_get_name (converter), channels, src_ratio) ;
+	fflush (stdout) ;
+
+	for (k = 0 ; k < BUFFER_LEN ; k++)
+		for (ch = 0 ; ch < channels ; ch++)
+			input [k * channels + ch] = (float) (0.9 * sin (2.0 * M_PI * freq * k + ch)) ;
+
+	memset (&data, 0, sizeof (data)) ;
+	data.data_in = input ;
+	data.input_frames = BUFFER_LEN ;
+	data.data_out = output ;
+	data.output_frames = ARRAY_LEN (output) / channels ;
+	data.src_ratio = src_ratio ;
+
+	if ((err = src_simple (&data, converter, channels)) != 0)
+	{	printf ("\n\nLine %d : src_simple () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	if (fabs (data.output_frames_gen - src_ratio * BUFFER_LEN) > 2 + src_ratio)
+	{	printf ("\n\nLine %d : output frames %ld, should be %g.\n\n", __LINE__, data.output_frames_gen, src_ratio * BUFFER_LEN) ;
+		exit (1) ;
+		} ;
+
+	/* Like the linear converter, output frame k lands on input frame k / src_ratio - 1. */
+	margin = data.output_frames_gen / 8 ;
+	for (k = margin ; k < data.output_frames_gen - margin ; k++)
+		for (ch = 0 ; ch < channels ; ch++)
+		{	expected = 0.9 * sin (2.0 * M_PI * freq * (k / src_ratio - 1.0) + ch) ;
+			error = fabs (output [k * channels + ch] - expected) ;
+			worst = MAX (worst, error) ;
+			} ;
+
+	if (worst > max_error)
+	{	printf ("\n\nLine %d : worst error %g, should be < %g.\n\n", __LINE__, worst, max_error) ;
+		exit (1) ;
+		} ;
+
+	printf ("ok (%6.1f dB)\n", 20.0 * log10 (worst + 1e-20)) ;
+
+	return worst ;
+} /* sine_test */
+
+/*
+** Splitting the input and output into odd sized blocks must not change the
+** output.
+*/
+static void
+block_test (int converter, int channels, double src_ratio)
+{	static const int block_lens [] = { 1, 2, 3, 17, 1, 500, 5, 4 } ;
+	static const double freq = 0.0731 ;
+
+	SRC_STATE	*state ;
+	SRC_DATA	data ;
+	long		in_pos = 0, out_pos = 0, whole_frames ;
+	int			k = 0, err ;
+
+	printf ("\tblock_test (%-30s, %d ch, ratio %5.3f) ........ ", src_get_name (converter), channels, src_ratio) ;
+	fflush (stdout) ;
+
+	gen_windowed_sines (1, &freq, 0.9, input, BUFFER_LEN * channels) ;
+
+	memset (&data, 0, sizeof (data)) ;
+	data.data_in = input ;
+	data.input_frames = BUFFER_LEN ;
+	data.data_out = output ;
+	data.output_frames = ARRAY_LEN (output) / channels ;
+	data.src_ratio = src_ratio ;
+
+	if ((err = src_simple (&data, converter, channels)) != 0)
+	{	printf ("\n\nLine %d : src_simple () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+	whole_frames = data.output_frames_gen ;
+
+	if ((state = src_new (converter, channels, &err)) == NULL)
+	{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	do
+	{	data.data_in = input + in_pos * channels ;
+		data.input_frames = block_lens [k++ % ARRAY_LEN (block_lens)] ;
+		data.input_frames = MIN (data.input_frames, BUFFER_LEN - in_pos) ;
+		data.end_of_input = (in_pos + data.input_frames >= BUFFER_LEN) ;
+		data.data_out = block_output + out_pos * channels ;
+		data.output_frames = block_lens [k % ARRAY_LEN (block_lens)] ;
+
+		if ((err = src_process (state, &data)) != 0)
+		{	printf ("\n\nLine %d : src_process () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+			exit (1) ;
+			} ;
+
+		in_pos += data.input_frames_used ;
+		out_pos += data.output_frames_gen ;
+		}
+	while (data.end_of_input == 0 || data.output_frames_gen > 0) ;
+
+	state = src_delete (state) ;
+
+	/* Position round off can differ by a hair, so allow the odd extra frame at the end. */
+	if (labs (out_pos - whole_frames) > 1)
+	{	printf ("\n\nLine %d : block output %ld frames, single call output %ld frames.\n\n", __LINE__, out_pos, whole_frames) ;
+		exit (1) ;
+		} ;
+
+	for (k = 0 ; k < MIN (out_pos, whole_frames) * channels ; k++)
+		if (fabs (output [k] - block_output [k]) > 1e-5)
+		{	printf ("\n\nLine %d : block output differs from single call output at sample %d.\n\n", __LINE__, k) ;
+			exit (1) ;
+			} ;
+
+	puts ("ok") ;
+} /* block_test */
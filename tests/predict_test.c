@@ -0,0 +1,214 @@
+/*
+** Copyright (c) 2002-2016, Erik de Castro Lopo <erikd@mega-nerd.com>
+** All rights reserved.
+**
+** This code is released under 2-clause BSD license. Please see the
+** file at : https://github.com/libsndfile/libsamplerate/blob/master/COPYING
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <samplerate.h>
+
+#include "util.h"
+
+#define	BUFFER_LEN		(1 << 17)
+#define	MAX_BLOCK		3000
+#define	MAX_CHANNELS	3
+
+static void predict_test (SRC_STATE *state, const char *name, int channels, double src_ratio) ;
+static void bad_args_test (void) ;
+
+static float input [BUFFER_LEN * MAX_CHANNELS] ;
+static float output [MAX_BLOCK * 8 * MAX_CHANNELS] ;
+
+int
+main (void)
+{	static const int converters [] =
+	{	SRC_ZERO_ORDER_HOLD, SRC_LINEAR, SRC_CUBIC_HERMITE, SRC_OPTIMAL_6POINT,
+		SRC_SINC_FASTEST, SRC_SINC_MEDIUM_QUALITY
+		} ;
+	static const double ratios [] = { 0.37, 1.0, 2.3 } ;
+	SRC_STATE	*state ;
+	int			k, r, channels, error ;
+
+	puts ("") ;
+
+	bad_args_test () ;
+
+	for (k = 0 ; k < ARRAY_LEN (converters) ; k++)
+		for (r = 0 ; r < ARRAY_LEN (ratios) ; r++)
+		{	channels = 1 + (k + r) % MAX_CHANNELS ;
+
+			if ((state = src_new (converters [k], channels, &error)) == NULL)
+			{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+				exit (1) ;
+				} ;
+
+			predict_test (state, src_get_name (converters [k]), channels, ratios [r]) ;
+			state = src_delete (state) ;
+			} ;
+
+	/* The FFT converter only takes ratios L / M with small L. */
+	for (r = 0 ; r < 2 ; r++)
+	{	if ((state = src_new (SRC_SINC_BEST_QUALITY_FFT, r + 1, &error)) == NULL)
+		{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+			exit (1) ;
+			} ;
+
+		predict_test (state, src_get_name (SRC_SINC_BEST_QUALITY_FFT), r + 1, r == 0 ? 2.0 / 3.0 : 1.5) ;
+		state = src_delete (state) ;
+		} ;
+
+	if ((state = src_new_rational (SRC_SINC_FASTEST, 2, 48000, 44100, &error)) == NULL)
+	{	printf ("\n\nLine %d : src_new_rational () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	predict_test (state, "Rational sinc", 2, 48000.0 / 44100.0) ;
+	state = src_delete (state) ;
+
+	if ((state = src_new_multistage (SRC_SINC_FASTEST, 1, 0.1, &error)) == NULL)
+	{	printf ("\n\nLine %d : src_new_multistage () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	predict_test (state, "Multi-stage", 1, 0.1) ;
+	state = src_delete (state) ;
+
+	puts ("") ;
+
+	return 0 ;
+} /* main */
+
+/*
+** Stream blocks of all sizes, alternately asking how much output a block
+** gives and how much input fills a block, and check src_process () agrees.
+*/
+static void
+predict_test (SRC_STATE *state, const char *name, int channels, double src_ratio)
+{	SRC_STATE	*clone ;
+	SRC_DATA	data ;
+	long		k, in_pos = 0, len, predicted, seed = 1 ;
+	int			error ;
+
+	printf ("\tpredict_test (%-30s, %d ch, ratio %5.3f) ...... ", name, channels, src_ratio) ;
+	fflush (stdout) ;
+
+	for (k = 0 ; k < BUFFER_LEN * channels ; k++)
+		input [k] = (float) (0.5 * sin (0.01 * k)) ;
+
+	memset (&data, 0, sizeof (data)) ;
+	data.src_ratio = src_ratio ;
+	data.data_out = output ;
+
+	for (k = 0 ; ; k++)
+	{	seed = (seed * 1103515245 + 12345) & 0x7fffffff ;
+		len = seed % MAX_BLOCK ;
+
+		data.data_in = input + in_pos * channels ;
+
+		if (k % 2 == 0)
+		{	/* Output for a given input, with more than enough room. */
+			if (in_pos + len > BUFFER_LEN)
+				break ;
+
+			if ((predicted = src_get_output_frames (state, src_ratio, len)) < 0)
+			{	printf ("\n\nLine %d : src_get_output_frames () failed : %s\n\n", __LINE__, src_strerror (-predicted)) ;
+				exit (1) ;
+				} ;
+
+			data.input_frames = len ;
+			data.output_frames = ARRAY_LEN (output) / channels ;
+			}
+		else
+		{	/* Input to fill a given output, and one frame less must not. */
+			len = MAX (len * MIN (src_ratio, 1.0), 1) ;
+
+			if ((predicted = src_get_input_frames_needed (state, src_ratio, len)) < 0)
+			{	printf ("\n\nLine %d : src_get_input_frames_needed () failed : %s\n\n", __LINE__, src_strerror (-predicted)) ;
+				exit (1) ;
+				} ;
+
+			if (in_pos + predicted > BUFFER_LEN)
+				break ;
+
+			data.output_frames = len ;
+
+			if (predicted > 0)
+			{	if ((clone = src_clone (state, &error)) == NULL)
+				{	printf ("\n\nLine %d : src_clone () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+					exit (1) ;
+					} ;
+
+				data.input_frames = predicted - 1 ;
+				if ((error = src_process (clone, &data)) != 0)
+				{	printf ("\n\nLine %d : src_process () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+					exit (1) ;
+					} ;
+
+				if (data.output_frames_gen >= len)
+				{	printf ("\n\nLine %d : block %ld : %ld input frames were enough for %ld output frames, not %ld.\n\n",
+							__LINE__, k, predicted - 1, len, predicted) ;
+					exit (1) ;
+					} ;
+
+				clone = src_delete (clone) ;
+				} ;
+
+			data.input_frames = predicted ;
+			predicted = len ;
+			} ;
+
+		if ((error = src_process (state, &data)) != 0)
+		{	printf ("\n\nLine %d : src_process () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+			exit (1) ;
+			} ;
+
+		if (data.output_frames_gen != predicted)
+		{	printf ("\n\nLine %d : block %ld : %ld input frames gave %ld output frames, predicted %ld.\n\n",
+					__LINE__, k, data.input_frames, data.output_frames_gen, predicted) ;
+			exit (1) ;
+			} ;
+
+		in_pos += data.input_frames_used ;
+		} ;
+
+	printf ("ok (%ld blocks)\n", k) ;
+} /* predict_test */
+
+static void
+bad_args_test (void)
+{	SRC_STATE	*state ;
+	int			error ;
+
+	printf ("\tbad_args_test .................................................... ") ;
+	fflush (stdout) ;
+
+	if (src_get_output_frames (NULL, 1.0, 100) >= 0)
+	{	printf ("\n\nLine %d : src_get_output_frames () should fail for a NULL state.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	if ((state = src_new (SRC_LINEAR, 1, &error)) == NULL)
+	{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	if (src_get_output_frames (state, 1000.0, 100) >= 0)
+	{	printf ("\n\nLine %d : src_get_output_frames () should fail for a bad ratio.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	if (src_get_input_frames_needed (state, 1.0, -1) >= 0)
+	{	printf ("\n\nLine %d : src_get_input_frames_needed () should fail for a negative count.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	state = src_delete (state) ;
+
+	puts ("ok") ;
+} /* bad_args_test */
@@ -0,0 +1,202 @@
+/*
+** Copyright (c) 2002-2016, Erik de Castro Lopo <erikd@mega-nerd.com>
+** All rights reserved.
+**
+** This code is released under 2-clause BSD license. Please see the
+** file at : https://github.com/libsndfile/libsamplerate/blob/master/COPYING
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <samplerate.h>
+
+#include "util.h"
+
+#define	BUFFER_LEN		(1 << 17)
+#define	PERIOD			256
+#define	PERIODS			250
+#define	MAX_CHANNELS	6
+
+static void pull_test (SRC_STATE *state, const char *name, int channels, double base_ratio, double swing) ;
+static void step_test (void) ;
+
+static float input [BUFFER_LEN * MAX_CHANNELS] ;
+static float output [PERIOD * MAX_CHANNELS] ;
+
+int
+main (void)
+{	static const int converters [] =
+	{	SRC_ZERO_ORDER_HOLD, SRC_LINEAR, SRC_CUBIC_HERMITE, SRC_LAGRANGE_6POINT,
+		SRC_SINC_FASTEST, SRC_SINC_MEDIUM_QUALITY
+		} ;
+	static const int channel_counts [] = { 1, 2, 6 } ;
+	SRC_STATE	*state ;
+	int			k, c, error ;
+
+	puts ("") ;
+
+	for (k = 0 ; k < ARRAY_LEN (converters) ; k++)
+		for (c = 0 ; c < ARRAY_LEN (channel_counts) ; c++)
+		{	if ((state = src_new (converters [k], channel_counts [c], &error)) == NULL)
+			{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+				exit (1) ;
+				} ;
+
+			pull_test (state, src_get_name (converters [k]), channel_counts [c], 0.9 + 0.2 * c, 0.3) ;
+			state = src_delete (state) ;
+			} ;
+
+	/* Converters that can only predict by a trial run have no pull mode. */
+	if ((state = src_new (SRC_SINC_BEST_QUALITY_FFT, 2, &error)) == NULL)
+	{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	printf ("\tpull_test (%-30s, 2 ch) ................... ", src_get_name (SRC_SINC_BEST_QUALITY_FFT)) ;
+	if (src_pull_input_frames (state, 2.0 / 3.0, PERIOD) >= 0)
+	{	printf ("\n\nLine %d : src_pull_input_frames () should have failed.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+	puts ("ok") ;
+	state = src_delete (state) ;
+
+	if ((state = src_new_rational (SRC_SINC_FASTEST, 1, 48000, 44100, &error)) == NULL)
+	{	printf ("\n\nLine %d : src_new_rational () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	pull_test (state, "Rational sinc", 1, 48000.0 / 44100.0, 0.0) ;
+	state = src_delete (state) ;
+
+	step_test () ;
+
+	puts ("") ;
+
+	return 0 ;
+} /* main */
+
+/*
+** Pull one device period at a time while sweeping the ratio, taking exactly
+** the input asked for. Every period must come out full. Now and then another
+** thread posts a ratio between the pull and the process call, which must not
+** throw the count out.
+*/
+static void
+pull_test (SRC_STATE *state, const char *name, int channels, double base_ratio, double swing)
+{	SRC_DATA	data ;
+	double		ratio ;
+	long		k, in_pos = 0, needed ;
+	int			error ;
+
+	printf ("\tpull_test (%-30s, %d ch, ratio %5.3f) ...... ", name, channels, base_ratio) ;
+	fflush (stdout) ;
+
+	for (k = 0 ; k < BUFFER_LEN * channels ; k++)
+		input [k] = (float) (0.5 * sin (0.01 * k)) ;
+
+	memset (&data, 0, sizeof (data)) ;
+	data.data_out = output ;
+	data.output_frames = PERIOD ;
+
+	for (k = 0 ; k < PERIODS ; k++)
+	{	ratio = base_ratio * (1.0 + swing * sin (0.07 * k)) ;
+
+		if (swing > 0.0 && k % 7 == 3)
+			src_set_target_ratio (state, base_ratio * (1.0 + swing)) ;
+
+		if ((needed = src_pull_input_frames (state, ratio, PERIOD)) < 0)
+		{	printf ("\n\nLine %d : src_pull_input_frames () failed : %s\n\n", __LINE__, src_strerror (-needed)) ;
+			exit (1) ;
+			} ;
+
+		if (in_pos + needed > BUFFER_LEN)
+		{	printf ("\n\nLine %d : period %ld : asked for %ld input frames.\n\n", __LINE__, k, needed) ;
+			exit (1) ;
+			} ;
+
+		/* A ratio posted now is too late for this period. */
+		if (swing > 0.0)
+			src_set_target_ratio (state, k % 7 == 3 ? 0.0 : base_ratio * (1.0 - swing)) ;
+
+		data.data_in = input + in_pos * channels ;
+		data.input_frames = needed ;
+		data.src_ratio = ratio ;
+
+		if ((error = src_process (state, &data)) != 0)
+		{	printf ("\n\nLine %d : src_process () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+			exit (1) ;
+			} ;
+
+		if (data.output_frames_gen != PERIOD)
+		{	printf ("\n\nLine %d : period %ld : %ld input frames gave %ld output frames, not %d.\n\n",
+					__LINE__, k, needed, data.output_frames_gen, PERIOD) ;
+			exit (1) ;
+			} ;
+
+		if (needed - data.input_frames_used > 8)
+		{	printf ("\n\nLine %d : period %ld : only %ld of %ld input frames used.\n\n",
+					__LINE__, k, data.input_frames_used, needed) ;
+			exit (1) ;
+			} ;
+
+		src_set_target_ratio (state, 0.0) ;
+		in_pos += data.input_frames_used ;
+		} ;
+
+	printf ("ok\n") ;
+} /* pull_test */
+
+/*
+** A ratio step after the pull drops the ratio the pull held, so the next call
+** runs at the stepped ratio and not the pulled one.
+*/
+static void
+step_test (void)
+{	SRC_STATE	*state ;
+	SRC_DATA	data ;
+	long		needed ;
+	int			error ;
+
+	printf ("\tstep_test ............................................................ ") ;
+	fflush (stdout) ;
+
+	if ((state = src_new (SRC_LINEAR, 1, &error)) == NULL)
+	{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	if ((needed = src_pull_input_frames (state, 2.0, PERIOD)) < 0)
+	{	printf ("\n\nLine %d : src_pull_input_frames () failed : %s\n\n", __LINE__, src_strerror (-needed)) ;
+		exit (1) ;
+		} ;
+
+	if ((error = src_set_ratio (state, 0.5)) != 0)
+	{	printf ("\n\nLine %d : src_set_ratio () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	memset (&data, 0, sizeof (data)) ;
+	data.data_in = input ;
+	data.input_frames = 4 * PERIOD ;
+	data.data_out = output ;
+	data.output_frames = ARRAY_LEN (output) ;
+	data.src_ratio = 0.5 ;
+
+	if ((error = src_process (state, &data)) != 0)
+	{	printf ("\n\nLine %d : src_process () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	if (data.input_frames_used != 4 * PERIOD || data.output_frames_gen > 2 * PERIOD + 2)
+	{	printf ("\n\nLine %d : %ld input frames gave %ld output frames at ratio 0.5.\n\n",
+				__LINE__, data.input_frames_used, data.output_frames_gen) ;
+		exit (1) ;
+		} ;
+
+	state = src_delete (state) ;
+
+	puts ("ok") ;
+} /* step_test */
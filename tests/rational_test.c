@@ -0,0 +1,187 @@
+/*
+** Copyright (c) 2002-2016, Erik de Castro Lopo <erikd@mega-nerd.com>
+** All rights reserved.
+**
+** This code is released under 2-clause BSD license. Please see the
+** file at : https://github.com/libsndfile/libsamplerate/blob/master/COPYING
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <samplerate.h>
+
+#include "util.h"
+
+#define	BUFFER_LEN		(1 << 16)
+
+#ifndef	M_PI
+#define	M_PI			3.14159265358979323846264338
+#endif
+
+static void bad_args_test (void) ;
+static void count_test (int converter, int channels, int num, int den, long input_frames) ;
+static void sine_test (int converter, int channels, int num, int den, double freq, double max_error) ;
+
+static float input [BUFFER_LEN * 6] ;
+static float output [BUFFER_LEN * 6 * 4] ;
+
+int
+main (void)
+{
+	puts ("") ;
+
+	bad_args_test () ;
+
+	count_test (SRC_SINC_FASTEST, 1, 160, 147, 3000017) ;
+	count_test (SRC_SINC_FASTEST, 2, 147, 160, 3000017) ;
+	count_test (SRC_SINC_FASTEST, 3, 1, 3, 1000003) ;
+	count_test (SRC_SINC_FASTEST, 6, 3, 1, 100003) ;
+	count_test (SRC_SINC_MEDIUM_QUALITY, 2, 96000, 44100, 400009) ;
+
+	sine_test (SRC_SINC_FASTEST, 1, 160, 147, 0.01, 1e-4) ;
+	sine_test (SRC_SINC_MEDIUM_QUALITY, 2, 147, 160, 0.02, 1e-5) ;
+	sine_test (SRC_SINC_MEDIUM_QUALITY, 4, 2, 7, 0.05, 1e-5) ;
+
+	puts ("") ;
+
+	return 0 ;
+} /* main */
+
+static void
+bad_args_test (void)
+{	SRC_STATE	*state ;
+	int			error ;
+
+	printf ("\tbad_args_test ................................................ ") ;
+	fflush (stdout) ;
+
+	if ((state = src_new_rational (SRC_SINC_FASTEST, 1, 0, 1, &error)) != NULL || error == 0)
+	{	printf ("\n\nLine %d : src_new_rational () should fail for num == 0.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	if ((state = src_new_rational (SRC_SINC_FASTEST, 1, 1, 257, &error)) != NULL || error == 0)
+	{	printf ("\n\nLine %d : src_new_rational () should fail for a ratio of 1/257.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	if ((state = src_new_rational (SRC_LINEAR, 1, 2, 1, &error)) != NULL || error == 0)
+	{	printf ("\n\nLine %d : src_new_rational () should fail for SRC_LINEAR.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	puts ("ok") ;
+} /* bad_args_test */
+
+/*
+** Feed blocks of awkward and varying length, with a limited output buffer,
+** and check that the total output is exactly floor (input_frames * num / den).
+*/
+static void
+count_test (int converter, int channels, int num, int den, long input_frames)
+{	static const int block_lens [] = { 1, 997, 4096, 10, 333, 65536, 2 } ;
+
+	SRC_STATE	*state ;
+	SRC_DATA	data ;
+	long		in_pos = 0, out_total = 0, expected, block ;
+	int			error, k = 0 ;
+
+	printf ("\tcount_test (%d ch, %6d / %-6d, %7ld frames) ................ ", channels, num, den, input_frames) ;
+	fflush (stdout) ;
+
+	if ((state = src_new_rational (converter, channels, num, den, &error)) == NULL)
+	{	printf ("\n\nLine %d : src_new_rational () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+		exit (1) ;
+		} ;
+
+	memset (input, 0, sizeof (input)) ;
+	memset (&data, 0, sizeof (data)) ;
+	data.src_ratio = (1.0 * num) / den ;
+	data.data_in = input ;
+	data.data_out = output ;
+
+	do
+	{	block = block_lens [k++ % ARRAY_LEN (block_lens)] ;
+		block = MIN (block, input_frames - in_pos) ;
+
+		data.input_frames = block ;
+		data.end_of_input = (in_pos + block >= input_frames) ;
+		data.output_frames = MIN (BUFFER_LEN, 1 + 3 * k) ;
+
+		if ((error = src_process (state, &data)) != 0)
+		{	printf ("\n\nLine %d : src_process () failed : %s\n\n", __LINE__, src_strerror (error)) ;
+			exit (1) ;
+			} ;
+
+		in_pos += data.input_frames_used ;
+		out_total += data.output_frames_gen ;
+		}
+	while (data.end_of_input == 0 || data.output_frames_gen > 0) ;
+
+	state = src_delete (state) ;
+
+	expected = (long) ((input_frames * (long long) num) / den) ;
+	if (in_pos != input_frames || out_total != expected)
+	{	printf ("\n\nLine %d : used %ld of %ld input frames, gave %ld output frames, expected %ld.\n\n",
+				__LINE__, in_pos, input_frames, out_total, expected) ;
+		exit (1) ;
+		} ;
+
+	puts ("ok") ;
+} /* count_test */
+
+static void
+sine_test (int converter, int channels, int num, int den, double freq, double max_error)
+{	SRC_STATE	*state ;
+	SRC_DATA	data ;
+	double		src_ratio, expected, error, worst = 0.0 ;
+	long		k, margin ;
+	int			ch, err ;
+
+	printf ("\tsine_test  (%d ch, %6d / %-6d, %-26s) ....... ", channels, num, den, src_get_name (converter)) ;
+	fflush (stdout) ;
+
+	src_ratio = (1.0 * num) / den ;
+
+	for (k = 0 ; k < BUFFER_LEN ; k++)
+		for (ch = 0 ; ch < channels ; ch++)
+			input [k * channels + ch] = (float) (0.9 * sin (2.0 * M_PI * freq * k + ch)) ;
+
+	if ((state = src_new_rational (converter, channels, num, den, &err)) == NULL)
+	{	printf ("\n\nLine %d : src_new_rational () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	memset (&data, 0, sizeof (data)) ;
+	data.data_in = input ;
+	data.input_frames = BUFFER_LEN ;
+	data.data_out = output ;
+	data.output_frames = ARRAY_LEN (output) / channels ;
+	data.src_ratio = src_ratio ;
+	data.end_of_input = 1 ;
+
+	if ((err = src_process (state, &data)) != 0)
+	{	printf ("\n\nLine %d : src_process () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	state = src_delete (state) ;
+
+	margin = data.output_frames_gen / 8 ;
+	for (k = margin ; k < data.output_frames_gen - margin ; k++)
+		for (ch = 0 ; ch < channels ; ch++)
+		{	expected = 0.9 * sin (2.0 * M_PI * freq * k / src_ratio + ch) ;
+			error = fabs (output [k * channels + ch] - expected) ;
+			worst = MAX (worst, error) ;
+			} ;
+
+	if (worst > SINC_TOLERANCE (converter, max_error))
+	{	printf ("\n\nLine %d : worst error %g, should be < %g.\n\n", __LINE__, worst, SINC_TOLERANCE (converter, max_error)) ;
+		exit (1) ;
+		} ;
+
+	printf ("ok (%5.1f dB)\n", 20.0 * log10 (worst + 1e-20)) ;
+} /* sine_test */
@@ -29,10 +29,14 @@ main (void)
 
 	process_reset_test (SRC_ZERO_ORDER_HOLD) ;
 	process_reset_test (SRC_LINEAR) ;
+	process_reset_test (SRC_CUBIC_HERMITE) ;
+	process_reset_test (SRC_LAGRANGE_6POINT) ;
 	process_reset_test (SRC_SINC_FASTEST) ;
 
 	callback_reset_test (SRC_ZERO_ORDER_HOLD) ;
 	callback_reset_test (SRC_LINEAR) ;
+	callback_reset_test (SRC_CUBIC_HERMITE) ;
+	callback_reset_test (SRC_LAGRANGE_6POINT) ;
 	callback_reset_test (SRC_SINC_FASTEST) ;
 
 	puts ("") ;
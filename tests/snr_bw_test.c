@@ -134,6 +134,19 @@ main (int argc, char *argv [])
 				{	1,	{ 0.43111111111 },		1.33,		1,	145.0,	1.0 }
 				}
 			},
+
+		/* Only ratios L/M with L <= 16, and no bandwidth test as that runs at 1.999. */
+		{	SRC_SINC_BEST_QUALITY_FFT,
+			6,
+			BOOLEAN_FALSE,
+			{	{	1,	{ 0.01111111111 },		3.0,		1,	147.0,	1.0 },
+				{	1,	{ 0.01111111111 },		0.6,		1,	147.0,	1.0 },
+				{	1,	{ 0.01111111111 },		0.3,		1,	148.0,	1.0 },
+				{	1,	{ 0.01111111111 },		1.0,		1,	155.0,	1.0 },
+				{	2,	{ 0.011111, 0.45 },		0.6,		1,	144.0,	0.5 },
+				{	1,	{ 0.43111111111 },		1.375,		1,	145.0,	1.0 }
+				}
+			},
 		} ; /* snr_test_data */
 
 	double	best_snr, snr, freq3dB ;
@@ -186,9 +199,14 @@ snr_test (SINGLE_TEST *test_data, int number, int converter, int verbose)
 	SRC_STATE	*src_state ;
 	SRC_DATA	src_data ;
 
-	double		output_peak, snr ;
+	double		output_peak, snr, min_snr ;
 	int 		k, output_len, input_len, error ;
 
+	min_snr = test_data->snr ;
+#if (ENABLE_HALF_COEFFS)
+	min_snr = MIN (min_snr, half_coeff_snr (converter)) ;
+#endif
+
 	if (verbose != 0)
 	{	printf ("\tSignal-to-Noise Ratio Test %d.\n"
 				"\t=====================================\n", number) ;
@@ -279,8 +297,8 @@ snr_test (SINGLE_TEST *test_data, int number, int converter, int verbose)
 	if (verbose != 0)
 		printf ("\tSNR Ratio   :   %.2f dB\n", snr) ;
 
-	if (snr < test_data->snr)
-	{	printf ("\n\nLine %d : SNR (%5.2f) should be > %6.2f dB\n\n", __LINE__, snr, test_data->snr) ;
+	if (snr < min_snr)
+	{	printf ("\n\nLine %d : SNR (%5.2f) should be > %6.2f dB\n\n", __LINE__, snr, min_snr) ;
 		exit (1) ;
 		} ;
 
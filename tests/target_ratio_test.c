@@ -0,0 +1,236 @@
+/*
+** Copyright (c) 2002-2016, Erik de Castro Lopo <erikd@mega-nerd.com>
+** All rights reserved.
+**
+** This code is released under 2-clause BSD license. Please see the
+** file at : https://github.com/libsndfile/libsamplerate/blob/master/COPYING
+*/
+
+#include "src_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include <samplerate.h>
+
+#include "util.h"
+
+#define	BUFFER_LEN		8192
+#define	BLOCK_LEN		256
+#define	BLOCK_COUNT		(BUFFER_LEN / BLOCK_LEN)
+
+static void follow_test (int converter) ;
+static void thread_test (int converter) ;
+static void bad_args_test (void) ;
+
+static float input [BUFFER_LEN] ;
+static float caller_output [BUFFER_LEN * 3] ;
+static float target_output [BUFFER_LEN * 3] ;
+
+int
+main (void)
+{	static const double freq = 0.0337 ;
+
+	puts ("") ;
+
+	gen_windowed_sines (1, &freq, 0.9, input, BUFFER_LEN) ;
+
+	bad_args_test () ;
+
+	follow_test (SRC_LINEAR) ;
+	follow_test (SRC_CUBIC_HERMITE) ;
+	follow_test (SRC_SINC_FASTEST) ;
+
+	thread_test (SRC_SINC_FASTEST) ;
+
+	puts ("") ;
+
+	return 0 ;
+} /* main */
+
+/*
+** Ratio changes made with src_set_target_ratio () must come out exactly as
+** if the caller had changed src_ratio at the same block.
+*/
+static void
+follow_test (int converter)
+{	static const double ratios [] = { 1.0, 1.5, 0.7, 1.0 } ;
+
+	SRC_STATE	*caller_state, *target_state ;
+	SRC_DATA	caller_data, target_data ;
+	long		caller_pos = 0, target_pos = 0, k ;
+	int			block, stage, err ;
+
+	printf ("\tfollow_test (%-28s) ................ ", src_get_name (converter)) ;
+	fflush (stdout) ;
+
+	if ((caller_state = src_new (converter, 1, &err)) == NULL || (target_state = src_new (converter, 1, &err)) == NULL)
+	{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	memset (&caller_data, 0, sizeof (caller_data)) ;
+	memset (&target_data, 0, sizeof (target_data)) ;
+
+	for (block = 0 ; block < BLOCK_COUNT ; block++)
+	{	stage = block * ARRAY_LEN (ratios) / BLOCK_COUNT ;
+
+		caller_data.src_ratio = ratios [stage] ;
+
+		/* The last stage hands control back to the caller. */
+		target_data.src_ratio = ratios [0] ;
+		if (block * ARRAY_LEN (ratios) % BLOCK_COUNT == 0)
+			src_set_target_ratio (target_state, stage == ARRAY_LEN (ratios) - 1 ? 0.0 : ratios [stage]) ;
+
+		caller_data.data_in = target_data.data_in = input + block * BLOCK_LEN ;
+		caller_data.input_frames = target_data.input_frames = BLOCK_LEN ;
+		caller_data.end_of_input = target_data.end_of_input = (block == BLOCK_COUNT - 1) ;
+
+		caller_data.data_out = caller_output + caller_pos ;
+		caller_data.output_frames = ARRAY_LEN (caller_output) - caller_pos ;
+		target_data.data_out = target_output + target_pos ;
+		target_data.output_frames = ARRAY_LEN (target_output) - target_pos ;
+
+		if ((err = src_process (caller_state, &caller_data)) != 0 || (err = src_process (target_state, &target_data)) != 0)
+		{	printf ("\n\nLine %d : src_process () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+			exit (1) ;
+			} ;
+
+		/* The caller's src_ratio is left alone. */
+		if (target_data.src_ratio != ratios [0])
+		{	printf ("\n\nLine %d : src_ratio changed to %g.\n\n", __LINE__, target_data.src_ratio) ;
+			exit (1) ;
+			} ;
+
+		caller_pos += caller_data.output_frames_gen ;
+		target_pos += target_data.output_frames_gen ;
+		} ;
+
+	caller_state = src_delete (caller_state) ;
+	target_state = src_delete (target_state) ;
+
+	if (caller_pos != target_pos)
+	{	printf ("\n\nLine %d : %ld output frames, should be %ld.\n\n", __LINE__, target_pos, caller_pos) ;
+		exit (1) ;
+		} ;
+
+	for (k = 0 ; k < caller_pos ; k++)
+		if (caller_output [k] != target_output [k])
+		{	printf ("\n\nLine %d : outputs differ at frame %ld.\n\n", __LINE__, k) ;
+			exit (1) ;
+			} ;
+
+	puts ("ok") ;
+} /* follow_test */
+
+#if HAVE_PTHREAD
+
+#define	RATIO_CHANGES	200000
+
+static void *
+ratio_thread (void *arg)
+{	SRC_STATE *state = (SRC_STATE*) arg ;
+	long k ;
+
+	for (k = 0 ; k < RATIO_CHANGES ; k++)
+		src_set_target_ratio (state, 0.5 + (k % 100) / 66.0) ;
+
+	return NULL ;
+} /* ratio_thread */
+
+/*
+** Hammer the target ratio from another thread while the converter runs.
+** Every block must come out at a ratio somewhere in the range being set.
+*/
+static void
+thread_test (int converter)
+{	SRC_STATE	*state ;
+	SRC_DATA	data ;
+	pthread_t	thread ;
+	long		k ;
+	int			pass, err ;
+
+	printf ("\tthread_test (%-28s) ................ ", src_get_name (converter)) ;
+	fflush (stdout) ;
+
+	if ((state = src_new (converter, 1, &err)) == NULL)
+	{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	if (pthread_create (&thread, NULL, ratio_thread, state) != 0)
+	{	printf ("\n\nLine %d : pthread_create () failed.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	memset (&data, 0, sizeof (data)) ;
+	data.src_ratio = 1.0 ;
+
+	for (pass = 0 ; pass < 20 ; pass++)
+		for (k = 0 ; k < BLOCK_COUNT ; k++)
+		{	data.data_in = input + k * BLOCK_LEN ;
+			data.input_frames = BLOCK_LEN ;
+			data.data_out = target_output ;
+			data.output_frames = ARRAY_LEN (target_output) ;
+
+			if ((err = src_process (state, &data)) != 0)
+			{	printf ("\n\nLine %d : src_process () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+				exit (1) ;
+				} ;
+
+			if (data.src_ratio < 0.5 || data.src_ratio > 2.0 || data.output_frames_gen > 2.0 * BLOCK_LEN + 64)
+			{	printf ("\n\nLine %d : ratio %g gave %ld output frames.\n\n", __LINE__, data.src_ratio, data.output_frames_gen) ;
+				exit (1) ;
+				} ;
+			} ;
+
+	pthread_join (thread, NULL) ;
+
+	state = src_delete (state) ;
+
+	puts ("ok") ;
+} /* thread_test */
+
+#else
+
+static void
+thread_test (int converter)
+{	(void) converter ;
+	puts ("\tthread_test : no threads on this platform.") ;
+} /* thread_test */
+
+#endif
+
+static void
+bad_args_test (void)
+{	SRC_STATE	*state ;
+	int			err ;
+
+	printf ("\tbad_args_test ........................................................... ") ;
+	fflush (stdout) ;
+
+	if (src_set_target_ratio (NULL, 1.0) == 0)
+	{	printf ("\n\nLine %d : src_set_target_ratio () should fail for a NULL state.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	if ((state = src_new (SRC_LINEAR, 1, &err)) == NULL)
+	{	printf ("\n\nLine %d : src_new () failed : %s\n\n", __LINE__, src_strerror (err)) ;
+		exit (1) ;
+		} ;
+
+	if (src_set_target_ratio (state, 1000.0) == 0 || src_set_target_ratio (state, -1.0) == 0)
+	{	printf ("\n\nLine %d : src_set_target_ratio () should fail for a bad ratio.\n\n", __LINE__) ;
+		exit (1) ;
+		} ;
+
+	state = src_delete (state) ;
+
+	puts ("ok") ;
+} /* bad_args_test */
@@ -49,6 +49,22 @@ main (void)
 		stream_test (SRC_LINEAR, src_ratios [k]) ;
 
 
+	puts ("\n    Cubic Hermite interpolator:") ;
+	for (k = 0 ; k < ARRAY_LEN (src_ratios) ; k++)
+		init_term_test (SRC_CUBIC_HERMITE, src_ratios [k]) ;
+	puts ("") ;
+	for (k = 0 ; k < ARRAY_LEN (src_ratios) ; k++)
+		stream_test (SRC_CUBIC_HERMITE, src_ratios [k]) ;
+
+
+	puts ("\n    Optimal 6-point interpolator:") ;
+	for (k = 0 ; k < ARRAY_LEN (src_ratios) ; k++)
+		init_term_test (SRC_OPTIMAL_6POINT, src_ratios [k]) ;
+	puts ("") ;
+	for (k = 0 ; k < ARRAY_LEN (src_ratios) ; k++)
+		stream_test (SRC_OPTIMAL_6POINT, src_ratios [k]) ;
+
+
 	puts ("\n    Sinc interpolator:") ;
 	for (k = 0 ; k < ARRAY_LEN (src_ratios) ; k++)
 		init_term_test (SRC_SINC_FASTEST, src_ratios [k]) ;
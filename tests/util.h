@@ -20,6 +20,20 @@
 
 #define	ARRAY_LEN(x)	((int) (sizeof (x) / sizeof ((x) [0])))
 
+/*
+** Sinc filters stored in half precision put a floor under the error of each
+** sinc converter. SINC_TOLERANCE () raises a converter's error bound x to its
+** floor from half_coeff_error (), and leaves every other bound alone.
+*/
+#if (ENABLE_HALF_COEFFS)
+#define	SINC_TOLERANCE(converter, x)	MAX ((x), half_coeff_error (converter))
+#else
+#define	SINC_TOLERANCE(converter, x)	(x)
+#endif
+
+double half_coeff_error (int converter) ;
+double half_coeff_snr (int converter) ;
+
 void gen_windowed_sines (int freq_count, const double *freqs, double max, float *output, int output_len) ;
 
 void save_oct_float (char *filename, float *input, int in_len, float *output, int out_len) ;